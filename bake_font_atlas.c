@@ -0,0 +1,183 @@
+/*
+ * Snow-Pi Font Atlas Baker - Build-time glyph rasterizer
+ * Author: /x64/dumped
+ * GitHub: @Ma110w
+ *
+ * Renders every glyph listed in FONT_FACE_DEFS with SDL_ttf, shelf-packs
+ * them into one alpha atlas and writes it out as a C header. Run by the
+ * Makefile before the dashboard is compiled:
+ *
+ *   ./bake-font-atlas font_atlas_data.h
+ */
+
+#include "font_atlas.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ATLAS_WIDTH 512
+#define ATLAS_MAX_HEIGHT 2048
+#define ATLAS_PADDING 1
+#define MAX_GLYPHS (FONT_FACE_COUNT * 96)
+
+static unsigned char atlas_pixels[ATLAS_MAX_HEIGHT][ATLAS_WIDTH];
+static BakedGlyph glyphs[MAX_GLYPHS];
+static BakedFace faces[FONT_FACE_COUNT];
+static int glyph_count = 0;
+
+// Shelf packer state
+static int shelf_x = 0, shelf_y = 0, shelf_h = 0;
+
+static bool pack(int w, int h, int *x, int *y) {
+    if (shelf_x + w > ATLAS_WIDTH) {
+        shelf_y += shelf_h + ATLAS_PADDING;
+        shelf_x = 0;
+        shelf_h = 0;
+    }
+    if (w > ATLAS_WIDTH || shelf_y + h > ATLAS_MAX_HEIGHT) return false;
+    *x = shelf_x;
+    *y = shelf_y;
+    shelf_x += w + ATLAS_PADDING;
+    if (h > shelf_h) shelf_h = h;
+    return true;
+}
+
+// Start each face on a fresh shelf so rows hold similar heights
+static void new_shelf(void) {
+    if (shelf_x == 0) return;
+    shelf_y += shelf_h + ATLAS_PADDING;
+    shelf_x = 0;
+    shelf_h = 0;
+}
+
+static bool bake_glyph(TTF_Font *font, int face, unsigned char ch) {
+    int advance;
+    if (!TTF_GetGlyphMetrics(font, ch, NULL, NULL, NULL, NULL, &advance)) return true;  // Not in font
+
+    BakedGlyph *g = &glyphs[glyph_count];
+    memset(g, 0, sizeof(*g));
+    g->advance = (short)advance;
+    g->face = (unsigned char)face;
+    g->codepoint = ch;
+
+    // Blank glyphs (space) render nothing but still need their advance
+    SDL_Color white = {255, 255, 255, 255};
+    SDL_Surface *rendered = TTF_RenderGlyph_Blended(font, ch, white);
+    if (!rendered) {
+        glyph_count++;
+        return true;
+    }
+    SDL_Surface *surface = SDL_ConvertSurface(rendered, SDL_PIXELFORMAT_ARGB8888);
+    SDL_DestroySurface(rendered);
+    if (!surface) return false;
+
+    int x, y;
+    if (!pack(surface->w, surface->h, &x, &y)) {
+        SDL_DestroySurface(surface);
+        fprintf(stderr, "Atlas full at face %d glyph '%c'\n", face, ch);
+        return false;
+    }
+
+    // Keep coverage only; color comes from the vertices at draw time
+    for (int row = 0; row < surface->h; row++) {
+        const Uint32 *src = (const Uint32 *)((const Uint8 *)surface->pixels + row * surface->pitch);
+        for (int col = 0; col < surface->w; col++) {
+            atlas_pixels[y + row][x + col] = (unsigned char)(src[col] >> 24);
+        }
+    }
+
+    g->x = (unsigned short)x;
+    g->y = (unsigned short)y;
+    g->w = (unsigned short)surface->w;
+    g->h = (unsigned short)surface->h;
+    glyph_count++;
+
+    SDL_DestroySurface(surface);
+    return true;
+}
+
+static bool write_header(const char *path) {
+    FILE *out = fopen(path, "w");
+    if (!out) {
+        fprintf(stderr, "Cannot write %s\n", path);
+        return false;
+    }
+
+    int height = shelf_y + shelf_h;
+    fprintf(out, "// Generated by bake_font_atlas from FONT_FACE_DEFS - do not edit\n\n");
+    fprintf(out, "#define FONT_ATLAS_BAKED_WIDTH %d\n", ATLAS_WIDTH);
+    fprintf(out, "#define FONT_ATLAS_BAKED_HEIGHT %d\n\n", height);
+
+    fprintf(out, "static const BakedFace FONT_ATLAS_BAKED_FACES[%d] = {\n", FONT_FACE_COUNT);
+    for (int f = 0; f < FONT_FACE_COUNT; f++) {
+        fprintf(out, "    {%d, %d, %d},\n", faces[f].height, faces[f].first_glyph, faces[f].glyph_count);
+    }
+    fprintf(out, "};\n\n");
+
+    fprintf(out, "static const BakedGlyph FONT_ATLAS_BAKED_GLYPHS[%d] = {\n", glyph_count);
+    for (int i = 0; i < glyph_count; i++) {
+        const BakedGlyph *g = &glyphs[i];
+        fprintf(out, "    {%u, %u, %u, %u, %d, %u, %u},\n", g->x, g->y, g->w, g->h, g->advance, g->face, g->codepoint);
+    }
+    fprintf(out, "};\n\n");
+
+    fprintf(out, "static const unsigned char FONT_ATLAS_BAKED_PIXELS[%d] = {\n", ATLAS_WIDTH * height);
+    for (int row = 0; row < height; row++) {
+        for (int col = 0; col < ATLAS_WIDTH; col += 32) {
+            fprintf(out, "   ");
+            for (int i = 0; i < 32; i++) fprintf(out, " %u,", atlas_pixels[row][col + i]);
+            fprintf(out, "\n");
+        }
+    }
+    fprintf(out, "};\n");
+
+    bool ok = fclose(out) == 0;
+    printf("Baked %d glyphs into a %dx%d atlas (%d KB)\n", glyph_count, ATLAS_WIDTH, height,
+           ATLAS_WIDTH * height / 1024);
+    return ok;
+}
+
+int main(int argc, char *argv[]) {
+    const char *out_path = argc > 1 ? argv[1] : "font_atlas_data.h";
+
+    if (!TTF_Init()) {
+        fprintf(stderr, "TTF init failed: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    for (int f = 0; f < FONT_FACE_COUNT; f++) {
+        const FontFaceDef *def = &FONT_FACE_DEFS[f];
+        TTF_Font *font = TTF_OpenFont(def->file, def->size);
+        if (!font) {
+            fprintf(stderr, "Cannot open %s: %s\n", def->file, SDL_GetError());
+            TTF_Quit();
+            return 1;
+        }
+
+        faces[f].height = (short)TTF_GetFontHeight(font);
+        faces[f].first_glyph = (short)glyph_count;
+
+        new_shelf();
+
+        bool ok = true;
+        if (def->charset) {
+            for (const char *c = def->charset; *c && ok; c++) {
+                ok = bake_glyph(font, f, (unsigned char)*c);
+            }
+        } else {
+            for (int c = 32; c < 127 && ok; c++) {
+                ok = bake_glyph(font, f, (unsigned char)c);
+            }
+        }
+        faces[f].glyph_count = (short)(glyph_count - faces[f].first_glyph);
+        TTF_CloseFont(font);
+
+        if (!ok) {
+            TTF_Quit();
+            return 1;
+        }
+    }
+
+    TTF_Quit();
+    return write_header(out_path) ? 0 : 1;
+}
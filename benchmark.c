@@ -0,0 +1,225 @@
+/*
+ * Snow-Pi Benchmarks
+ * Author: /x64/dumped
+ * GitHub: @Ma110w
+ *
+ * Headless timing of per-tick hot paths and of whole frames on an offscreen
+ * window. Run with: ./snow-pi-dash --bench (or make bench)
+ */
+
+#include <SDL3/SDL.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "benchmark.h"
+#include "sensor_filter.h"
+#include "frame_memory.h"
+#include "quality_governor.h"
+#include "metrics.h"
+#include "trail_index.h"
+#include "track_store.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define BENCH_TICKS 200000
+#define BENCH_WARMUP_FRAMES 300   // Lets SDL's command and vertex buffers reach full size
+#define BENCH_FRAMES 300
+#define BENCH_TRAIL_QUERIES 100000
+#define BENCH_TRACK_LAT 46.88
+#define BENCH_TRACK_STEP_M 10.0
+#define BENCH_TRACK_OUT_FIXES 2000    // 20 km out at 10 m per fix
+#define BENCH_TRACK_ZIGZAG_FIXES 20000
+
+static double elapsed_us(Uint64 start) {
+    return (double)(SDL_GetPerformanceCounter() - start) * 1000000.0 / (double)SDL_GetPerformanceFrequency();
+}
+
+// Whole filter bank, every channel, one sample tick per iteration
+static void bench_sensor_filter(void) {
+    static SensorFilterBank bank;
+    sensor_filter_init(&bank, SENSOR_FILTER_TABLE, SENSOR_FILTER_TABLE_SIZE);
+
+    // Pre-generate noisy samples so rand() isn't part of the measurement
+    static float samples[256][SENSOR_CHANNEL_COUNT];
+    for (int i = 0; i < 256; i++) {
+        for (int ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++) {
+            samples[i][ch] = 100.0f + (rand() % 100) / 10.0f;
+        }
+    }
+
+    float sink = 0.0f;
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (int i = 0; i < BENCH_TICKS; i++) {
+        sensor_filter_process(&bank, samples[i & 255]);
+        sink += bank.out[i % SENSOR_CHANNEL_COUNT];
+    }
+    double us = elapsed_us(start);
+
+    printf("  sensor filter bank: %.3f us/tick (%d channels, %d ticks, checksum %.0f)\n",
+           us / BENCH_TICKS, SENSOR_CHANNEL_COUNT, BENCH_TICKS, sink);
+}
+
+// Synthetic closed-hood ride: hot and throttled, then cooled with fast frames.
+// The governor must step down under pressure and recover with headroom.
+static bool bench_quality_governor(void) {
+    QualityGovernor gov;
+    quality_governor_init(&gov, 33.0f, QUALITY_HIGH);
+    const ThermalReading hot = {82.0f, 1000000, 1400000};
+    const ThermalReading cool = {55.0f, 1400000, 1400000};
+
+    // Three seconds hot at 30 fps: one step per second of pressure
+    for (int i = 0; i < 90; i++) {
+        quality_governor_update(&gov, 20.0f, &hot, 33);
+    }
+    QualityLevel hot_level = gov.level;
+
+    // Twenty-five seconds cool with light frames: one step per ten seconds
+    for (int i = 0; i < 750; i++) {
+        quality_governor_update(&gov, 12.0f, &cool, 33);
+    }
+    QualityLevel cool_level = gov.level;
+
+    printf("  quality governor: hot -> %s, cooled -> %s (%u changes)\n", QUALITY_PROFILES[hot_level].name,
+           QUALITY_PROFILES[cool_level].name, gov.changes);
+    if (hot_level != QUALITY_LOW || cool_level != QUALITY_HIGH) {
+        fprintf(stderr, "FAIL: quality governor did not step down and recover\n");
+        return false;
+    }
+    return true;
+}
+
+// Full frames after warm-up must not reach the allocator
+static bool bench_frames(BenchFrameFn frame, void *user) {
+    for (int i = 0; i < BENCH_WARMUP_FRAMES; i++) {
+        frame(user, i);
+    }
+
+    uint64_t allocs_before = alloc_counter_total();
+    uint64_t dropped_before = dash_metrics.draw_dropped;
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (int i = 0; i < BENCH_FRAMES; i++) {
+        frame(user, BENCH_WARMUP_FRAMES + i);
+    }
+    double us = elapsed_us(start);
+    uint64_t allocs = alloc_counter_total() - allocs_before;
+    uint64_t dropped = dash_metrics.draw_dropped - dropped_before;
+
+    printf("  dashboard frame: %.1f us/frame (%d frames), %llu heap allocations\n",
+           us / BENCH_FRAMES, BENCH_FRAMES, (unsigned long long)allocs);
+    if (allocs > 0) {
+        fprintf(stderr, "FAIL: steady-state frames allocated %llu times\n", (unsigned long long)allocs);
+        return false;
+    }
+    if (dropped > 0) {
+        fprintf(stderr, "FAIL: draw lists dropped %llu primitives\n", (unsigned long long)dropped);
+        return false;
+    }
+    return true;
+}
+
+// Snap and geofence queries spread over the index bounds (skipped without trails.idx)
+static void bench_trail_index(void) {
+    TrailIndex index;
+    if (!trail_index_open(&index, TRAIL_INDEX_PATH)) {
+        printf("  trail index: %s not found, skipped\n", TRAIL_INDEX_PATH);
+        return;
+    }
+    const TrailIndexHeader *h = index.header;
+    double span_lat = h->grid_h * h->cell_lat_deg;
+    double span_lon = h->grid_w * h->cell_lon_deg;
+    uint32_t seed = 1;
+    int snapped = 0, restricted = 0;
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (int i = 0; i < BENCH_TRAIL_QUERIES; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        double lat = h->origin_lat + span_lat * ((seed >> 8) / 16777216.0);
+        seed = seed * 1664525u + 1013904223u;
+        double lon = h->origin_lon + span_lon * ((seed >> 8) / 16777216.0);
+        TrailSnap snap;
+        snapped += trail_index_snap(&index, lat, lon, TRAIL_SNAP_MAX_M, &snap);
+        restricted += trail_index_area_at(&index, lat, lon) != TRAIL_AREA_NONE;
+    }
+    double us = elapsed_us(start);
+    printf("  trail index: %.3f us/query (%u segments, %u areas, %d snapped, %d restricted)\n",
+           us / BENCH_TRAIL_QUERIES, h->segment_count, h->area_count, snapped, restricted);
+    trail_index_close(&index);
+}
+
+static uint32_t bench_track_x(double longitude) {
+    return (uint32_t)((longitude + 180.0) / 360.0 * 4294967296.0);
+}
+
+// Every level must still reach the far end of the ride and come back
+static bool bench_track_reaches(const TrackStore *track, double far_lon, const char *ride) {
+    uint32_t far_x = bench_track_x(far_lon);
+    uint32_t home_x = bench_track_x(0.0);
+    for (int i = 0; i < TRACK_LEVELS; i++) {
+        const TrackLevel *level = &track->levels[i];
+        uint32_t max_x = 0;
+        for (uint32_t j = 0; j < level->count; j++) {
+            if (level->points[j].x > max_x) max_x = level->points[j].x;
+        }
+        TrackPoint last = level->sleeve.has_pending ? level->sleeve.pending : level->points[level->count - 1];
+        if (max_x + level->tolerance + 1.0 < far_x || last.x > home_x + level->tolerance + 1.0) {
+            fprintf(stderr, "FAIL: %s lost its far end at zoom %d (%u points, reached %.0f m of %.0f m)\n", ride,
+                    level->zoom, level->count, (double)(max_x - home_x) / (far_x - home_x) * BENCH_TRACK_OUT_FIXES *
+                    BENCH_TRACK_STEP_M, BENCH_TRACK_OUT_FIXES * BENCH_TRACK_STEP_M);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Straight out-and-back rides, once short enough to fit every level and
+// once zigzagging out far enough that the finest level has to be thinned
+static bool bench_track_store(void) {
+    static TrackStore track;
+    double lon_step = BENCH_TRACK_STEP_M / (111320.0 * cos(BENCH_TRACK_LAT * M_PI / 180.0));
+    double lat_step = BENCH_TRACK_STEP_M / 2.0 / 111320.0;
+
+    track_store_init(&track);
+    for (int i = 0; i <= 2 * BENCH_TRACK_OUT_FIXES; i++) {
+        int out = i <= BENCH_TRACK_OUT_FIXES ? i : 2 * BENCH_TRACK_OUT_FIXES - i;
+        track_store_push(&track, BENCH_TRACK_LAT, out * lon_step);
+    }
+    if (!bench_track_reaches(&track, BENCH_TRACK_OUT_FIXES * lon_step, "out-and-back")) return false;
+
+    track_store_init(&track);
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (int i = 0; i <= 2 * BENCH_TRACK_ZIGZAG_FIXES; i++) {
+        int out = i <= BENCH_TRACK_ZIGZAG_FIXES ? i : 2 * BENCH_TRACK_ZIGZAG_FIXES - i;
+        double lat = BENCH_TRACK_LAT + (i <= BENCH_TRACK_ZIGZAG_FIXES && (i & 1) ? lat_step : 0.0);
+        track_store_push(&track, lat, out * lon_step);
+    }
+    double us = elapsed_us(start);
+    const TrackLevel *finest = &track.levels[0];
+    printf("  track store: %.3f us/fix, %u points kept of %d (zoom %d tolerance %.1f px)\n",
+           us / (2 * BENCH_TRACK_ZIGZAG_FIXES + 1), track_store_point_count(&track), 2 * BENCH_TRACK_ZIGZAG_FIXES + 1,
+           finest->zoom, finest->tolerance * 256.0 * (double)(1 << finest->zoom) / 4294967296.0);
+    return bench_track_reaches(&track, BENCH_TRACK_ZIGZAG_FIXES * lon_step, "zigzag out-and-back");
+}
+
+// Input-to-present latency collected while the frames ran
+static void bench_latency_report(void) {
+    for (int c = 0; c < LATENCY_CATEGORY_COUNT; c++) {
+        uint64_t count = dash_metrics.latency_count[c];
+        if (count == 0) continue;
+        printf("  %s latency: p50 %.2f ms, p99 %.2f ms, max %.2f ms (%llu samples)\n", LATENCY_CATEGORY_NAMES[c],
+               metrics_latency_percentile((LatencyCategory)c, 0.5) / 1000.0,
+               metrics_latency_percentile((LatencyCategory)c, 0.99) / 1000.0,
+               dash_metrics.latency_max_us[c] / 1000.0, (unsigned long long)count);
+    }
+}
+
+int run_benchmarks(BenchFrameFn frame, void *user) {
+    printf("Snow-Pi benchmarks\n");
+    bench_sensor_filter();
+    if (!bench_quality_governor()) return 1;
+    bench_trail_index();
+    if (!bench_track_store()) return 1;
+    if (frame && !bench_frames(frame, user)) return 1;
+    bench_latency_report();
+    return 0;
+}
@@ -0,0 +1,16 @@
+/*
+ * Snow-Pi Benchmarks Header
+ * Author: /x64/dumped
+ */
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+// Runs one complete dashboard frame; supplied by main so the real render path is measured
+typedef void (*BenchFrameFn)(void *user, int frame);
+
+// Run headless benchmarks, print results, return process exit code.
+// Fails if steady-state frames touch the heap.
+int run_benchmarks(BenchFrameFn frame, void *user);
+
+#endif
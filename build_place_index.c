@@ -0,0 +1,170 @@
+/*
+ * Snow-Pi Place Index Builder - Offline name search sidecar
+ * Author: /x64/dumped
+ * GitHub: @Ma110w
+ *
+ * Pulls every named feature matched by PLACE_RULES out of the vector
+ * tiles and writes an SQLite FTS5 table for place_search.c. Labels repeat
+ * in every tile a feature crosses, so names are deduplicated per ~5 km
+ * cell before they go into the index. Run after replacing the map file:
+ *
+ *   ./build-place-index osm-2020-02-10-v3.11_canada_ontario.mbtiles places.db
+ */
+
+#include "mvt_decode.h"
+#include "place_search.h"
+#include <math.h>
+#include <sqlite3.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PLACE_ZOOM 14              // Every label layer is complete at the top zoom
+#define PLACE_DEDUP_CELLS 20.0     // Cells per degree for deduplication
+
+// Layers searched and how high their names rank; lower comes first
+typedef struct {
+    const char *layer;
+    const char *only_class;        // NULL = every class in the layer
+    int priority;
+} PlaceRule;
+
+static const PlaceRule PLACE_RULES[] = {
+    {"place",               NULL,     0},
+    {"poi",                 "fuel",   1},
+    {"poi",                 "lodging", 1},
+    {"poi",                 NULL,     2},
+    {"transportation_name", "path",   2},
+    {"transportation_name", "track",  2},
+    {"mountain_peak",       NULL,     3},
+    {"water_name",          NULL,     3},
+    {"transportation_name", NULL,     4},
+};
+#define PLACE_RULE_COUNT (int)(sizeof(PLACE_RULES) / sizeof(PLACE_RULES[0]))
+
+static sqlite3 *index_db;
+static sqlite3_stmt *stage_stmt;
+static int tile_zoom, tile_x, tile_y;
+static size_t staged;
+
+static void bytes_to_string(MvtBytes bytes, char *text, size_t size) {
+    size_t len = bytes.len < size - 1 ? bytes.len : size - 1;
+    memcpy(text, bytes.data, len);
+    text[len] = '\0';
+}
+
+static void on_feature(void *user, const MvtLayer *layer, const MvtFeature *feature) {
+    (void)user;
+    MvtValue name, cls = {0};
+    if (feature->point_count == 0 || !mvt_feature_tag(layer, feature, "name", &name) || !name.is_string ||
+        name.str.len == 0) {
+        return;
+    }
+    bool has_class = mvt_feature_tag(layer, feature, "class", &cls) && cls.is_string;
+
+    const PlaceRule *rule = NULL;
+    for (int i = 0; i < PLACE_RULE_COUNT && !rule; i++) {
+        if (!mvt_bytes_equal(layer->name, PLACE_RULES[i].layer)) continue;
+        if (PLACE_RULES[i].only_class && !(has_class && mvt_bytes_equal(cls.str, PLACE_RULES[i].only_class))) continue;
+        rule = &PLACE_RULES[i];
+    }
+    if (!rule) return;
+
+    // Points use their position; lines use their middle vertex
+    const MvtPoint *pt = &feature->points[feature->type == MVT_LINESTRING ? feature->point_count / 2 : 0];
+    double lat, lon;
+    mvt_tile_to_latlon(tile_zoom, tile_x, tile_y, layer->extent, pt->x, pt->y, &lat, &lon);
+
+    char name_text[PLACE_NAME_MAX], kind_text[24];
+    bytes_to_string(name.str, name_text, sizeof(name_text));
+    if (has_class) bytes_to_string(cls.str, kind_text, sizeof(kind_text));
+    else bytes_to_string(layer->name, kind_text, sizeof(kind_text));
+
+    sqlite3_bind_text(stage_stmt, 1, name_text, -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stage_stmt, 2, kind_text, -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int64(stage_stmt, 3, (sqlite3_int64)floor(lat * PLACE_DEDUP_CELLS) * 100000 +
+                                      (sqlite3_int64)floor(lon * PLACE_DEDUP_CELLS));
+    sqlite3_bind_double(stage_stmt, 4, lat);
+    sqlite3_bind_double(stage_stmt, 5, lon);
+    sqlite3_bind_int(stage_stmt, 6, rule->priority);
+    if (sqlite3_step(stage_stmt) == SQLITE_DONE && sqlite3_changes(index_db) > 0) staged++;
+    sqlite3_reset(stage_stmt);
+}
+
+static bool exec(sqlite3 *db, const char *sql) {
+    char *err = NULL;
+    if (sqlite3_exec(db, sql, NULL, NULL, &err) != SQLITE_OK) {
+        fprintf(stderr, "%s\n  in: %s\n", err ? err : "error", sql);
+        sqlite3_free(err);
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s <map.mbtiles> <places.db>\n", argv[0]);
+        return 1;
+    }
+
+    sqlite3 *src;
+    if (sqlite3_open_v2(argv[1], &src, SQLITE_OPEN_READONLY, NULL) != SQLITE_OK) {
+        fprintf(stderr, "Cannot open %s: %s\n", argv[1], sqlite3_errmsg(src));
+        return 1;
+    }
+    remove(argv[2]);
+    if (sqlite3_open(argv[2], &index_db) != SQLITE_OK) {
+        fprintf(stderr, "Cannot create %s: %s\n", argv[2], sqlite3_errmsg(index_db));
+        return 1;
+    }
+
+    // Stage with deduplication, then copy into FTS in priority order so
+    // rowid order is relevance order at query time
+    if (!exec(index_db, "PRAGMA journal_mode=OFF; PRAGMA synchronous=OFF; BEGIN;"
+                   "CREATE TEMP TABLE staging(name TEXT, kind TEXT, cell INTEGER, lat REAL, lon REAL, "
+                   "priority INTEGER, PRIMARY KEY(name, kind, cell)) WITHOUT ROWID;")) {
+        return 1;
+    }
+    if (sqlite3_prepare_v2(index_db, "INSERT OR IGNORE INTO staging VALUES (?1, ?2, ?3, ?4, ?5, ?6)", -1,
+                           &stage_stmt, NULL) != SQLITE_OK) {
+        fprintf(stderr, "%s\n", sqlite3_errmsg(index_db));
+        return 1;
+    }
+
+    sqlite3_stmt *tiles;
+    if (sqlite3_prepare_v2(src, "SELECT tile_column, tile_row, tile_data FROM tiles WHERE zoom_level = ?",
+                           -1, &tiles, NULL) != SQLITE_OK) {
+        fprintf(stderr, "Not an MBTiles file: %s\n", sqlite3_errmsg(src));
+        return 1;
+    }
+    sqlite3_bind_int(tiles, 1, PLACE_ZOOM);
+    tile_zoom = PLACE_ZOOM;
+    size_t count = 0, bad = 0;
+    while (sqlite3_step(tiles) == SQLITE_ROW) {
+        tile_x = sqlite3_column_int(tiles, 0);
+        tile_y = (1 << PLACE_ZOOM) - 1 - sqlite3_column_int(tiles, 1);  // MBTiles rows are TMS (y up)
+        uint8_t *tile = NULL;
+        size_t len = 0;
+        if (!mvt_inflate(sqlite3_column_blob(tiles, 2), (size_t)sqlite3_column_bytes(tiles, 2), &tile, &len) ||
+            !mvt_decode(tile, len, on_feature, NULL)) {
+            bad++;
+        }
+        free(tile);
+        if (++count % 10000 == 0) printf("  %zu tiles, %zu names\n", count, staged);
+    }
+    sqlite3_finalize(tiles);
+    sqlite3_finalize(stage_stmt);
+    sqlite3_close(src);
+    printf("Read %zu tiles at zoom %d (%zu unreadable), %zu unique names\n", count, PLACE_ZOOM, bad, staged);
+
+    bool ok = exec(index_db, "CREATE VIRTUAL TABLE places USING fts5(name, kind UNINDEXED, lat UNINDEXED, lon UNINDEXED, "
+                        "tokenize = 'unicode61 remove_diacritics 2', prefix = '1 2 3');"
+                        "INSERT INTO places(name, kind, lat, lon) "
+                        "SELECT name, kind, lat, lon FROM staging ORDER BY priority, length(name), name;"
+                        "INSERT INTO places(places) VALUES('optimize');"
+                        "DROP TABLE staging; COMMIT;") &&
+              exec(index_db, "VACUUM;");
+    sqlite3_close(index_db);
+    if (ok) printf("Wrote %s\n", argv[2]);
+    return ok ? 0 : 1;
+}
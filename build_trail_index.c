@@ -0,0 +1,598 @@
+/*
+ * Snow-Pi Trail Index Builder - Offline trail and geofence extraction
+ * Author: /x64/dumped
+ * GitHub: @Ma110w
+ *
+ * Walks every vector tile of one zoom level in the MBTiles file, keeps
+ * the features matched by TRAIL_RULES and packs them into the grid index
+ * read by trail_index.c. Trail segment ends also become a routing graph,
+ * with fuel stations attached to their nearest trail node, for the
+ * fuel range search. Run after replacing the map file:
+ *
+ *   ./build-trail-index osm-2020-02-10-v3.11_canada_ontario.mbtiles trails.idx
+ */
+
+#include "mvt_decode.h"
+#include "trail_index.h"
+#include <math.h>
+#include <sqlite3.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define TRAIL_ZOOM 14               // Paths and tracks are only complete at the top zoom
+#define TRAIL_CELL_M 1000.0         // Grid cell edge
+#define TRAIL_NODE_SNAP_DEG 1e-6    // Segment ends closer than this are one node (~0.1 m)
+#define TRAIL_JOIN_M 100.0          // Clipped ends this close to another node are joined to it
+#define TRAIL_FUEL_ACCESS_M 1500.0  // Stations farther than this from every trail are left out
+
+typedef enum {
+    RULE_TRAIL,
+    RULE_AREA,
+    RULE_FUEL
+} RuleTarget;
+
+// Which features become trails and which become no-go areas
+typedef struct {
+    const char *layer;
+    const char *key;
+    const char *value;
+    RuleTarget target;
+    TrailAreaKind kind;
+} TrailRule;
+
+static const TrailRule TRAIL_RULES[] = {
+    {"transportation", "class", "path",           RULE_TRAIL, TRAIL_AREA_NONE},
+    {"transportation", "class", "track",          RULE_TRAIL, TRAIL_AREA_NONE},
+    {"landuse",        "class", "military",       RULE_AREA,  TRAIL_AREA_MILITARY},
+    {"aeroway",        "class", "aerodrome",      RULE_AREA,  TRAIL_AREA_AIRFIELD},
+    {"aeroway",        "class", "runway",         RULE_AREA,  TRAIL_AREA_AIRFIELD},
+    {"park",           "class", "nature_reserve", RULE_AREA,  TRAIL_AREA_NATURE_RESERVE},
+    {"poi",            "class", "fuel",           RULE_FUEL,  TRAIL_AREA_NONE},
+};
+#define TRAIL_RULE_COUNT (int)(sizeof(TRAIL_RULES) / sizeof(TRAIL_RULES[0]))
+
+// Geometry gathered in absolute degrees until the grid origin is known
+typedef struct {
+    double x0, y0, x1, y1;
+    bool clipped0, clipped1;        // End cut off at the tile's buffer edge
+} BuildSegment;
+
+typedef struct {
+    double x, y;
+} BuildVertex;
+
+typedef struct {
+    uint32_t first_vertex;
+    uint32_t vertex_count;
+    double min_x, min_y, max_x, max_y;
+    TrailAreaKind kind;
+} BuildArea;
+
+static BuildSegment *segments;
+static size_t segment_count, segment_cap;
+static BuildArea *areas;
+static size_t area_count, area_cap;
+static BuildVertex *vertices;
+static size_t vertex_count, vertex_cap;
+static BuildVertex *stations;
+static size_t station_count, station_cap;
+static double min_lon = 1e9, min_lat = 1e9, max_lon = -1e9, max_lat = -1e9;
+
+// Tile being decoded, for the feature callback
+static int tile_zoom, tile_x, tile_y;
+
+static void *grow(void *array, size_t *cap, size_t needed, size_t elem) {
+    if (needed <= *cap) return array;
+    size_t new_cap = *cap ? *cap * 2 : 4096;
+    while (new_cap < needed) new_cap *= 2;
+    void *p = realloc(array, new_cap * elem);
+    if (!p) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    *cap = new_cap;
+    return p;
+}
+
+static void extend_bounds(double lon, double lat) {
+    if (lon < min_lon) min_lon = lon;
+    if (lon > max_lon) max_lon = lon;
+    if (lat < min_lat) min_lat = lat;
+    if (lat > max_lat) max_lat = lat;
+}
+
+static bool outside_tile(const MvtLayer *layer, const MvtPoint *pt) {
+    return pt->x < 0 || pt->y < 0 || pt->x > (int32_t)layer->extent || pt->y > (int32_t)layer->extent;
+}
+
+static const TrailRule *match_rule(const MvtLayer *layer, const MvtFeature *feature) {
+    for (int i = 0; i < TRAIL_RULE_COUNT; i++) {
+        const TrailRule *rule = &TRAIL_RULES[i];
+        MvtValue value;
+        if (mvt_bytes_equal(layer->name, rule->layer) && mvt_feature_tag(layer, feature, rule->key, &value) &&
+            value.is_string && mvt_bytes_equal(value.str, rule->value)) {
+            return rule;
+        }
+    }
+    return NULL;
+}
+
+static void on_feature(void *user, const MvtLayer *layer, const MvtFeature *feature) {
+    (void)user;
+    const TrailRule *rule = match_rule(layer, feature);
+    if (!rule) return;
+
+    if (rule->target == RULE_TRAIL && feature->type == MVT_LINESTRING) {
+        for (int p = 0; p < feature->part_count; p++) {
+            double prev_lat = 0, prev_lon = 0;
+            int first = feature->part_start[p], last = feature->part_start[p + 1] - 1;
+            for (int i = first; i <= last; i++) {
+                double lat, lon;
+                mvt_tile_to_latlon(tile_zoom, tile_x, tile_y, layer->extent, feature->points[i].x,
+                                   feature->points[i].y, &lat, &lon);
+                extend_bounds(lon, lat);
+                if (i > first) {
+                    segments = grow(segments, &segment_cap, segment_count + 1, sizeof(BuildSegment));
+                    segments[segment_count++] = (BuildSegment){prev_lon, prev_lat, lon, lat,
+                                                               i - 1 == first && outside_tile(layer, &feature->points[i - 1]),
+                                                               i == last && outside_tile(layer, &feature->points[i])};
+                }
+                prev_lat = lat;
+                prev_lon = lon;
+            }
+        }
+    } else if (rule->target == RULE_AREA && feature->type == MVT_POLYGON && feature->point_count >= 3) {
+        // All rings of the feature form one area, so holes stay holes
+        BuildArea area = {(uint32_t)vertex_count, 0, 1e9, 1e9, -1e9, -1e9, rule->kind};
+        size_t needed = vertex_count + (size_t)feature->point_count + (size_t)feature->part_count;
+        vertices = grow(vertices, &vertex_cap, needed, sizeof(BuildVertex));
+        for (int p = 0; p < feature->part_count; p++) {
+            if (p > 0) vertices[vertex_count++] = (BuildVertex){NAN, NAN};
+            for (int i = feature->part_start[p]; i < feature->part_start[p + 1]; i++) {
+                double lat, lon;
+                mvt_tile_to_latlon(tile_zoom, tile_x, tile_y, layer->extent, feature->points[i].x,
+                                   feature->points[i].y, &lat, &lon);
+                extend_bounds(lon, lat);
+                if (lon < area.min_x) area.min_x = lon;
+                if (lon > area.max_x) area.max_x = lon;
+                if (lat < area.min_y) area.min_y = lat;
+                if (lat > area.max_y) area.max_y = lat;
+                vertices[vertex_count++] = (BuildVertex){lon, lat};
+            }
+        }
+        area.vertex_count = (uint32_t)(vertex_count - area.first_vertex);
+        areas = grow(areas, &area_cap, area_count + 1, sizeof(BuildArea));
+        areas[area_count++] = area;
+    } else if (rule->target == RULE_FUEL && feature->type == MVT_POINT && feature->point_count > 0) {
+        double lat, lon;
+        mvt_tile_to_latlon(tile_zoom, tile_x, tile_y, layer->extent, feature->points[0].x, feature->points[0].y,
+                           &lat, &lon);
+        stations = grow(stations, &station_cap, station_count + 1, sizeof(BuildVertex));
+        stations[station_count++] = (BuildVertex){lon, lat};
+    }
+}
+
+// Cell range covered by a bounding box, clamped to the grid
+typedef struct {
+    double origin_lat, origin_lon, cell_lat, cell_lon;
+    uint32_t w, h;
+} Grid;
+
+static void cell_range(const Grid *g, double x0, double y0, double x1, double y1, uint32_t r[4]) {
+    double cx0 = floor((fmin(x0, x1) - g->origin_lon) / g->cell_lon);
+    double cx1 = floor((fmax(x0, x1) - g->origin_lon) / g->cell_lon);
+    double cy0 = floor((fmin(y0, y1) - g->origin_lat) / g->cell_lat);
+    double cy1 = floor((fmax(y0, y1) - g->origin_lat) / g->cell_lat);
+    r[0] = (uint32_t)fmax(0, fmin(cx0, g->w - 1));
+    r[1] = (uint32_t)fmax(0, fmin(cx1, g->w - 1));
+    r[2] = (uint32_t)fmax(0, fmin(cy0, g->h - 1));
+    r[3] = (uint32_t)fmax(0, fmin(cy1, g->h - 1));
+}
+
+// CSR cell table: count refs per cell, prefix-sum, then fill
+static uint32_t *build_cells(const Grid *g, size_t count, bool is_area, uint32_t **refs_out, uint32_t *ref_count) {
+    size_t cells = (size_t)g->w * g->h;
+    uint32_t *starts = calloc(cells + 1, sizeof(uint32_t));
+    uint32_t *cursor = calloc(cells, sizeof(uint32_t));
+    if (!starts || !cursor) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    uint32_t r[4];
+    for (int pass = 0; pass < 2; pass++) {
+        for (size_t i = 0; i < count; i++) {
+            if (is_area) {
+                cell_range(g, areas[i].min_x, areas[i].min_y, areas[i].max_x, areas[i].max_y, r);
+            } else {
+                cell_range(g, segments[i].x0, segments[i].y0, segments[i].x1, segments[i].y1, r);
+            }
+            for (uint32_t y = r[2]; y <= r[3]; y++) {
+                for (uint32_t x = r[0]; x <= r[1]; x++) {
+                    size_t cell = (size_t)y * g->w + x;
+                    if (pass == 0) {
+                        starts[cell + 1]++;
+                    } else {
+                        (*refs_out)[starts[cell] + cursor[cell]++] = (uint32_t)i;
+                    }
+                }
+            }
+        }
+        if (pass == 0) {
+            for (size_t c = 0; c < cells; c++) starts[c + 1] += starts[c];
+            *ref_count = starts[cells];
+            *refs_out = malloc(((size_t)*ref_count + 1) * sizeof(uint32_t));
+            if (!*refs_out) {
+                fprintf(stderr, "Out of memory\n");
+                exit(1);
+            }
+        }
+    }
+    free(cursor);
+    return starts;
+}
+
+// Routing graph: segment ends merged into nodes, both directions of each
+// segment as edges, then packed as CSR for the runtime
+typedef struct {
+    int64_t qx, qy;
+    uint32_t node;                  // UINT32_MAX = free slot
+} NodeSlot;
+
+typedef struct {
+    uint32_t from, to;
+    float length_m;
+} BuildEdge;
+
+static BuildVertex *nodes;
+static size_t node_count, node_cap;
+static NodeSlot *node_table;
+static size_t node_mask;
+static BuildEdge *edges;
+static size_t edge_count, edge_cap;
+
+static double distance_m(double lon0, double lat0, double lon1, double lat1) {
+    double kx = 111320.0 * cos((lat0 + lat1) * 0.5 * M_PI / 180.0);
+    return hypot((lon1 - lon0) * kx, (lat1 - lat0) * 111320.0);
+}
+
+static uint32_t node_at(double lon, double lat) {
+    int64_t qx = llround(lon / TRAIL_NODE_SNAP_DEG), qy = llround(lat / TRAIL_NODE_SNAP_DEG);
+    size_t h = (size_t)(((uint64_t)qx * 0x9E3779B97F4A7C15ull) ^ ((uint64_t)qy * 0xC2B2AE3D27D4EB4Full)) & node_mask;
+    while (node_table[h].node != UINT32_MAX) {
+        if (node_table[h].qx == qx && node_table[h].qy == qy) return node_table[h].node;
+        h = (h + 1) & node_mask;
+    }
+    nodes = grow(nodes, &node_cap, node_count + 1, sizeof(BuildVertex));
+    nodes[node_count] = (BuildVertex){lon, lat};
+    node_table[h] = (NodeSlot){qx, qy, (uint32_t)node_count};
+    return (uint32_t)node_count++;
+}
+
+static void add_edge(uint32_t from, uint32_t to, double length_m) {
+    edges = grow(edges, &edge_cap, edge_count + 2, sizeof(BuildEdge));
+    edges[edge_count++] = (BuildEdge){from, to, (float)length_m};
+    edges[edge_count++] = (BuildEdge){to, from, (float)length_m};
+}
+
+static uint32_t grid_cell(const Grid *g, double lon, double lat, uint32_t *cx, uint32_t *cy) {
+    *cx = (uint32_t)fmax(0, fmin(floor((lon - g->origin_lon) / g->cell_lon), g->w - 1));
+    *cy = (uint32_t)fmax(0, fmin(floor((lat - g->origin_lat) / g->cell_lat), g->h - 1));
+    return *cy * g->w + *cx;
+}
+
+// Nodes bucketed by grid cell (CSR), for the nearest-node searches below
+static uint32_t *bucket_nodes(const Grid *g, uint32_t **refs_out) {
+    size_t cells = (size_t)g->w * g->h;
+    uint32_t *starts = calloc(cells + 1, sizeof(uint32_t));
+    uint32_t *refs = malloc((node_count + 1) * sizeof(uint32_t));
+    if (!starts || !refs) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    uint32_t cx, cy;
+    for (size_t i = 0; i < node_count; i++) starts[grid_cell(g, nodes[i].x, nodes[i].y, &cx, &cy) + 1]++;
+    for (size_t c = 0; c < cells; c++) starts[c + 1] += starts[c];
+    for (size_t i = 0; i < node_count; i++) {
+        uint32_t cell = grid_cell(g, nodes[i].x, nodes[i].y, &cx, &cy);
+        refs[starts[cell]++] = (uint32_t)i;
+    }
+    // Filling advanced every start by one cell; shift back
+    for (size_t c = cells; c > 0; c--) starts[c] = starts[c - 1];
+    starts[0] = 0;
+    *refs_out = refs;
+    return starts;
+}
+
+// Closest node to (lon, lat) within max_m, other than skip; UINT32_MAX if none
+static uint32_t nearest_node(const Grid *g, const uint32_t *cells, const uint32_t *refs, double lon, double lat,
+                             double max_m, uint32_t skip, double *found_m) {
+    uint32_t cx, cy;
+    grid_cell(g, lon, lat, &cx, &cy);
+    int r = (int)ceil(max_m / TRAIL_CELL_M);
+    uint32_t best = UINT32_MAX;
+    double best_m = max_m;
+    for (int y = (int)cy - r; y <= (int)cy + r; y++) {
+        if (y < 0 || y >= (int)g->h) continue;
+        for (int x = (int)cx - r; x <= (int)cx + r; x++) {
+            if (x < 0 || x >= (int)g->w) continue;
+            uint32_t cell = (uint32_t)y * g->w + (uint32_t)x;
+            for (uint32_t i = cells[cell]; i < cells[cell + 1]; i++) {
+                uint32_t n = refs[i];
+                double d = distance_m(lon, lat, nodes[n].x, nodes[n].y);
+                if (n != skip && d <= best_m) {
+                    best = n;
+                    best_m = d;
+                }
+            }
+        }
+    }
+    *found_m = best_m;
+    return best;
+}
+
+static int station_compare(const void *a, const void *b) {
+    const BuildVertex *sa = a, *sb = b;
+    if (sa->x != sb->x) return sa->x < sb->x ? -1 : 1;
+    return (sa->y > sb->y) - (sa->y < sb->y);
+}
+
+// Fills the graph sections; returns false when out of memory
+static bool build_graph(const Grid *g, TrailIndexHeader *header, TrailVertex **packed_nodes, uint32_t **node_edges,
+                        TrailEdge **packed_edges, TrailSegmentNodes **segment_nodes, TrailFuel **fuel) {
+    size_t table_size = 1024;
+    while (table_size < segment_count * 4) table_size *= 2;
+    node_table = malloc(table_size * sizeof(NodeSlot));
+    *segment_nodes = malloc((segment_count + 1) * sizeof(TrailSegmentNodes));
+    if (!node_table || !*segment_nodes) return false;
+    memset(node_table, 0xFF, table_size * sizeof(NodeSlot));
+    node_mask = table_size - 1;
+
+    for (size_t i = 0; i < segment_count; i++) {
+        const BuildSegment *s = &segments[i];
+        uint32_t a = node_at(s->x0, s->y0), b = node_at(s->x1, s->y1);
+        (*segment_nodes)[i] = (TrailSegmentNodes){a, b};
+        if (a != b) add_edge(a, b, distance_m(s->x0, s->y0, s->x1, s->y1));
+    }
+
+    // Tiles clip trails in their buffer past the edge, so the two halves
+    // of a trail crossing a tile edge end up to two buffers apart. Join
+    // such clipped dead ends; real dead ends are left alone.
+    uint32_t *degree = calloc(node_count + 1, sizeof(uint32_t));
+    uint8_t *clipped = calloc(node_count + 1, 1);
+    uint32_t *node_refs;
+    uint32_t *node_cells = bucket_nodes(g, &node_refs);
+    if (!degree || !clipped) return false;
+    for (size_t i = 0; i < edge_count; i++) degree[edges[i].from]++;
+    for (size_t i = 0; i < segment_count; i++) {
+        if (segments[i].clipped0) clipped[(*segment_nodes)[i].from] = 1;
+        if (segments[i].clipped1) clipped[(*segment_nodes)[i].to] = 1;
+    }
+    size_t joins = 0;
+    for (uint32_t n = 0; n < node_count; n++) {
+        if (degree[n] != 1 || !clipped[n]) continue;
+        double d;
+        uint32_t other = nearest_node(g, node_cells, node_refs, nodes[n].x, nodes[n].y, TRAIL_JOIN_M, n, &d);
+        if (other == UINT32_MAX) continue;
+        add_edge(n, other, d);
+        degree[n]++;
+        degree[other]++;
+        joins++;
+    }
+    free(degree);
+    free(clipped);
+
+    // Stations near a tile edge are in both tiles
+    qsort(stations, station_count, sizeof(BuildVertex), station_compare);
+    *fuel = malloc((station_count + 1) * sizeof(TrailFuel));
+    if (!*fuel) return false;
+    uint32_t fuel_count = 0;
+    for (size_t i = 0; i < station_count; i++) {
+        if (i > 0 && fabs(stations[i].x - stations[i - 1].x) < 1e-5 && fabs(stations[i].y - stations[i - 1].y) < 1e-5) {
+            continue;
+        }
+        double d;
+        uint32_t n = nearest_node(g, node_cells, node_refs, stations[i].x, stations[i].y, TRAIL_FUEL_ACCESS_M,
+                                  UINT32_MAX, &d);
+        if (n == UINT32_MAX) continue;
+        (*fuel)[fuel_count++] = (TrailFuel){n, (float)d, (float)(stations[i].x - g->origin_lon),
+                                            (float)(stations[i].y - g->origin_lat)};
+    }
+    free(node_cells);
+    free(node_refs);
+
+    // CSR: count edges per node, prefix-sum, then fill
+    *packed_nodes = malloc((node_count + 1) * sizeof(TrailVertex));
+    *node_edges = calloc(node_count + 1, sizeof(uint32_t));
+    *packed_edges = malloc((edge_count + 1) * sizeof(TrailEdge));
+    uint32_t *cursor = calloc(node_count + 1, sizeof(uint32_t));
+    if (!*packed_nodes || !*node_edges || !*packed_edges || !cursor) return false;
+    for (size_t i = 0; i < node_count; i++) {
+        (*packed_nodes)[i] = (TrailVertex){(float)(nodes[i].x - g->origin_lon), (float)(nodes[i].y - g->origin_lat)};
+    }
+    for (size_t i = 0; i < edge_count; i++) (*node_edges)[edges[i].from + 1]++;
+    for (size_t n = 0; n < node_count; n++) (*node_edges)[n + 1] += (*node_edges)[n];
+    for (size_t i = 0; i < edge_count; i++) {
+        uint32_t from = edges[i].from;
+        (*packed_edges)[(*node_edges)[from] + cursor[from]++] = (TrailEdge){edges[i].to, edges[i].length_m};
+    }
+    free(cursor);
+
+    header->node_count = (uint32_t)node_count;
+    header->edge_count = (uint32_t)edge_count;
+    header->fuel_count = fuel_count;
+    printf("Graph: %zu nodes, %zu edges (%zu clipped ends joined), %u of %zu fuel stations on trails\n", node_count,
+           edge_count, joins, fuel_count, station_count);
+    return true;
+}
+
+// Write one section at an 8-byte boundary and record where it went
+static bool write_section(FILE *out, const void *data, size_t size, uint64_t *offset) {
+    static const uint8_t zeros[8] = {0};
+    long pos = ftell(out);
+    size_t pad = (8 - (size_t)pos % 8) % 8;
+    if (pad && fwrite(zeros, 1, pad, out) != pad) return false;
+    *offset = (uint64_t)pos + pad;
+    return size == 0 || fwrite(data, 1, size, out) == size;
+}
+
+static bool write_index(const char *path) {
+    TrailIndexHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TRAIL_INDEX_MAGIC, sizeof(header.magic));
+    header.version = TRAIL_INDEX_VERSION;
+    header.header_size = sizeof(header);
+
+    if (min_lon > max_lon) {  // Nothing matched; keep a valid empty grid
+        min_lon = max_lon = min_lat = max_lat = 0;
+    }
+    Grid g;
+    g.origin_lat = min_lat;
+    g.origin_lon = min_lon;
+    g.cell_lat = TRAIL_CELL_M / 111320.0;
+    g.cell_lon = TRAIL_CELL_M / (111320.0 * cos((min_lat + max_lat) * 0.5 * M_PI / 180.0));
+    g.w = (uint32_t)floor((max_lon - min_lon) / g.cell_lon) + 1;
+    g.h = (uint32_t)floor((max_lat - min_lat) / g.cell_lat) + 1;
+    header.origin_lat = g.origin_lat;
+    header.origin_lon = g.origin_lon;
+    header.cell_lat_deg = g.cell_lat;
+    header.cell_lon_deg = g.cell_lon;
+    header.grid_w = g.w;
+    header.grid_h = g.h;
+
+    // Relative float coordinates for the runtime
+    TrailSegment *packed_segments = malloc((segment_count + 1) * sizeof(TrailSegment));
+    TrailArea *packed_areas = malloc((area_count + 1) * sizeof(TrailArea));
+    TrailVertex *packed_vertices = malloc((vertex_count + 1) * sizeof(TrailVertex));
+    if (!packed_segments || !packed_areas || !packed_vertices) {
+        fprintf(stderr, "Out of memory\n");
+        return false;
+    }
+    for (size_t i = 0; i < segment_count; i++) {
+        packed_segments[i] = (TrailSegment){(float)(segments[i].x0 - g.origin_lon), (float)(segments[i].y0 - g.origin_lat),
+                                            (float)(segments[i].x1 - g.origin_lon), (float)(segments[i].y1 - g.origin_lat)};
+    }
+    for (size_t i = 0; i < area_count; i++) {
+        packed_areas[i] = (TrailArea){areas[i].first_vertex, areas[i].vertex_count,
+                                      (float)(areas[i].min_x - g.origin_lon), (float)(areas[i].min_y - g.origin_lat),
+                                      (float)(areas[i].max_x - g.origin_lon), (float)(areas[i].max_y - g.origin_lat),
+                                      (uint32_t)areas[i].kind, 0};
+    }
+    for (size_t i = 0; i < vertex_count; i++) {
+        packed_vertices[i] = (TrailVertex){(float)(vertices[i].x - g.origin_lon), (float)(vertices[i].y - g.origin_lat)};
+    }
+
+    uint32_t *segment_refs, *area_refs;
+    uint32_t *segment_cells = build_cells(&g, segment_count, false, &segment_refs, &header.segment_ref_count);
+    uint32_t *area_cells = build_cells(&g, area_count, true, &area_refs, &header.area_ref_count);
+    header.segment_count = (uint32_t)segment_count;
+    header.area_count = (uint32_t)area_count;
+    header.vertex_count = (uint32_t)vertex_count;
+    TrailVertex *packed_nodes = NULL;
+    uint32_t *node_edges = NULL;
+    TrailEdge *packed_edges = NULL;
+    TrailSegmentNodes *segment_nodes = NULL;
+    TrailFuel *fuel = NULL;
+    if (!build_graph(&g, &header, &packed_nodes, &node_edges, &packed_edges, &segment_nodes, &fuel)) {
+        fprintf(stderr, "Out of memory\n");
+        return false;
+    }
+
+    FILE *out = fopen(path, "wb");
+    if (!out) {
+        fprintf(stderr, "Cannot write %s\n", path);
+        return false;
+    }
+    size_t cell_bytes = ((size_t)g.w * g.h + 1) * sizeof(uint32_t);
+    bool ok = fwrite(&header, sizeof(header), 1, out) == 1 &&
+              write_section(out, segment_cells, cell_bytes, &header.segment_cells_offset) &&
+              write_section(out, segment_refs, header.segment_ref_count * sizeof(uint32_t), &header.segment_refs_offset) &&
+              write_section(out, packed_segments, segment_count * sizeof(TrailSegment), &header.segments_offset) &&
+              write_section(out, area_cells, cell_bytes, &header.area_cells_offset) &&
+              write_section(out, area_refs, header.area_ref_count * sizeof(uint32_t), &header.area_refs_offset) &&
+              write_section(out, packed_areas, area_count * sizeof(TrailArea), &header.areas_offset) &&
+              write_section(out, packed_vertices, vertex_count * sizeof(TrailVertex), &header.vertices_offset) &&
+              write_section(out, packed_nodes, node_count * sizeof(TrailVertex), &header.nodes_offset) &&
+              write_section(out, node_edges, (node_count + 1) * sizeof(uint32_t), &header.node_edges_offset) &&
+              write_section(out, packed_edges, edge_count * sizeof(TrailEdge), &header.edges_offset) &&
+              write_section(out, segment_nodes, segment_count * sizeof(TrailSegmentNodes),
+                            &header.segment_nodes_offset) &&
+              write_section(out, fuel, header.fuel_count * sizeof(TrailFuel), &header.fuel_offset);
+    // Offsets are known now; rewrite the header
+    ok = ok && fseek(out, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, out) == 1;
+    ok = fclose(out) == 0 && ok;
+    if (!ok) fprintf(stderr, "Write to %s failed\n", path);
+    else printf("Wrote %s: %ux%u cells, %zu segments, %zu areas, %zu vertices\n", path, g.w, g.h,
+                segment_count, area_count, vertex_count);
+
+    free(segment_cells);
+    free(segment_refs);
+    free(area_cells);
+    free(area_refs);
+    free(packed_segments);
+    free(packed_areas);
+    free(packed_vertices);
+    free(packed_nodes);
+    free(node_edges);
+    free(packed_edges);
+    free(segment_nodes);
+    free(fuel);
+    return ok;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s <map.mbtiles> <trails.idx>\n", argv[0]);
+        return 1;
+    }
+
+    sqlite3 *db;
+    if (sqlite3_open_v2(argv[1], &db, SQLITE_OPEN_READONLY, NULL) != SQLITE_OK) {
+        fprintf(stderr, "Cannot open %s: %s\n", argv[1], sqlite3_errmsg(db));
+        sqlite3_close(db);
+        return 1;
+    }
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, "SELECT tile_column, tile_row, tile_data FROM tiles WHERE zoom_level = ?",
+                           -1, &stmt, NULL) != SQLITE_OK) {
+        fprintf(stderr, "Not an MBTiles file: %s\n", sqlite3_errmsg(db));
+        sqlite3_close(db);
+        return 1;
+    }
+    sqlite3_bind_int(stmt, 1, TRAIL_ZOOM);
+
+    size_t tiles = 0, bad = 0;
+    tile_zoom = TRAIL_ZOOM;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        tile_x = sqlite3_column_int(stmt, 0);
+        tile_y = (1 << TRAIL_ZOOM) - 1 - sqlite3_column_int(stmt, 1);  // MBTiles rows are TMS (y up)
+        uint8_t *tile = NULL;
+        size_t len = 0;
+        if (!mvt_inflate(sqlite3_column_blob(stmt, 2), (size_t)sqlite3_column_bytes(stmt, 2), &tile, &len) ||
+            !mvt_decode(tile, len, on_feature, NULL)) {
+            bad++;
+        }
+        free(tile);
+        if (++tiles % 10000 == 0) {
+            printf("  %zu tiles, %zu segments, %zu areas\n", tiles, segment_count, area_count);
+        }
+    }
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+    printf("Read %zu tiles at zoom %d (%zu unreadable)\n", tiles, TRAIL_ZOOM, bad);
+
+    bool ok = write_index(argv[2]);
+    free(segments);
+    free(areas);
+    free(vertices);
+    free(stations);
+    free(nodes);
+    free(node_table);
+    free(edges);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,295 @@
+/*
+ * Snow-Pi Draw List - Recorded frames for the render pipeline
+ * Author: /x64/dumped
+ * GitHub: @Ma110w
+ *
+ * The gauge screen is thousands of points and lines. Recording them into
+ * fixed buffers instead of calling SDL for each one lets the recording
+ * run on a worker thread, and lets runs of one color go to SDL as a
+ * single SDL_RenderPoints/SDL_RenderFillRects call. Buffers are allocated
+ * once, so recording a frame never allocates.
+ */
+
+#include "draw_list.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "metrics.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+bool draw_list_init(DrawList *list) {
+    memset(list, 0, sizeof(*list));
+    list->cmds = malloc(DRAW_LIST_MAX_COMMANDS * sizeof(DrawCmd));
+    list->points = malloc(DRAW_LIST_MAX_POINTS * sizeof(SDL_FPoint));
+    list->rects = malloc(DRAW_LIST_MAX_RECTS * sizeof(SDL_FRect));
+    list->text = malloc(DRAW_LIST_MAX_TEXT);
+    if (!list->cmds || !list->points || !list->rects || !list->text) {
+        fprintf(stderr, "Cannot allocate draw list\n");
+        draw_list_free(list);
+        return false;
+    }
+    draw_list_reset(list);
+    return true;
+}
+
+void draw_list_reset(DrawList *list) {
+    list->cmd_count = 0;
+    list->point_count = 0;
+    list->rect_count = 0;
+    list->text_used = 0;
+    list->dropped = 0;
+    list->color = (SDL_Color){255, 255, 255, 255};
+}
+
+void draw_list_color(DrawList *list, Uint8 r, Uint8 g, Uint8 b, Uint8 a) {
+    list->color = (SDL_Color){r, g, b, a};
+}
+
+static bool same_color(SDL_Color a, SDL_Color b) {
+    return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
+
+// The command to add count items to: the last one if it is the same kind
+// and color and ends where the items will go, otherwise a new one
+static DrawCmd *draw_list_run(DrawList *list, DrawCmdType type, uint32_t first, bool merge) {
+    if (merge && list->cmd_count > 0) {
+        DrawCmd *last = &list->cmds[list->cmd_count - 1];
+        if (last->type == type && same_color(last->color, list->color) && last->first + last->count == first) {
+            return last;
+        }
+    }
+    if (list->cmd_count == DRAW_LIST_MAX_COMMANDS) return NULL;
+    DrawCmd *cmd = &list->cmds[list->cmd_count++];
+    memset(cmd, 0, sizeof(*cmd));
+    cmd->type = (uint8_t)type;
+    cmd->color = list->color;
+    cmd->first = first;
+    return cmd;
+}
+
+void draw_list_point(DrawList *list, float x, float y) {
+    if (list->point_count == DRAW_LIST_MAX_POINTS) {
+        list->dropped++;
+        return;
+    }
+    DrawCmd *cmd = draw_list_run(list, DRAW_CMD_POINTS, list->point_count, true);
+    if (!cmd) {
+        list->dropped++;
+        return;
+    }
+    list->points[list->point_count++] = (SDL_FPoint){x, y};
+    cmd->count++;
+}
+
+void draw_list_polyline(DrawList *list, const SDL_FPoint *points, int count) {
+    if (count < 2) return;
+    if (list->point_count + (uint32_t)count > DRAW_LIST_MAX_POINTS) {
+        list->dropped++;
+        return;
+    }
+    DrawCmd *cmd = draw_list_run(list, DRAW_CMD_LINES, list->point_count, false);
+    if (!cmd) {
+        list->dropped++;
+        return;
+    }
+    memcpy(&list->points[list->point_count], points, (size_t)count * sizeof(SDL_FPoint));
+    list->point_count += (uint32_t)count;
+    cmd->count = (uint32_t)count;
+}
+
+void draw_list_line(DrawList *list, float x1, float y1, float x2, float y2) {
+    SDL_FPoint points[2] = {{x1, y1}, {x2, y2}};
+    draw_list_polyline(list, points, 2);
+}
+
+static void draw_list_add_rect(DrawList *list, DrawCmdType type, const SDL_FRect *rect) {
+    if (list->rect_count == DRAW_LIST_MAX_RECTS) {
+        list->dropped++;
+        return;
+    }
+    DrawCmd *cmd = draw_list_run(list, type, list->rect_count, true);
+    if (!cmd) {
+        list->dropped++;
+        return;
+    }
+    list->rects[list->rect_count++] = *rect;
+    cmd->count++;
+}
+
+void draw_list_rect(DrawList *list, const SDL_FRect *rect) {
+    draw_list_add_rect(list, DRAW_CMD_RECTS, rect);
+}
+
+void draw_list_fill_rect(DrawList *list, const SDL_FRect *rect) {
+    draw_list_add_rect(list, DRAW_CMD_FILL_RECTS, rect);
+}
+
+void draw_list_text(DrawList *list, FontFace face, const char *text, int x, int y, SDL_Color color, bool centered) {
+    size_t length = strlen(text) + 1;
+    if (list->text_used + length > DRAW_LIST_MAX_TEXT) {
+        list->dropped++;
+        return;
+    }
+    SDL_Color previous = list->color;
+    list->color = color;
+    DrawCmd *cmd = draw_list_run(list, DRAW_CMD_TEXT, list->text_used, false);
+    list->color = previous;
+    if (!cmd) {
+        list->dropped++;
+        return;
+    }
+    memcpy(&list->text[list->text_used], text, length);
+    list->text_used += (uint32_t)length;
+    cmd->face = (uint8_t)face;
+    cmd->centered = centered;
+    cmd->x = (float)x;
+    cmd->y = (float)y;
+}
+
+void draw_list_mark(DrawList *list) {
+    if (!draw_list_run(list, DRAW_CMD_MARK, 0, false)) list->dropped++;
+}
+
+void draw_list_filled_circle(DrawList *list, int cx, int cy, int radius) {
+    for (int y = -radius; y <= radius; y++) {
+        for (int x = -radius; x <= radius; x++) {
+            if (x*x + y*y <= radius*radius) {
+                draw_list_point(list, (float)(cx + x), (float)(cy + y));
+            }
+        }
+    }
+}
+
+void draw_list_circle(DrawList *list, int cx, int cy, int radius) {
+    int x = radius;
+    int y = 0;
+    int err = 0;
+
+    while (x >= y) {
+        draw_list_point(list, (float)(cx + x), (float)(cy + y));
+        draw_list_point(list, (float)(cx + y), (float)(cy + x));
+        draw_list_point(list, (float)(cx - y), (float)(cy + x));
+        draw_list_point(list, (float)(cx - x), (float)(cy + y));
+        draw_list_point(list, (float)(cx - x), (float)(cy - y));
+        draw_list_point(list, (float)(cx - y), (float)(cy - x));
+        draw_list_point(list, (float)(cx + y), (float)(cy - x));
+        draw_list_point(list, (float)(cx + x), (float)(cy - y));
+
+        if (err <= 0) {
+            y += 1;
+            err += 2*y + 1;
+        }
+        if (err > 0) {
+            x -= 1;
+            err -= 2*x + 1;
+        }
+    }
+}
+
+// One polyline per ring of the thickness
+void draw_list_arc(DrawList *list, int cx, int cy, int radius, float start_angle, float end_angle, int thickness,
+                   float segments_per_degree) {
+    float start_rad = start_angle * M_PI / 180.0f;
+    float end_rad = end_angle * M_PI / 180.0f;
+
+    int num_segments = (int)(fabs(end_angle - start_angle) * segments_per_degree);
+    if (num_segments < 1) num_segments = 1;
+    if (num_segments > 1024) num_segments = 1024;
+    float angle_step = (end_rad - start_rad) / num_segments;
+
+    SDL_FPoint ring[1025];
+    for (int t = 0; t < thickness; t++) {
+        int r = radius + t - thickness / 2;
+        for (int i = 0; i <= num_segments; i++) {
+            float angle = start_rad + i * angle_step;
+            ring[i] = (SDL_FPoint){cx + r * cosf(angle), cy + r * sinf(angle)};
+        }
+        draw_list_polyline(list, ring, num_segments + 1);
+    }
+}
+
+void draw_list_rounded_rect(DrawList *list, int x, int y, int w, int h, int radius) {
+    // Top, bottom, left and right edges
+    draw_list_line(list, (float)(x + radius), (float)y, (float)(x + w - radius), (float)y);
+    draw_list_line(list, (float)(x + radius), (float)(y + h), (float)(x + w - radius), (float)(y + h));
+    draw_list_line(list, (float)x, (float)(y + radius), (float)x, (float)(y + h - radius));
+    draw_list_line(list, (float)(x + w), (float)(y + radius), (float)(x + w), (float)(y + h - radius));
+
+    // Corners (simplified)
+    for (int i = 0; i < radius; i++) {
+        float angle = i * M_PI / (2 * radius);
+        int dx = (int)(radius * cosf(angle));
+        int dy = (int)(radius * sinf(angle));
+
+        draw_list_point(list, (float)(x + radius - dx), (float)(y + radius - dy));
+        draw_list_point(list, (float)(x + w - radius + dx), (float)(y + radius - dy));
+        draw_list_point(list, (float)(x + radius - dx), (float)(y + h - radius + dy));
+        draw_list_point(list, (float)(x + w - radius + dx), (float)(y + h - radius + dy));
+    }
+}
+
+void draw_list_filled_rounded_rect(DrawList *list, int x, int y, int w, int h, int radius) {
+    // Main rectangle
+    SDL_FRect center = {(float)(x + radius), (float)y, (float)(w - 2 * radius), (float)h};
+    draw_list_fill_rect(list, &center);
+
+    SDL_FRect left = {(float)x, (float)(y + radius), (float)radius, (float)(h - 2 * radius)};
+    draw_list_fill_rect(list, &left);
+
+    SDL_FRect right = {(float)(x + w - radius), (float)(y + radius), (float)radius, (float)(h - 2 * radius)};
+    draw_list_fill_rect(list, &right);
+
+    // Corners (simplified filled circles)
+    for (int cy = 0; cy < radius; cy++) {
+        for (int cx = 0; cx < radius; cx++) {
+            if (cx*cx + cy*cy <= radius*radius) {
+                draw_list_point(list, (float)(x + radius - cx), (float)(y + radius - cy));
+                draw_list_point(list, (float)(x + w - radius + cx), (float)(y + radius - cy));
+                draw_list_point(list, (float)(x + radius - cx), (float)(y + h - radius + cy));
+                draw_list_point(list, (float)(x + w - radius + cx), (float)(y + h - radius + cy));
+            }
+        }
+    }
+}
+
+// Replay commands from start up to the next mark. Returns where the next
+// call should start, or cmd_count once everything is submitted.
+uint32_t draw_list_submit(const DrawList *list, SDL_Renderer *renderer, FontAtlas *fonts, uint32_t start) {
+    for (uint32_t i = start; i < list->cmd_count; i++) {
+        const DrawCmd *cmd = &list->cmds[i];
+        if (cmd->type == DRAW_CMD_MARK) return i + 1;
+        if (cmd->type == DRAW_CMD_TEXT) {
+            font_atlas_draw(fonts, (FontFace)cmd->face, &list->text[cmd->first], (int)cmd->x, (int)cmd->y,
+                            cmd->color, cmd->centered);
+            continue;
+        }
+        SDL_SetRenderDrawColor(renderer, cmd->color.r, cmd->color.g, cmd->color.b, cmd->color.a);
+        switch (cmd->type) {
+            case DRAW_CMD_POINTS:
+                SDL_RenderPoints(renderer, &list->points[cmd->first], (int)cmd->count);
+                break;
+            case DRAW_CMD_LINES:
+                SDL_RenderLines(renderer, &list->points[cmd->first], (int)cmd->count);
+                break;
+            case DRAW_CMD_RECTS:
+                SDL_RenderRects(renderer, &list->rects[cmd->first], (int)cmd->count);
+                break;
+            case DRAW_CMD_FILL_RECTS:
+                SDL_RenderFillRects(renderer, &list->rects[cmd->first], (int)cmd->count);
+                break;
+        }
+    }
+    return list->cmd_count;
+}
+
+void draw_list_free(DrawList *list) {
+    free(list->cmds);
+    free(list->points);
+    free(list->rects);
+    free(list->text);
+    memset(list, 0, sizeof(*list));
+}
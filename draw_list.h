@@ -0,0 +1,77 @@
+/*
+ * Snow-Pi Draw List Header
+ * Author: /x64/dumped
+ */
+
+#ifndef DRAW_LIST_H
+#define DRAW_LIST_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "font_atlas.h"
+
+#define DRAW_LIST_MAX_COMMANDS 2048
+#define DRAW_LIST_MAX_POINTS (128 * 1024)   // Two gauges at the HIGH profile use about 100k
+#define DRAW_LIST_MAX_RECTS 512
+#define DRAW_LIST_MAX_TEXT 8192             // Bytes of string data, NUL-terminated
+
+typedef enum {
+    DRAW_CMD_POINTS,             // points[first .. first + count)
+    DRAW_CMD_LINES,              // One connected polyline through points[first .. first + count)
+    DRAW_CMD_RECTS,              // Outlines, rects[first .. first + count)
+    DRAW_CMD_FILL_RECTS,
+    DRAW_CMD_TEXT,               // text + first at (x, y)
+    DRAW_CMD_MARK                // Submission stops here so the caller can draw in between
+} DrawCmdType;
+
+typedef struct {
+    uint8_t type;                // DrawCmdType
+    uint8_t face;                // FontFace for text
+    uint8_t centered;
+    SDL_Color color;
+    uint32_t first;
+    uint32_t count;
+    float x, y;
+} DrawCmd;
+
+// Recorded drawing for one frame. Building touches no SDL state, so it
+// can run on any thread; only draw_list_submit needs the renderer.
+// Consecutive primitives of one kind and color share a command, which
+// becomes a single SDL call when submitted.
+typedef struct {
+    DrawCmd *cmds;
+    SDL_FPoint *points;
+    SDL_FRect *rects;
+    char *text;
+    uint32_t cmd_count;
+    uint32_t point_count;
+    uint32_t rect_count;
+    uint32_t text_used;
+    uint32_t dropped;            // Primitives refused because a buffer was full
+    SDL_Color color;             // Applied to primitives recorded from now on
+} DrawList;
+
+bool draw_list_init(DrawList *list);
+void draw_list_reset(DrawList *list);
+void draw_list_color(DrawList *list, Uint8 r, Uint8 g, Uint8 b, Uint8 a);
+void draw_list_point(DrawList *list, float x, float y);
+void draw_list_line(DrawList *list, float x1, float y1, float x2, float y2);
+void draw_list_polyline(DrawList *list, const SDL_FPoint *points, int count);
+void draw_list_rect(DrawList *list, const SDL_FRect *rect);
+void draw_list_fill_rect(DrawList *list, const SDL_FRect *rect);
+void draw_list_text(DrawList *list, FontFace face, const char *text, int x, int y, SDL_Color color, bool centered);
+void draw_list_mark(DrawList *list);
+
+// Shapes built from the primitives above
+void draw_list_circle(DrawList *list, int cx, int cy, int radius);
+void draw_list_filled_circle(DrawList *list, int cx, int cy, int radius);
+void draw_list_arc(DrawList *list, int cx, int cy, int radius, float start_angle, float end_angle, int thickness,
+                   float segments_per_degree);
+void draw_list_rounded_rect(DrawList *list, int x, int y, int w, int h, int radius);
+void draw_list_filled_rounded_rect(DrawList *list, int x, int y, int w, int h, int radius);
+
+uint32_t draw_list_submit(const DrawList *list, SDL_Renderer *renderer, FontAtlas *fonts, uint32_t start);
+void draw_list_free(DrawList *list);
+
+#endif
@@ -0,0 +1,202 @@
+/*
+ * Snow-Pi Font Atlas - Baked glyphs with lazy TTF fallback
+ * Author: /x64/dumped
+ * GitHub: @Ma110w
+ *
+ * Glyphs for every face are rasterized at build time (bake_font_atlas) and
+ * embedded in the binary, so startup only uploads one texture. Strings are
+ * drawn as a single geometry batch. A TTF font is opened the first time a
+ * string needs a glyph that was not baked.
+ */
+
+#include "font_atlas.h"
+#include "metrics.h"
+#include "pixel_convert.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifdef SNOWPI_BAKED_ATLAS
+#include "font_atlas_data.h"
+#endif
+
+// Evicted under memory pressure; the next draw uploads it again
+static void font_atlas_evicted(void *owner, void *item) {
+    (void)item;
+    FontAtlas *atlas = owner;
+    atlas->texture = NULL;
+    atlas->texture_handle = -1;
+}
+
+// Expand the baked coverage to white pixels so vertex colors tint it
+static bool font_atlas_upload(FontAtlas *atlas) {
+#ifdef SNOWPI_BAKED_ATLAS
+    size_t pixel_count = (size_t)FONT_ATLAS_BAKED_WIDTH * FONT_ATLAS_BAKED_HEIGHT;
+    int bpp = SDL_BYTESPERPIXEL(atlas->format);
+    void *pixels = SDL_malloc(pixel_count * bpp);
+    if (!pixels) return false;
+    if (atlas->format == SDL_PIXELFORMAT_ARGB4444) {
+        pixel_convert_alpha_to_argb4444(FONT_ATLAS_BAKED_PIXELS, pixels, pixel_count);
+    } else {
+        Uint32 *argb = pixels;
+        for (size_t i = 0; i < pixel_count; i++) {
+            argb[i] = ((Uint32)FONT_ATLAS_BAKED_PIXELS[i] << 24) | 0x00FFFFFFu;
+        }
+    }
+
+    atlas->texture_handle = texture_registry_create(atlas->textures, atlas->format, SDL_TEXTUREACCESS_STATIC,
+                                                    FONT_ATLAS_BAKED_WIDTH, FONT_ATLAS_BAKED_HEIGHT, TEXTURE_GLYPHS,
+                                                    font_atlas_evicted, atlas, NULL, &atlas->texture);
+    if (atlas->texture) {
+        SDL_UpdateTexture(atlas->texture, NULL, pixels, FONT_ATLAS_BAKED_WIDTH * bpp);
+        SDL_SetTextureBlendMode(atlas->texture, SDL_BLENDMODE_BLEND);
+    }
+    SDL_free(pixels);
+    return atlas->texture != NULL;
+#else
+    (void)atlas;
+    return false;
+#endif
+}
+
+bool font_atlas_init(FontAtlas *atlas, SDL_Renderer *renderer, FrameArena *arena, TextureRegistry *textures,
+                     SDL_PixelFormat format) {
+    memset(atlas, 0, sizeof(*atlas));
+    memset(atlas->lookup, 0xFF, sizeof(atlas->lookup));
+    atlas->renderer = renderer;
+    atlas->arena = arena;
+    atlas->textures = textures;
+    atlas->format = format;
+    atlas->texture_handle = -1;
+
+    // Quad index pattern never changes
+    for (int i = 0; i < FONT_ATLAS_MAX_CHARS; i++) {
+        int *idx = &atlas->indices[i * 6];
+        int v = i * 4;
+        idx[0] = v; idx[1] = v + 1; idx[2] = v + 2;
+        idx[3] = v; idx[4] = v + 2; idx[5] = v + 3;
+    }
+
+#ifdef SNOWPI_BAKED_ATLAS
+    atlas->glyphs = FONT_ATLAS_BAKED_GLYPHS;
+    for (int f = 0; f < FONT_FACE_COUNT; f++) {
+        const BakedFace *bf = &FONT_ATLAS_BAKED_FACES[f];
+        atlas->height[f] = bf->height;
+        for (int g = bf->first_glyph; g < bf->first_glyph + bf->glyph_count; g++) {
+            atlas->lookup[f][atlas->glyphs[g].codepoint & 0x7F] = (short)g;
+        }
+    }
+#endif
+
+    if (!font_atlas_upload(atlas)) {
+        if (atlas->glyphs) fprintf(stderr, "Font atlas upload failed: %s\n", SDL_GetError());
+        return false;
+    }
+    return true;
+}
+
+// Open a face's font on first use; failures are reported once
+static TTF_Font *font_atlas_font(FontAtlas *atlas, FontFace face) {
+    if (atlas->fonts[face] || atlas->font_failed[face]) return atlas->fonts[face];
+
+    Uint64 start = SDL_GetTicksNS();
+    const FontFaceDef *def = &FONT_FACE_DEFS[face];
+    atlas->fonts[face] = TTF_OpenFont(def->file, def->size);
+    if (!atlas->fonts[face]) {
+        fprintf(stderr, "Font loading failed (%s): %s\n", def->file, SDL_GetError());
+        atlas->font_failed[face] = true;
+        return NULL;
+    }
+    printf("Opened %s at %.0fpt on demand in %.1f ms\n", def->file, def->size,
+           (SDL_GetTicksNS() - start) / 1e6);
+    return atlas->fonts[face];
+}
+
+// Render through FreeType, as before the atlas existed
+static void font_atlas_draw_ttf(FontAtlas *atlas, FontFace face, const char *text, int x, int y,
+                                SDL_Color color, bool centered) {
+    TTF_Font *font = font_atlas_font(atlas, face);
+    if (!font) return;
+
+    SDL_Surface *surface = TTF_RenderText_Blended(font, text, 0, color);
+    if (!surface) return;
+
+    SDL_Texture *texture = SDL_CreateTextureFromSurface(atlas->renderer, surface);
+    if (!texture) {
+        SDL_DestroySurface(surface);
+        return;
+    }
+
+    SDL_FRect dest = {(float)x, (float)y, (float)surface->w, (float)surface->h};
+    if (centered) {
+        dest.x -= surface->w / 2.0f;
+        dest.y -= surface->h / 2.0f;
+    }
+
+    SDL_RenderTexture(atlas->renderer, texture, NULL, &dest);
+
+    SDL_DestroyTexture(texture);
+    SDL_DestroySurface(surface);
+}
+
+void font_atlas_draw(FontAtlas *atlas, FontFace face, const char *text, int x, int y, SDL_Color color, bool centered) {
+    if (!text || !text[0]) return;
+
+    // Measure, and bail to TTF if any glyph is missing or the string is too long
+    const short *lookup = atlas->lookup[face];
+    int len = 0;
+    int width = 0;
+    bool baked = atlas->glyphs && (atlas->texture || font_atlas_upload(atlas));
+    for (const unsigned char *p = (const unsigned char *)text; *p && baked; p++, len++) {
+        if (*p >= 128 || lookup[*p] < 0 || len >= FONT_ATLAS_MAX_CHARS) {
+            baked = false;
+        } else {
+            width += atlas->glyphs[lookup[*p]].advance;
+        }
+    }
+    if (!baked) {
+        font_atlas_draw_ttf(atlas, face, text, x, y, color, centered);
+        return;
+    }
+
+    float pen_x = (float)x;
+    float top = (float)y;
+    if (centered) {
+        pen_x -= width / 2.0f;
+        top -= atlas->height[face] / 2.0f;
+    }
+
+    texture_registry_touch(atlas->textures, atlas->texture_handle);
+    float tex_w, tex_h;
+    SDL_GetTextureSize(atlas->texture, &tex_w, &tex_h);
+    SDL_FColor fcolor = {color.r / 255.0f, color.g / 255.0f, color.b / 255.0f, color.a / 255.0f};
+
+    SDL_Vertex *vertices = frame_arena_alloc(atlas->arena, sizeof(SDL_Vertex) * 4 * (size_t)len);
+    if (!vertices) return;
+
+    SDL_Vertex *v = vertices;
+    for (int i = 0; i < len; i++, v += 4) {
+        const BakedGlyph *g = &atlas->glyphs[lookup[(unsigned char)text[i]]];
+        float x0 = pen_x, x1 = pen_x + g->w;
+        float y0 = top, y1 = top + g->h;
+        float u0 = g->x / tex_w, u1 = (g->x + g->w) / tex_w;
+        float v0 = g->y / tex_h, v1 = (g->y + g->h) / tex_h;
+
+        v[0] = (SDL_Vertex){{x0, y0}, fcolor, {u0, v0}};
+        v[1] = (SDL_Vertex){{x1, y0}, fcolor, {u1, v0}};
+        v[2] = (SDL_Vertex){{x1, y1}, fcolor, {u1, v1}};
+        v[3] = (SDL_Vertex){{x0, y1}, fcolor, {u0, v1}};
+        pen_x += g->advance;
+    }
+
+    SDL_RenderGeometry(atlas->renderer, atlas->texture, vertices, len * 4, atlas->indices, len * 6);
+}
+
+void font_atlas_cleanup(FontAtlas *atlas) {
+    for (int f = 0; f < FONT_FACE_COUNT; f++) {
+        if (atlas->fonts[f]) TTF_CloseFont(atlas->fonts[f]);
+        atlas->fonts[f] = NULL;
+    }
+    texture_registry_destroy(atlas->textures, atlas->texture_handle);
+    atlas->texture = NULL;
+    atlas->texture_handle = -1;
+}
@@ -0,0 +1,76 @@
+/*
+ * Snow-Pi Font Atlas Header
+ * Author: /x64/dumped
+ */
+
+#ifndef FONT_ATLAS_H
+#define FONT_ATLAS_H
+
+#include <SDL3/SDL.h>
+#include <SDL3_ttf/SDL_ttf.h>
+#include <stdbool.h>
+#include "frame_memory.h"
+#include "texture_registry.h"
+
+#define FONT_ATLAS_MAX_CHARS 64   // Longest string drawn in one geometry batch
+
+typedef enum {
+    FONT_DIGITAL_LARGE,
+    FONT_DIGITAL_MEDIUM,
+    FONT_DIGITAL_SMALL,
+    FONT_ARIAL_BOLD,
+    FONT_ARIAL_SMALL,
+    FONT_FACE_COUNT
+} FontFace;
+
+typedef struct {
+    const char *file;
+    float size;
+    const char *charset;   // Glyphs baked into the atlas; anything else opens the font
+} FontFaceDef;
+
+// Shared by the bake tool and the runtime so both agree on faces and sizes.
+// The digital faces only ever show numbers, so they bake just those.
+static const FontFaceDef FONT_FACE_DEFS[FONT_FACE_COUNT] = {
+    {"digital.ttf", 64, "0123456789.:%-+/ VKMH"},
+    {"digital.ttf", 42, "0123456789.:%-+/ VKMH"},
+    {"digital.ttf", 28, "0123456789.:%-+/ VKMH"},
+    {"Arial.ttf",   24, NULL},   // NULL = printable ASCII
+    {"Arial.ttf",   16, NULL},
+};
+
+// Layout records emitted by bake_font_atlas into font_atlas_data.h
+typedef struct {
+    unsigned short x, y, w, h;   // Cell in the atlas (line-height tall)
+    short advance;
+    unsigned char face;
+    unsigned char codepoint;
+} BakedGlyph;
+
+typedef struct {
+    short height;
+    short first_glyph;
+    short glyph_count;
+} BakedFace;
+
+typedef struct {
+    SDL_Renderer *renderer;
+    SDL_Texture *texture;                       // Baked glyphs, white with coverage in alpha
+    int texture_handle;
+    TextureRegistry *textures;
+    SDL_PixelFormat format;      // ARGB8888, or ARGB4444 for the 16 bpp pipeline
+    const BakedGlyph *glyphs;
+    short lookup[FONT_FACE_COUNT][128];         // ASCII -> glyph index, -1 if not baked
+    short height[FONT_FACE_COUNT];
+    TTF_Font *fonts[FONT_FACE_COUNT];           // Opened only when a glyph is missing
+    bool font_failed[FONT_FACE_COUNT];
+    FrameArena *arena;                          // Per-string vertex batches
+    int indices[FONT_ATLAS_MAX_CHARS * 6];      // Fixed quad pattern
+} FontAtlas;
+
+bool font_atlas_init(FontAtlas *atlas, SDL_Renderer *renderer, FrameArena *arena, TextureRegistry *textures,
+                     SDL_PixelFormat format);
+void font_atlas_draw(FontAtlas *atlas, FontFace face, const char *text, int x, int y, SDL_Color color, bool centered);
+void font_atlas_cleanup(FontAtlas *atlas);
+
+#endif
@@ -0,0 +1,135 @@
+/*
+ * Snow-Pi Frame Memory - Arena, pools and allocation counting
+ * Author: /x64/dumped
+ * GitHub: @Ma110w
+ *
+ * All heap memory is taken once at startup. Per-frame scratch (vertex
+ * batches, decode buffers, formatted strings) comes from a bump arena that
+ * is reset after present; longer-lived objects come from fixed pools. The
+ * allocation counter lets the benchmark prove a steady-state frame never
+ * reaches the system allocator.
+ */
+
+#include <SDL3/SDL.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include "frame_memory.h"
+
+bool frame_arena_init(FrameArena *arena, size_t size) {
+    memset(arena, 0, sizeof(*arena));
+    arena->base = SDL_aligned_alloc(FRAME_ARENA_ALIGN, size);
+    if (!arena->base) {
+        fprintf(stderr, "Cannot allocate %zu byte frame arena\n", size);
+        return false;
+    }
+    arena->size = size;
+    return true;
+}
+
+// Aligned bump allocation. Returns NULL when the frame's budget is spent;
+// callers skip the work rather than fall back to the heap.
+void *frame_arena_alloc(FrameArena *arena, size_t size) {
+    size_t offset = (arena->used + FRAME_ARENA_ALIGN - 1) & ~(size_t)(FRAME_ARENA_ALIGN - 1);
+    if (!arena->base || offset + size > arena->size) {
+        arena->overflows++;
+        return NULL;
+    }
+    arena->used = offset + size;
+    if (arena->used > arena->high_water) arena->high_water = arena->used;
+    return arena->base + offset;
+}
+
+char *frame_arena_printf(FrameArena *arena, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    va_list copy;
+    va_copy(copy, args);
+    int len = vsnprintf(NULL, 0, fmt, copy);
+    va_end(copy);
+
+    char *text = len >= 0 ? frame_arena_alloc(arena, (size_t)len + 1) : NULL;
+    if (text) vsnprintf(text, (size_t)len + 1, fmt, args);
+    va_end(args);
+    return text;
+}
+
+void frame_arena_reset(FrameArena *arena) {
+    arena->used = 0;
+}
+
+void frame_arena_destroy(FrameArena *arena) {
+    SDL_aligned_free(arena->base);
+    memset(arena, 0, sizeof(*arena));
+}
+
+bool fixed_pool_init(FixedPool *pool, size_t slot_size, int capacity) {
+    memset(pool, 0, sizeof(*pool));
+    pool->slot_size = (slot_size + FRAME_ARENA_ALIGN - 1) & ~(size_t)(FRAME_ARENA_ALIGN - 1);
+    pool->slots = SDL_aligned_alloc(FRAME_ARENA_ALIGN, pool->slot_size * (size_t)capacity);
+    pool->free_list = SDL_malloc(sizeof(int) * (size_t)capacity);
+    if (!pool->slots || !pool->free_list) {
+        fixed_pool_destroy(pool);
+        return false;
+    }
+
+    memset(pool->slots, 0, pool->slot_size * (size_t)capacity);
+    pool->capacity = capacity;
+    // Hand out low indices first so a lightly used pool stays cache-warm
+    for (int i = 0; i < capacity; i++) {
+        pool->free_list[i] = capacity - 1 - i;
+    }
+    pool->free_count = capacity;
+    return true;
+}
+
+// Slot contents are left as the previous owner left them, so pooled
+// objects can keep expensive members (textures) across reuse.
+void *fixed_pool_alloc(FixedPool *pool) {
+    if (pool->free_count == 0) return NULL;
+    int index = pool->free_list[--pool->free_count];
+    return pool->slots + (size_t)index * pool->slot_size;
+}
+
+void fixed_pool_free(FixedPool *pool, void *ptr) {
+    if (!ptr) return;
+    size_t index = (size_t)((unsigned char *)ptr - pool->slots) / pool->slot_size;
+    pool->free_list[pool->free_count++] = (int)index;
+}
+
+void fixed_pool_destroy(FixedPool *pool) {
+    SDL_aligned_free(pool->slots);
+    SDL_free(pool->free_list);
+    memset(pool, 0, sizeof(*pool));
+}
+
+// Allocation counting hook
+static SDL_malloc_func real_malloc;
+static SDL_calloc_func real_calloc;
+static SDL_realloc_func real_realloc;
+static SDL_free_func real_free;
+static SDL_AtomicInt alloc_count;
+
+static void *counting_malloc(size_t size) {
+    SDL_AddAtomicInt(&alloc_count, 1);
+    return real_malloc(size);
+}
+
+static void *counting_calloc(size_t nmemb, size_t size) {
+    SDL_AddAtomicInt(&alloc_count, 1);
+    return real_calloc(nmemb, size);
+}
+
+static void *counting_realloc(void *mem, size_t size) {
+    SDL_AddAtomicInt(&alloc_count, 1);
+    return real_realloc(mem, size);
+}
+
+bool alloc_counter_install(void) {
+    SDL_GetOriginalMemoryFunctions(&real_malloc, &real_calloc, &real_realloc, &real_free);
+    return SDL_SetMemoryFunctions(counting_malloc, counting_calloc, counting_realloc, real_free);
+}
+
+uint64_t alloc_counter_total(void) {
+    return (uint64_t)(uint32_t)SDL_GetAtomicInt(&alloc_count);
+}
@@ -0,0 +1,52 @@
+/*
+ * Snow-Pi Frame Memory Header
+ * Author: /x64/dumped
+ */
+
+#ifndef FRAME_MEMORY_H
+#define FRAME_MEMORY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define FRAME_ARENA_SIZE (512 * 1024)
+#define FRAME_ARENA_ALIGN 16
+
+// Bump allocator for data that only lives until the end of the frame
+typedef struct {
+    unsigned char *base;
+    size_t size;
+    size_t used;
+    size_t high_water;     // Most bytes used in any single frame
+    uint32_t overflows;    // Allocations refused because the arena was full
+} FrameArena;
+
+// Fixed number of equal-size slots for objects that outlive a frame
+typedef struct {
+    unsigned char *slots;
+    int *free_list;        // Stack of free slot indices
+    size_t slot_size;
+    int capacity;
+    int free_count;
+} FixedPool;
+
+bool frame_arena_init(FrameArena *arena, size_t size);
+void *frame_arena_alloc(FrameArena *arena, size_t size);
+char *frame_arena_printf(FrameArena *arena, const char *fmt, ...);
+// Scoped scratch: allocations after a mark are released by rewinding to it
+static inline size_t frame_arena_mark(const FrameArena *arena) { return arena->used; }
+static inline void frame_arena_rewind(FrameArena *arena, size_t mark) { arena->used = mark; }
+void frame_arena_reset(FrameArena *arena);
+void frame_arena_destroy(FrameArena *arena);
+
+bool fixed_pool_init(FixedPool *pool, size_t slot_size, int capacity);
+void *fixed_pool_alloc(FixedPool *pool);
+void fixed_pool_free(FixedPool *pool, void *ptr);
+void fixed_pool_destroy(FixedPool *pool);
+
+// Route SDL's allocator through a counter. Must run before SDL_Init.
+bool alloc_counter_install(void);
+uint64_t alloc_counter_total(void);
+
+#endif
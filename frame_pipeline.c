@@ -0,0 +1,120 @@
+/*
+ * Snow-Pi Frame Pipeline - Build the next frame while this one presents
+ * Author: /x64/dumped
+ * GitHub: @Ma110w
+ *
+ * Frame N submits the draw list built from frame N-1's snapshot, then
+ * hands frame N's snapshot to a worker thread, so recording the gauges
+ * overlaps submission, the GPU and the vsync wait on another core. The
+ * shown state is one frame behind the data; the first frame after the
+ * screen was not shown is built on the main thread so it never shows
+ * stale values.
+ */
+
+#include "frame_pipeline.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "metrics.h"
+
+static void frame_pipeline_build(FramePipeline *pipeline, DrawList *list) {
+    Uint64 start_ns = SDL_GetTicksNS();
+    draw_list_reset(list);
+    pipeline->build(list, pipeline->snapshot);
+    pipeline->build_us = (uint32_t)((SDL_GetTicksNS() - start_ns) / 1000);
+    pipeline->build_dropped = list->dropped;
+}
+
+// Main thread only, after the build it reports has finished
+static void frame_pipeline_publish(const FramePipeline *pipeline) {
+    dash_metrics.frame_build_us = pipeline->build_us;
+    dash_metrics.frame_build_dropped = pipeline->build_dropped;
+    dash_metrics.draw_dropped += pipeline->build_dropped;
+}
+
+static int frame_pipeline_worker(void *data) {
+    FramePipeline *pipeline = data;
+    for (;;) {
+        SDL_WaitSemaphore(pipeline->start);
+        if (SDL_GetAtomicInt(&pipeline->stop)) break;
+        frame_pipeline_build(pipeline, &pipeline->lists[1 - pipeline->shown]);
+        SDL_SignalSemaphore(pipeline->done);
+    }
+    return 0;
+}
+
+bool frame_pipeline_init(FramePipeline *pipeline, FrameBuildFn build, size_t snapshot_size) {
+    memset(pipeline, 0, sizeof(*pipeline));
+    pipeline->build = build;
+    pipeline->snapshot_size = snapshot_size;
+    pipeline->snapshot = calloc(1, snapshot_size);
+    if (!pipeline->snapshot || !draw_list_init(&pipeline->lists[0]) || !draw_list_init(&pipeline->lists[1])) {
+        frame_pipeline_cleanup(pipeline);
+        return false;
+    }
+
+    // Without a worker every frame is built in frame_pipeline_end
+    pipeline->start = SDL_CreateSemaphore(0);
+    pipeline->done = SDL_CreateSemaphore(0);
+    if (pipeline->start && pipeline->done) {
+        pipeline->worker = SDL_CreateThread(frame_pipeline_worker, "frame-build", pipeline);
+    }
+    if (!pipeline->worker) {
+        fprintf(stderr, "Cannot start frame build worker, building on the main thread: %s\n", SDL_GetError());
+    }
+    return true;
+}
+
+// Collect the build started last frame and return the snapshot to fill
+// for the next one. The worker is idle until frame_pipeline_end.
+void *frame_pipeline_begin(FramePipeline *pipeline) {
+    pipeline->fresh = false;
+    if (pipeline->pending) {
+        Uint64 wait_ns = SDL_GetTicksNS();
+        SDL_WaitSemaphore(pipeline->done);
+        dash_metrics.frame_build_wait_us = (uint32_t)((SDL_GetTicksNS() - wait_ns) / 1000);
+        pipeline->pending = false;
+        pipeline->shown = 1 - pipeline->shown;
+        pipeline->fresh = true;
+        frame_pipeline_publish(pipeline);
+    }
+    return pipeline->snapshot;
+}
+
+// Start building from the filled snapshot and return the list to submit
+const DrawList *frame_pipeline_end(FramePipeline *pipeline) {
+    if (!pipeline->fresh) {
+        frame_pipeline_build(pipeline, &pipeline->lists[1 - pipeline->shown]);
+        pipeline->shown = 1 - pipeline->shown;
+        frame_pipeline_publish(pipeline);
+    }
+    if (pipeline->worker) {
+        pipeline->pending = true;
+        SDL_SignalSemaphore(pipeline->start);
+    }
+    return &pipeline->lists[pipeline->shown];
+}
+
+// The screen is not shown this frame: let any build finish and discard
+// it, so the next shown frame is built from current data
+void frame_pipeline_drop(FramePipeline *pipeline) {
+    if (pipeline->pending) {
+        SDL_WaitSemaphore(pipeline->done);
+        pipeline->pending = false;
+    }
+}
+
+void frame_pipeline_cleanup(FramePipeline *pipeline) {
+    if (pipeline->worker) {
+        frame_pipeline_drop(pipeline);
+        SDL_SetAtomicInt(&pipeline->stop, 1);
+        SDL_SignalSemaphore(pipeline->start);
+        SDL_WaitThread(pipeline->worker, NULL);
+    }
+    if (pipeline->start) SDL_DestroySemaphore(pipeline->start);
+    if (pipeline->done) SDL_DestroySemaphore(pipeline->done);
+    draw_list_free(&pipeline->lists[0]);
+    draw_list_free(&pipeline->lists[1]);
+    free(pipeline->snapshot);
+    memset(pipeline, 0, sizeof(*pipeline));
+}
@@ -0,0 +1,41 @@
+/*
+ * Snow-Pi Frame Pipeline Header
+ * Author: /x64/dumped
+ */
+
+#ifndef FRAME_PIPELINE_H
+#define FRAME_PIPELINE_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "draw_list.h"
+
+// Records one frame from a snapshot; must not touch anything else
+typedef void (*FrameBuildFn)(DrawList *list, const void *snapshot);
+
+// Two draw lists: the main thread submits one while the worker records
+// the next frame into the other from a snapshot of the dashboard state
+typedef struct {
+    DrawList lists[2];
+    int shown;                   // List the main thread submits
+    bool pending;                // Worker is building into the other list
+    bool fresh;                  // A finished build was swapped in this frame
+    FrameBuildFn build;
+    void *snapshot;              // Filled between begin and end, read by the worker
+    size_t snapshot_size;
+    SDL_Thread *worker;          // NULL: frames are built on the main thread
+    SDL_Semaphore *start;
+    SDL_Semaphore *done;
+    SDL_AtomicInt stop;
+    uint32_t build_us;           // Last build, published by the main thread once it has
+    uint32_t build_dropped;      // collected the list, so the worker never writes metrics
+} FramePipeline;
+
+bool frame_pipeline_init(FramePipeline *pipeline, FrameBuildFn build, size_t snapshot_size);
+void *frame_pipeline_begin(FramePipeline *pipeline);
+const DrawList *frame_pipeline_end(FramePipeline *pipeline);
+void frame_pipeline_drop(FramePipeline *pipeline);
+void frame_pipeline_cleanup(FramePipeline *pipeline);
+
+#endif
@@ -0,0 +1,379 @@
+/*
+ * Snow-Pi Fuel Range - Trails reachable on the fuel left
+ * Author: /x64/dumped
+ * GitHub: @Ma110w
+ *
+ * A Dijkstra search over the trail graph in trails.idx, bounded by the
+ * range the fuel left is good for. It runs a few thousand nodes per frame
+ * and only starts again once the rider has moved on a few hundred metres
+ * or the range has grown past what was searched; a falling range just
+ * draws less of the last result. Results are double-buffered so the map
+ * layer always shows a finished search, and they are drawn into the
+ * cached map layer rather than every frame.
+ */
+
+#include "fuel_range.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "metrics.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define FUEL_HEAP_SETTLED UINT32_MAX
+#define FUEL_METERS_PER_DEG 111320.0
+#define FUEL_SEARCH_SLACK 1.2          // Searched past the range, so a growing estimate rarely needs a new search
+#define FUEL_DRAW_BATCH 1024           // Quads per SDL_RenderGeometry call
+#define FUEL_LINE_HALF_PX 1.5f
+#define FUEL_STATION_HALF_PX 5.0f
+
+static double fuel_distance_m(double lat0, double lon0, double lat1, double lon1) {
+    double kx = FUEL_METERS_PER_DEG * cos((lat0 + lat1) * 0.5 * M_PI / 180.0);
+    return hypot((lon1 - lon0) * kx, (lat1 - lat0) * FUEL_METERS_PER_DEG);
+}
+
+// Web Mercator with 256 units across the world, i.e. world pixels at zoom 0
+static void fuel_project(double lat, double lon, double *x, double *y) {
+    double lat_rad = lat * M_PI / 180.0;
+    *x = (lon + 180.0) / 360.0 * 256.0;
+    *y = (1.0 - log(tan(lat_rad) + 1.0 / cos(lat_rad)) / M_PI) / 2.0 * 256.0;
+}
+
+bool fuel_range_open(FuelRange *range, const TrailIndex *index, FrameArena *arena) {
+    memset(range, 0, sizeof(*range));
+    range->shown = -1;
+    range->learn_pct = -1.0f;
+    range->km_per_pct = FUEL_RANGE_KM_PER_PCT;
+    const TrailIndexHeader *h = index->header;
+    if (!h || h->node_count == 0) return false;
+
+    uint32_t n = h->node_count;
+    bool ok = true;
+    for (int i = 0; i < 2; i++) {
+        FuelSearch *s = &range->searches[i];
+        s->dist = malloc(n * sizeof(float));
+        s->stamp = calloc(n, sizeof(uint32_t));
+        s->settled = malloc(n * sizeof(uint32_t));
+        ok = ok && s->dist && s->stamp && s->settled;
+    }
+    range->heap = malloc(n * sizeof(uint32_t));
+    range->heap_pos = malloc(n * sizeof(uint32_t));
+    range->fuel_node = calloc(n, 1);
+    range->merc_x = malloc(n * sizeof(float));
+    range->merc_y = malloc(n * sizeof(float));
+    if (!ok || !range->heap || !range->heap_pos || !range->fuel_node || !range->merc_x || !range->merc_y) {
+        fprintf(stderr, "Cannot allocate fuel range search for %u nodes\n", n);
+        fuel_range_close(range);
+        return false;
+    }
+    for (uint32_t i = 0; i < n; i++) range->merc_x[i] = NAN;  // Projected on first use
+    for (uint32_t i = 0; i < h->fuel_count; i++) range->fuel_node[index->fuel[i].node] = 1;
+    fuel_project(h->origin_lat, h->origin_lon, &range->origin_merc_x, &range->origin_merc_y);
+    range->index = index;
+    range->arena = arena;
+    range->work = 0;
+    return true;
+}
+
+// Range on the fuel left, at this ride's economy once enough has been burnt
+double fuel_range_estimate(FuelRange *range, double odometer_miles, float fuel_pct) {
+    if (range->learn_pct < 0 || fuel_pct > range->learn_pct + FUEL_RANGE_REFUEL_PCT) {
+        range->learn_miles = odometer_miles;
+        range->learn_pct = fuel_pct;
+    }
+    float burnt = range->learn_pct - fuel_pct;
+    if (burnt >= FUEL_RANGE_LEARN_PCT) {
+        double km_per_pct = (odometer_miles - range->learn_miles) * 1.60934 / burnt;
+        range->km_per_pct = fmin(fmax(km_per_pct, 0.5), 10.0);  // Idling or coasting skews short samples
+    }
+    return fmax(0.0, fuel_pct * range->km_per_pct * 1000.0);
+}
+
+// Binary heap on the working search's distances
+static void heap_place(FuelRange *range, uint32_t slot, uint32_t node) {
+    range->heap[slot] = node;
+    range->heap_pos[node] = slot;
+}
+
+static void heap_up(FuelRange *range, const float *dist, uint32_t slot) {
+    uint32_t node = range->heap[slot];
+    while (slot > 0) {
+        uint32_t parent = (slot - 1) / 2;
+        if (dist[range->heap[parent]] <= dist[node]) break;
+        heap_place(range, slot, range->heap[parent]);
+        slot = parent;
+    }
+    heap_place(range, slot, node);
+}
+
+static uint32_t heap_pop(FuelRange *range, const float *dist) {
+    uint32_t top = range->heap[0];
+    uint32_t node = range->heap[--range->heap_count];
+    uint32_t slot = 0;
+    for (;;) {
+        uint32_t child = slot * 2 + 1;
+        if (child >= range->heap_count) break;
+        if (child + 1 < range->heap_count && dist[range->heap[child + 1]] < dist[range->heap[child]]) child++;
+        if (dist[node] <= dist[range->heap[child]]) break;
+        heap_place(range, slot, range->heap[child]);
+        slot = child;
+    }
+    if (range->heap_count > 0) heap_place(range, slot, node);
+    return top;
+}
+
+static void heap_offer(FuelRange *range, FuelSearch *s, uint32_t node, float d) {
+    if (s->stamp[node] != s->generation) {
+        s->stamp[node] = s->generation;
+        s->dist[node] = d;
+        heap_place(range, range->heap_count, node);
+        heap_up(range, s->dist, range->heap_count++);
+    } else if (range->heap_pos[node] != FUEL_HEAP_SETTLED && d < s->dist[node]) {
+        s->dist[node] = d;
+        heap_up(range, s->dist, range->heap_pos[node]);
+    }
+}
+
+static void fuel_range_start(FuelRange *range, const TrailSnap *snap, double latitude, double longitude,
+                             double range_m) {
+    const TrailIndexHeader *h = range->index->header;
+    FuelSearch *s = &range->searches[range->work];
+    if (++s->generation == 0) {
+        memset(s->stamp, 0, h->node_count * sizeof(uint32_t));
+        s->generation = 1;
+    }
+    s->settled_count = 0;
+    s->origin_lat = latitude;
+    s->origin_lon = longitude;
+    s->bound_m = range_m * FUEL_SEARCH_SLACK;
+    s->fuel_m = INFINITY;
+    range->heap_count = 0;
+    range->running = true;
+
+    // Both ends of the trail piece the rider is on
+    const TrailSegmentNodes *ends = &range->index->segment_nodes[snap->segment];
+    uint32_t start[2] = {ends->from, ends->to};
+    for (int i = 0; i < 2; i++) {
+        const TrailVertex *node = &range->index->nodes[start[i]];
+        heap_offer(range, s, start[i], (float)fuel_distance_m(snap->latitude, snap->longitude,
+                                                              h->origin_lat + node->y, h->origin_lon + node->x));
+    }
+}
+
+// Start a new search when the rider has moved on or the range has grown
+// past the last one. Returns true when the shown result should be drawn
+// again for a changed range.
+bool fuel_range_update(FuelRange *range, double latitude, double longitude, double range_m) {
+    if (!range->index) return false;
+    range->range_m = range_m;
+    const FuelSearch *shown = range->shown >= 0 ? &range->searches[range->shown] : NULL;
+    const FuelSearch *latest = range->running ? &range->searches[range->work] : shown;
+    if (!latest || range_m > latest->bound_m ||
+        fuel_distance_m(latest->origin_lat, latest->origin_lon, latitude, longitude) > FUEL_RANGE_MOVE_M) {
+        TrailSnap snap;
+        if (trail_index_snap(range->index, latitude, longitude, TRAIL_SNAP_MAX_M, &snap) &&
+            snap.segment < range->index->header->segment_count) {
+            fuel_range_start(range, &snap, latitude, longitude, range_m);
+        }
+    }
+    return shown && range->drawn_range_m > 0 &&
+           fabs(range->drawn_range_m - range_m) > range->drawn_range_m * FUEL_RANGE_REDRAW;
+}
+
+// Settle up to budget nodes. Returns true when a search finished and
+// replaced the shown result.
+bool fuel_range_step(FuelRange *range, uint32_t budget) {
+    if (!range->running) return false;
+    const TrailIndex *index = range->index;
+    FuelSearch *s = &range->searches[range->work];
+    while (budget > 0 && range->heap_count > 0) {
+        if (s->dist[range->heap[0]] > s->bound_m) {
+            range->heap_count = 0;  // Everything left is out of range
+            break;
+        }
+        uint32_t u = heap_pop(range, s->dist);
+        float du = s->dist[u];
+        range->heap_pos[u] = FUEL_HEAP_SETTLED;
+        s->settled[s->settled_count++] = u;
+        budget--;
+
+        if (range->fuel_node[u]) {
+            for (uint32_t f = 0; f < index->header->fuel_count; f++) {
+                if (index->fuel[f].node == u) s->fuel_m = fmin(s->fuel_m, du + index->fuel[f].access_m);
+            }
+        }
+        for (uint32_t e = index->node_edges[u]; e < index->node_edges[u + 1]; e++) {
+            const TrailEdge *edge = &index->edges[e];
+            heap_offer(range, s, edge->target, du + edge->length_m);
+        }
+    }
+    if (range->heap_count > 0) return false;
+
+    range->running = false;
+    range->shown = range->work;
+    range->work = 1 - range->work;
+    return true;
+}
+
+// Trail distance to the nearest station from where the shown search
+// started: NAN before the first search, INFINITY if none is in range
+double fuel_range_to_fuel_m(const FuelRange *range) {
+    if (range->shown < 0) return NAN;
+    return range->searches[range->shown].fuel_m;
+}
+
+static SDL_FPoint fuel_node_screen(FuelRange *range, const MapView *view, double scale, uint32_t node) {
+    if (isnan(range->merc_x[node])) {
+        const TrailIndexHeader *h = range->index->header;
+        const TrailVertex *v = &range->index->nodes[node];
+        double x, y;
+        fuel_project(h->origin_lat + v->y, h->origin_lon + v->x, &x, &y);
+        range->merc_x[node] = (float)(x - range->origin_merc_x);
+        range->merc_y[node] = (float)(y - range->origin_merc_y);
+    }
+    // World pixels at the view zoom, then the view's own offset and rotation
+    float dx = (float)((range->origin_merc_x + range->merc_x[node]) * scale - view->world_x) - view->pivot_x;
+    float dy = (float)((range->origin_merc_y + range->merc_y[node]) * scale - view->world_y) - view->pivot_y;
+    SDL_FPoint p = {view->pivot_x + dx * view->cos_a - dy * view->sin_a,
+                    view->pivot_y + dx * view->sin_a + dy * view->cos_a};
+    return p;
+}
+
+// Green with most of the range left, amber near the limit
+static SDL_FColor fuel_color(double used) {
+    float t = used < 0.7 ? 0.0f : (float)fmin((used - 0.7) / 0.3, 1.0);
+    SDL_FColor c = {t, 0.8f - 0.13f * t, 0.35f * (1.0f - t), 0.8f};
+    return c;
+}
+
+typedef struct {
+    SDL_Renderer *renderer;
+    SDL_Vertex *vertices;
+    int *indices;
+    int quads;
+} FuelBatch;
+
+static void fuel_batch_flush(FuelBatch *batch) {
+    if (batch->quads > 0) {
+        SDL_RenderGeometry(batch->renderer, NULL, batch->vertices, batch->quads * 4, batch->indices, batch->quads * 6);
+    }
+    batch->quads = 0;
+}
+
+static void fuel_batch_quad(FuelBatch *batch, const SDL_FPoint corners[4], SDL_FColor c0, SDL_FColor c1) {
+    SDL_Vertex *v = &batch->vertices[batch->quads * 4];
+    for (int i = 0; i < 4; i++) {
+        v[i].position = corners[i];
+        v[i].color = i < 2 ? c0 : c1;
+        v[i].tex_coord = (SDL_FPoint){0, 0};
+    }
+    if (++batch->quads == FUEL_DRAW_BATCH) fuel_batch_flush(batch);
+}
+
+// A thick line as a quad, skipped when it is nowhere near the target
+static void fuel_batch_line(FuelBatch *batch, SDL_FPoint a, SDL_FPoint b, SDL_FColor ca, SDL_FColor cb, int width,
+                            int height) {
+    float pad = 4.0f;
+    if ((a.x < -pad && b.x < -pad) || (a.y < -pad && b.y < -pad) || (a.x > width + pad && b.x > width + pad) ||
+        (a.y > height + pad && b.y > height + pad)) {
+        return;
+    }
+    float dx = b.x - a.x, dy = b.y - a.y;
+    float len = sqrtf(dx * dx + dy * dy);
+    if (len < 0.5f) return;
+    float nx = -dy / len * FUEL_LINE_HALF_PX, ny = dx / len * FUEL_LINE_HALF_PX;
+    SDL_FPoint corners[4] = {{a.x + nx, a.y + ny}, {a.x - nx, a.y - ny}, {b.x - nx, b.y - ny}, {b.x + nx, b.y + ny}};
+    fuel_batch_quad(batch, corners, ca, cb);
+}
+
+// Map layer overlay: the reachable trails and the stations on them
+void fuel_range_draw(void *user, SDL_Renderer *renderer, const MapView *view, int width, int height) {
+    FuelRange *range = user;
+    if (range->shown < 0 || !view->valid) return;
+    const FuelSearch *s = &range->searches[range->shown];
+    const TrailIndex *index = range->index;
+    double limit = range->range_m;
+    range->drawn_range_m = limit;
+    if (limit <= 0) return;
+
+    size_t mark = frame_arena_mark(range->arena);
+    FuelBatch batch = {renderer, frame_arena_alloc(range->arena, FUEL_DRAW_BATCH * 4 * sizeof(SDL_Vertex)),
+                       frame_arena_alloc(range->arena, FUEL_DRAW_BATCH * 6 * sizeof(int)), 0};
+    if (!batch.vertices || !batch.indices) {
+        frame_arena_rewind(range->arena, mark);
+        return;
+    }
+    for (int q = 0; q < FUEL_DRAW_BATCH; q++) {
+        static const int corner[6] = {0, 1, 2, 0, 2, 3};
+        for (int i = 0; i < 6; i++) batch.indices[q * 6 + i] = q * 4 + corner[i];
+    }
+
+    double scale = ldexp(1.0, view->zoom);
+    // Nodes were settled nearest first, so the walk stops at the limit
+    for (uint32_t i = 0; i < s->settled_count; i++) {
+        uint32_t u = s->settled[i];
+        double du = s->dist[u];
+        if (du > limit) break;
+        SDL_FPoint a = fuel_node_screen(range, view, scale, u);
+        SDL_FColor ca = fuel_color(du / limit);
+        for (uint32_t e = index->node_edges[u]; e < index->node_edges[u + 1]; e++) {
+            const TrailEdge *edge = &index->edges[e];
+            uint32_t v = edge->target;
+            if (!(edge->length_m > 0)) continue;
+            bool v_reached = s->stamp[v] == s->generation && s->dist[v] <= limit;
+            if (v_reached) {
+                // Each edge once, from its nearer end
+                double dv = s->dist[v];
+                if (dv < du || (dv == du && v < u)) continue;
+                fuel_batch_line(&batch, a, fuel_node_screen(range, view, scale, v), ca, fuel_color(dv / limit),
+                                width, height);
+            } else {
+                // The range runs out part way along
+                float t = (float)fmin((limit - du) / edge->length_m, 1.0);
+                SDL_FPoint b = fuel_node_screen(range, view, scale, v);
+                SDL_FPoint end = {a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t};
+                fuel_batch_line(&batch, a, end, ca, fuel_color(1.0), width, height);
+            }
+        }
+    }
+
+    // Stations in reach
+    const TrailIndexHeader *h = index->header;
+    SDL_FColor station = {0.2f, 0.6f, 1.0f, 1.0f};
+    for (uint32_t f = 0; f < h->fuel_count; f++) {
+        const TrailFuel *fuel = &index->fuel[f];
+        if (s->stamp[fuel->node] != s->generation || s->dist[fuel->node] + fuel->access_m > limit) {
+            continue;
+        }
+        double x, y;
+        fuel_project(h->origin_lat + fuel->y, h->origin_lon + fuel->x, &x, &y);
+        float dx = (float)(x * scale - view->world_x) - view->pivot_x;
+        float dy = (float)(y * scale - view->world_y) - view->pivot_y;
+        SDL_FPoint c = {view->pivot_x + dx * view->cos_a - dy * view->sin_a,
+                        view->pivot_y + dx * view->sin_a + dy * view->cos_a};
+        if (c.x < -10 || c.y < -10 || c.x > width + 10 || c.y > height + 10) continue;
+        float r = FUEL_STATION_HALF_PX;
+        SDL_FPoint corners[4] = {{c.x - r, c.y - r}, {c.x + r, c.y - r}, {c.x + r, c.y + r}, {c.x - r, c.y + r}};
+        fuel_batch_quad(&batch, corners, station, station);
+    }
+    fuel_batch_flush(&batch);
+    frame_arena_rewind(range->arena, mark);
+}
+
+void fuel_range_close(FuelRange *range) {
+    for (int i = 0; i < 2; i++) {
+        free(range->searches[i].dist);
+        free(range->searches[i].stamp);
+        free(range->searches[i].settled);
+    }
+    free(range->heap);
+    free(range->heap_pos);
+    free(range->fuel_node);
+    free(range->merc_x);
+    free(range->merc_y);
+    memset(range, 0, sizeof(*range));
+    range->shown = -1;
+}
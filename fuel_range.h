@@ -0,0 +1,67 @@
+/*
+ * Snow-Pi Fuel Range Header
+ * Author: /x64/dumped
+ */
+
+#ifndef FUEL_RANGE_H
+#define FUEL_RANGE_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "frame_memory.h"
+#include "map_viewer.h"
+#include "trail_index.h"
+
+#define FUEL_RANGE_KM_PER_PCT 2.5      // 250 km on a full tank until this ride's economy is known
+#define FUEL_RANGE_LEARN_PCT 3.0f      // Fuel burnt before the ride's own economy is trusted
+#define FUEL_RANGE_REFUEL_PCT 5.0f     // A rise this large is a refuel
+#define FUEL_RANGE_MOVE_M 250.0        // Search again once the rider is this far from the search origin
+#define FUEL_RANGE_REDRAW 0.05         // Redraw the layer once the range has dropped by this fraction
+#define FUEL_RANGE_STEP_NODES 4096     // Nodes settled per frame
+
+// One Dijkstra result over the trail graph. Per-node arrays are only
+// valid where stamp[node] == generation, so a new search clears nothing.
+typedef struct {
+    float *dist;
+    uint32_t *stamp;
+    uint32_t generation;
+    uint32_t *settled;           // Nodes in the order they were settled
+    uint32_t settled_count;
+    double origin_lat;
+    double origin_lon;
+    double bound_m;              // Searched out to this distance
+    double fuel_m;               // Nearest station by trail, INFINITY if none within bound
+} FuelSearch;
+
+typedef struct {
+    const TrailIndex *index;
+    FuelSearch searches[2];      // One shown, one being built
+    int shown;                   // -1 until the first search finishes
+    int work;
+    bool running;
+    uint32_t *heap;              // Binary heap of nodes keyed by the working dist
+    uint32_t *heap_pos;          // Heap slot per node, FUEL_HEAP_SETTLED once final
+    uint32_t heap_count;
+    uint8_t *fuel_node;          // Nodes a station hangs off
+    float *merc_x;               // Web Mercator (256 units per world) relative to the index origin,
+    float *merc_y;               // filled in as nodes are settled
+    double origin_merc_x;
+    double origin_merc_y;
+    double range_m;              // Latest estimate
+    double drawn_range_m;        // Range the layer was last drawn for
+    double learn_miles;          // Odometer and fuel at the start of the economy estimate
+    float learn_pct;
+    double km_per_pct;
+    FrameArena *arena;           // Vertex scratch for drawing
+} FuelRange;
+
+bool fuel_range_open(FuelRange *range, const TrailIndex *index, FrameArena *arena);
+double fuel_range_estimate(FuelRange *range, double odometer_miles, float fuel_pct);
+bool fuel_range_update(FuelRange *range, double latitude, double longitude, double range_m);
+bool fuel_range_step(FuelRange *range, uint32_t budget);
+double fuel_range_to_fuel_m(const FuelRange *range);
+void fuel_range_draw(void *user, SDL_Renderer *renderer, const MapView *view, int width, int height);
+void fuel_range_close(FuelRange *range);
+
+#endif
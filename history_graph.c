@@ -0,0 +1,151 @@
+/*
+ * Snow-Pi History Graph - Multi-resolution min/max history
+ * Author: /x64/dumped
+ * GitHub: @Ma110w
+ *
+ * Each channel keeps a pyramid of ring buffers: level 0 holds 125 ms
+ * min/max buckets and every level above merges pairs from the one below.
+ * A graph of any span reads the level whose buckets are about one screen
+ * column wide, so drawing 1 minute or 2 hours costs the same.
+ */
+
+#include "history_graph.h"
+#include "metrics.h"
+#include <math.h>
+#include <string.h>
+
+static const SensorChannel HISTORY_SENSOR[HISTORY_CHANNEL_COUNT] = {
+    [HISTORY_BELT_TEMP] = SENSOR_BELT_TEMP,
+    [HISTORY_RPM] = SENSOR_RPM,
+    [HISTORY_SPEED] = SENSOR_SPEED,
+};
+
+void history_graph_init(HistoryGraph *graph) {
+    memset(graph, 0, sizeof(*graph));
+
+    // Index pattern never changes: two triangles per column quad
+    for (int c = 0; c < HISTORY_MAX_COLUMNS; c++) {
+        int v = c * 4;
+        int *idx = &graph->indices[c * 6];
+        idx[0] = v; idx[1] = v + 1; idx[2] = v + 2;
+        idx[3] = v + 2; idx[4] = v + 1; idx[5] = v + 3;
+    }
+}
+
+// Append a bucket; every second one also completes a bucket on the next level
+static void level_append(HistoryChannel *channel, int level, float min, float max) {
+    while (level < HISTORY_LEVELS) {
+        HistoryLevel *lv = &channel->levels[level];
+        lv->min[lv->count % HISTORY_RING] = min;
+        lv->max[lv->count % HISTORY_RING] = max;
+        lv->count++;
+
+        if (lv->count & 1) break;
+        uint32_t prev = (lv->count - 2) % HISTORY_RING;
+        min = fminf(min, lv->min[prev]);
+        max = fmaxf(max, lv->max[prev]);
+        level++;
+    }
+}
+
+void history_graph_push(HistoryGraph *graph, const float *values, uint32_t dt_ms) {
+    for (int i = 0; i < HISTORY_CHANNEL_COUNT; i++) {
+        HistoryChannel *channel = &graph->channels[i];
+        float v = values[HISTORY_SENSOR[i]];
+        channel->pending_min = graph->pending ? fminf(channel->pending_min, v) : v;
+        channel->pending_max = graph->pending ? fmaxf(channel->pending_max, v) : v;
+    }
+    graph->pending = true;
+    graph->pending_ms += dt_ms;
+
+    // Long gaps (boot, stalls) fill whole buckets with the latest min/max
+    int commits = 0;
+    while (graph->pending_ms >= HISTORY_BASE_MS && commits < HISTORY_RING) {
+        for (int i = 0; i < HISTORY_CHANNEL_COUNT; i++) {
+            HistoryChannel *channel = &graph->channels[i];
+            level_append(channel, 0, channel->pending_min, channel->pending_max);
+        }
+        graph->pending_ms -= HISTORY_BASE_MS;
+        commits++;
+    }
+    if (commits > 0) {
+        graph->pending = false;
+        if (commits == HISTORY_RING) graph->pending_ms = 0;
+    }
+}
+
+// Fill one min/max pair per column, oldest first. Columns without
+// history yet get NAN. Returns the number of columns written.
+int history_graph_query(const HistoryGraph *graph, HistoryChannelId id, uint32_t span_ms, int columns,
+                        float *out_min, float *out_max) {
+    if (columns > HISTORY_MAX_COLUMNS) columns = HISTORY_MAX_COLUMNS;
+    if (columns <= 0 || span_ms == 0) return 0;
+
+    // Coarsest level whose buckets still fit inside one column
+    double column_ms = (double)span_ms / columns;
+    int level = 0;
+    while (level + 1 < HISTORY_LEVELS && (double)(HISTORY_BASE_MS << (level + 1)) <= column_ms) {
+        level++;
+    }
+
+    const HistoryLevel *lv = &graph->channels[id].levels[level];
+    double per_column = column_ms / (double)(HISTORY_BASE_MS << level);
+    uint32_t available = lv->count < HISTORY_RING ? lv->count : HISTORY_RING;
+
+    for (int c = 0; c < columns; c++) {
+        // Bucket offsets back from the newest (0 = newest)
+        uint32_t first = (uint32_t)((columns - 1 - c) * per_column);
+        uint32_t last = (uint32_t)((columns - c) * per_column);
+        if (last <= first) last = first + 1;
+        if (last > available) last = available;
+
+        float mn = NAN, mx = NAN;
+        for (uint32_t o = first; o < last; o++) {
+            uint32_t idx = (lv->count - 1 - o) % HISTORY_RING;
+            mn = isnan(mn) ? lv->min[idx] : fminf(mn, lv->min[idx]);
+            mx = isnan(mx) ? lv->max[idx] : fmaxf(mx, lv->max[idx]);
+        }
+        out_min[c] = mn;
+        out_max[c] = mx;
+    }
+    return columns;
+}
+
+// Draw a graph as one vertical min-max bar per column, in a single geometry batch.
+// columns is normally the rect width; fewer columns trade resolution for speed.
+void history_graph_draw(HistoryGraph *graph, SDL_Renderer *renderer, FrameArena *arena, HistoryChannelId id,
+                        uint32_t span_ms, const SDL_FRect *rect, int columns, float lo, float hi, SDL_Color color) {
+    float col_min[HISTORY_MAX_COLUMNS];
+    float col_max[HISTORY_MAX_COLUMNS];
+    columns = history_graph_query(graph, id, span_ms, columns, col_min, col_max);
+    if (columns == 0) return;
+
+    SDL_Vertex *vertices = frame_arena_alloc(arena, sizeof(SDL_Vertex) * 4 * (size_t)columns);
+    if (!vertices) return;
+
+    SDL_FColor fc = {color.r / 255.0f, color.g / 255.0f, color.b / 255.0f, color.a / 255.0f};
+    float col_w = rect->w / columns;
+    float scale = rect->h / (hi - lo);
+    int quads = 0;
+
+    for (int c = 0; c < columns; c++) {
+        if (isnan(col_min[c])) continue;
+
+        float y_top = rect->y + rect->h - (fminf(fmaxf(col_max[c], lo), hi) - lo) * scale;
+        float y_bot = rect->y + rect->h - (fminf(fmaxf(col_min[c], lo), hi) - lo) * scale;
+        if (y_bot - y_top < 1.0f) y_bot = y_top + 1.0f;  // Flat segments stay visible
+        float x0 = rect->x + c * col_w;
+        float x1 = x0 + fmaxf(col_w, 1.0f);
+
+        SDL_Vertex *v = &vertices[quads * 4];
+        v[0] = (SDL_Vertex){{x0, y_top}, fc, {0, 0}};
+        v[1] = (SDL_Vertex){{x1, y_top}, fc, {0, 0}};
+        v[2] = (SDL_Vertex){{x0, y_bot}, fc, {0, 0}};
+        v[3] = (SDL_Vertex){{x1, y_bot}, fc, {0, 0}};
+        quads++;
+    }
+
+    if (quads > 0) {
+        SDL_RenderGeometry(renderer, NULL, vertices, quads * 4, graph->indices, quads * 6);
+    }
+}
@@ -0,0 +1,55 @@
+/*
+ * Snow-Pi History Graph Header
+ * Author: /x64/dumped
+ */
+
+#ifndef HISTORY_GRAPH_H
+#define HISTORY_GRAPH_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "sensor_channels.h"
+#include "frame_memory.h"
+
+#define HISTORY_LEVELS 7          // Level L buckets span HISTORY_BASE_MS << L
+#define HISTORY_RING 1024         // Buckets kept per level
+#define HISTORY_BASE_MS 125
+#define HISTORY_MAX_COLUMNS 512   // Widest graph; a span never needs more than 2 buckets per column
+
+// Graphed channels
+typedef enum {
+    HISTORY_BELT_TEMP,
+    HISTORY_RPM,
+    HISTORY_SPEED,
+    HISTORY_CHANNEL_COUNT
+} HistoryChannelId;
+
+typedef struct {
+    float min[HISTORY_RING];
+    float max[HISTORY_RING];
+    uint32_t count;   // Buckets ever written; newest is at (count - 1) % HISTORY_RING
+} HistoryLevel;
+
+typedef struct {
+    HistoryLevel levels[HISTORY_LEVELS];
+    float pending_min;
+    float pending_max;
+} HistoryChannel;
+
+// Min/max pyramid per channel, plus the fixed quad index pattern for drawing
+typedef struct {
+    HistoryChannel channels[HISTORY_CHANNEL_COUNT];
+    uint32_t pending_ms;
+    bool pending;
+    int indices[HISTORY_MAX_COLUMNS * 6];
+} HistoryGraph;
+
+void history_graph_init(HistoryGraph *graph);
+void history_graph_push(HistoryGraph *graph, const float *values, uint32_t dt_ms);
+int history_graph_query(const HistoryGraph *graph, HistoryChannelId id, uint32_t span_ms, int columns,
+                        float *out_min, float *out_max);
+void history_graph_draw(HistoryGraph *graph, SDL_Renderer *renderer, FrameArena *arena, HistoryChannelId id,
+                        uint32_t span_ms, const SDL_FRect *rect, int columns, float lo, float hi, SDL_Color color);
+
+#endif
@@ -16,6 +16,27 @@
 #include <time.h>
 #include <string.h>
 #include "map_viewer.h"
+#include "odometer_store.h"
+#include "sensor_filter.h"
+#include "sim_core.h"
+#include "warning_rules.h"
+#include "ride_stats.h"
+#include "history_graph.h"
+#include "telemetry_shm.h"
+#include "font_atlas.h"
+#include "frame_memory.h"
+#include "draw_list.h"
+#include "frame_pipeline.h"
+#include "texture_registry.h"
+#include "pixel_convert.h"
+#include "trail_index.h"
+#include "fuel_range.h"
+#include "place_search.h"
+#include "track_store.h"
+#include "quality_governor.h"
+#include "metrics_server.h"
+#include "metrics.h"
+#include "benchmark.h"
 
 #ifdef _WIN32
 #include <windows.h>
@@ -28,10 +49,18 @@
 #define M_PI 3.14159265358979323846
 #endif
 
-#define WINDOW_WIDTH 800
+#define WINDOW_WIDTH 800           // Default window size, override with --width/--height
 #define WINDOW_HEIGHT 480
+#define LAYOUT_HEIGHT 480          // Layout units per screen height; width follows the panel aspect
 #define FPS 30
 #define FRAME_DELAY (1000 / FPS)
+#define ODOMETER_STORE_PATH "snow-pi-odometer.dat"
+#define MAP_INSET_SIZE 125         // Gauge screen mini-map, in layout units
+
+// History graph zoom spans (LEFT/RIGHT on the graph page)
+static const Uint32 HISTORY_SPANS_MS[] = {60000, 300000, 900000, 1800000, 3600000, 7200000};
+static const char *HISTORY_SPAN_LABELS[] = {"1 MIN", "5 MIN", "15 MIN", "30 MIN", "1 HR", "2 HR"};
+#define HISTORY_SPAN_COUNT (int)(sizeof(HISTORY_SPANS_MS) / sizeof(HISTORY_SPANS_MS[0]))
 
 // Colors
 typedef struct {
@@ -62,9 +91,19 @@ typedef enum {
     DISPLAY_ODOMETER,
     DISPLAY_TRIP_A,
     DISPLAY_TRIP_B,
-    DISPLAY_ENGINE_HOURS
+    DISPLAY_RIDE_STATS,
+    DISPLAY_ENGINE_HOURS,
+    DISPLAY_MODE_COUNT
 } DisplayMode;
 
+// Ride statistics scopes (T cycles them on the stats page)
+typedef enum {
+    STATS_RIDE,
+    STATS_TRIP_A,
+    STATS_TRIP_B,
+    STATS_SCOPE_COUNT
+} StatsScope;
+
 // Dashboard data
 typedef struct {
     float speed;
@@ -76,63 +115,198 @@ typedef struct {
     float belt_temp;   // Critical for Polaris 600
     float fuel_level;
     float voltage;
-    float odometer;
-    float trip_a;
-    float trip_b;
-    float engine_hours;
+    double odometer;       // Doubles so small per-frame increments don't round away
+    double trip_a;
+    double trip_b;
+    double engine_hours;
     double latitude;
     double longitude;
     DriveMode drive_mode;
     DisplayMode display_mode;
-    bool warning_engine_temp;
-    bool warning_coolant_temp;
-    bool warning_belt_temp;
-    bool warning_low_fuel;
-    bool warning_low_voltage;
+    Uint32 warnings;   // Bitmask of active WarningId rules
+    Uint64 input_ns[LATENCY_CATEGORY_COUNT];  // Oldest input not yet presented (0 = none)
 } DashboardData;
 
+// Remember when an input arrived; the next present reports its latency
+static inline void stamp_input(DashboardData *data, LatencyCategory category, Uint64 timestamp_ns) {
+    if (data->input_ns[category] == 0) data->input_ns[category] = timestamp_ns;
+}
+
+// Everything the gauge screen is built from, copied on the main thread so
+// the render worker reads nothing the simulation is still changing
+typedef struct {
+    DashboardData data;
+    RideStats stats;                 // Scope shown on the stats page
+    StatsScope stats_scope;
+    const char *const *warning_messages;  // Compiled once at startup
+    Uint32 overlay_mask;
+    Uint32 critical_mask;
+    float gauge_segments_per_degree;
+    bool gauge_antialias;
+    int view_w;
+    int view_h;
+    int clock_hour;
+    int clock_minute;
+} GaugeSnapshot;
+
 // Application context
 typedef struct {
     SDL_Window *window;
     SDL_Renderer *renderer;
-    TTF_Font *font_digital_large;
-    TTF_Font *font_digital_medium;
-    TTF_Font *font_digital_small;
-    TTF_Font *font_arial_bold;
-    TTF_Font *font_arial_small;
+    FontAtlas fonts;
+    FrameArena frame_arena;     // Per-frame scratch, reset after every frame
+    TextureRegistry textures;   // Every long-lived texture, under one budget
+    int texture_budget_mb;
+    int window_w;               // Panel pixels
+    int window_h;
+    int view_w;                 // Layout units everything is drawn in
+    int view_h;
+    float render_scale;         // Internal resolution as a fraction of the panel
+    SDL_Texture *render_target; // Low-resolution frame, NULL when drawing at full resolution
+    int render_target_handle;
+    bool low_depth;             // --16bpp: RGB565 tiles and layers, ARGB4444 glyphs
+    SDL_PixelFormat tile_format;
+    SDL_PixelFormat glyph_format;
+    QualityGovernor governor;   // Trades cosmetic detail for frame time and SoC temperature
+    Uint64 thermal_next_ms;
+    Uint64 governor_last_ms;
     DashboardData data;
+    SimCore sim;                // Fixed-step vehicle model
+    SimInput input;             // Controls from the keyboard (or a script)
+    bool sim_started;
+    float filtered_prev[SENSOR_CHANNEL_COUNT];  // Filter output one step back, for interpolation
+    SensorFilterBank sensor_filters;
+    WarningRules warning_rules;
+    RideStats stats[STATS_SCOPE_COUNT];
+    StatsScope stats_scope;
+    HistoryGraph history;
+    int history_span;
+    TelemetryPublisher telemetry;
+    MetricsServer metrics_server;
+    Uint64 sensor_tick;
     MapViewer map_viewer;
+    PlaceSearch places;         // Name search over places.db, opened on first use
+    bool search_active;         // '/' on the map view; typing goes to the query
+    char search_text[PLACE_SEARCH_MAX_QUERY];
+    int search_selected;
+    bool map_browsing;          // Centred on a search result; the map stops following the vehicle
+    TrackStore track;           // Breadcrumb trail of this run, drawn over the map
+    FramePipeline pipeline;     // Gauge screen built on a worker a frame ahead of submission
+    Uint64 building_input_ns[LATENCY_CATEGORY_COUNT];  // Inputs in the list being built, shown next frame
+    DrawList ui_list;           // Shapes for the boot and graph pages, submitted right away
+    TrailIndex trails;          // Offline trail and no-go area grid (empty if trails.idx is missing)
+    FuelRange fuel_range;       // Trails reachable on the fuel left (needs a v2 trails.idx)
+    OdometerStore odometer_store;
     bool running;
     bool boot_complete;
     bool show_map;
+    bool show_inset;            // Mini-map on the gauge screen
+    bool show_graphs;
+    bool show_profiler;
     Uint32 last_frame_time;
     Uint32 boot_start_time;
 } AppContext;
 
 // Function prototypes
 void init_sdl(AppContext *ctx);
+void init_dashboard_state(AppContext *ctx);
+void bench_frame(void *user, int frame);
 void cleanup_sdl(AppContext *ctx);
+OdometerCounters odometer_counters(const AppContext *ctx);
 void handle_events(AppContext *ctx);
 void update_dashboard(AppContext *ctx);
+void sim_tick(AppContext *ctx, const SimInput *input);
+void open_search(AppContext *ctx);
+void handle_search_key(AppContext *ctx, SDL_Keycode key);
+void follow_vehicle(AppContext *ctx);
+void draw_search_panel(AppContext *ctx);
+void update_trail_position(AppContext *ctx, const SimState *v, float raw[SENSOR_CHANNEL_COUNT]);
+int run_simulation(AppContext *ctx, const char *script_path);
 void render_dashboard(AppContext *ctx);
-void draw_filled_circle(SDL_Renderer *renderer, int cx, int cy, int radius);
-void draw_circle(SDL_Renderer *renderer, int cx, int cy, int radius);
-void draw_arc(SDL_Renderer *renderer, int cx, int cy, int radius, float start_angle, float end_angle, int thickness);
-void draw_rounded_rect(SDL_Renderer *renderer, int x, int y, int w, int h, int radius);
-void draw_filled_rounded_rect(SDL_Renderer *renderer, int x, int y, int w, int h, int radius);
-void draw_gauge(AppContext *ctx, int cx, int cy, int radius, float value, float max_value, bool is_primary);
+void fill_gauge_snapshot(AppContext *ctx, GaugeSnapshot *snap);
+void build_gauge_screen(DrawList *list, const void *snapshot);
+void draw_gauge(DrawList *list, const GaugeSnapshot *snap, int cx, int cy, int radius, float value, float max_value,
+                bool is_primary);
 void draw_number(SDL_Renderer *renderer, int value, int x, int y, int size, Color color);
 void draw_digit(SDL_Renderer *renderer, int digit, int x, int y, int width, int height, Color color);
 void draw_label(SDL_Renderer *renderer, const char *text, int x, int y, int size, Color color);
-void draw_text_ttf(SDL_Renderer *renderer, TTF_Font *font, const char *text, int x, int y, Color color, bool centered);
-void draw_drive_mode(AppContext *ctx, int x, int y, int size);
+void draw_text(AppContext *ctx, FontFace face, const char *text, int x, int y, Color color, bool centered);
+void record_text(DrawList *list, FontFace face, const char *text, int x, int y, Color color, bool centered);
+void draw_drive_mode(DrawList *list, DriveMode mode, int x, int y, int size);
 void draw_boot_screen(AppContext *ctx);
+void draw_stats_page(DrawList *list, const RideStats *stats, StatsScope scope, int x, int y, int w);
+void draw_history_page(AppContext *ctx);
+void publish_telemetry(AppContext *ctx);
+void update_quality(AppContext *ctx, Uint32 frame_us);
+void begin_frame(AppContext *ctx);
+void present_frame(AppContext *ctx);
+void draw_profiler(AppContext *ctx);
 
 int main(int argc, char *argv[]) {
-    (void)argc;  // Unused
-    (void)argv;  // Unused
+    static AppContext ctx;  // Too large for the stack (history buffers)
+    
+    // Command line options
+    bool bench = false;
+    const char *simulate_script = NULL;
+    const char *route_path = NULL;
+    double corridor_m = TILE_PACK_CORRIDOR_M;
+    ctx.texture_budget_mb = TEXTURE_BUDGET_DEFAULT_MB;
+    ctx.window_w = WINDOW_WIDTH;
+    ctx.window_h = WINDOW_HEIGHT;
+    ctx.render_scale = 1.0f;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--bench") == 0) {
+            bench = true;
+        } else if (strcmp(argv[i], "--texture-budget") == 0 && i + 1 < argc) {
+            ctx.texture_budget_mb = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--width") == 0 && i + 1 < argc) {
+            ctx.window_w = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--height") == 0 && i + 1 < argc) {
+            ctx.window_h = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--simulate") == 0 && i + 1 < argc) {
+            simulate_script = argv[++i];
+        } else if (strcmp(argv[i], "--16bpp") == 0) {
+            ctx.low_depth = true;
+        } else if (strcmp(argv[i], "--render-scale") == 0 && i + 1 < argc) {
+            ctx.render_scale = (float)atof(argv[++i]);
+        } else if (strcmp(argv[i], "--route") == 0 && i + 1 < argc) {
+            route_path = argv[++i];
+        } else if (strcmp(argv[i], "--corridor-km") == 0 && i + 1 < argc) {
+            corridor_m = atof(argv[++i]) * 1000.0;
+        }
+    }
+    if (ctx.window_w <= 0 || ctx.window_h <= 0) {
+        ctx.window_w = WINDOW_WIDTH;
+        ctx.window_h = WINDOW_HEIGHT;
+    }
+    if (!(ctx.render_scale >= 0.25f && ctx.render_scale <= 1.0f)) {
+        fprintf(stderr, "Render scale must be between 0.25 and 1, using 1\n");
+        ctx.render_scale = 1.0f;
+    }
     
-    AppContext ctx = {0};
+    // Headless: scripted inputs through the model, filters, warnings and telemetry
+    if (simulate_script) {
+        return run_simulation(&ctx, simulate_script);
+    }
+    
+    // Micro-benchmarks plus a frame loop on an offscreen window
+    if (bench) {
+        alloc_counter_install();  // Before SDL allocates anything
+        SDL_SetHint(SDL_HINT_VIDEO_DRIVER, "offscreen");
+        SDL_SetHint(SDL_HINT_RENDER_DRIVER, "software");
+        init_sdl(&ctx);
+        init_dashboard_state(&ctx);
+        ctx.boot_complete = true;
+        // Keep away from the odometer file, shared memory and socket of a live dashboard
+        ctx.odometer_store.fd = -1;
+        ctx.telemetry.fd = -1;
+        ctx.metrics_server.listen_fd = ctx.metrics_server.epoll_fd = -1;
+        int result = run_benchmarks(bench_frame, &ctx);
+        cleanup_sdl(&ctx);
+        return result;
+    }
+    
+    Uint64 start_ns = SDL_GetTicksNS();  // Cold start reference for time-to-first-frame
     
     printf("=======================================================\n");
     printf("Snow-Pi Digital Dashboard\n");
@@ -141,29 +315,86 @@ int main(int argc, char *argv[]) {
     
     init_sdl(&ctx);
     
-    ctx.running = true;
-    ctx.boot_complete = false;
-    ctx.show_map = false;
-    ctx.boot_start_time = SDL_GetTicks();
-    ctx.last_frame_time = SDL_GetTicks();
-    ctx.data.drive_mode = MODE_DRIVE;
-    ctx.data.display_mode = DISPLAY_ODOMETER;
-    ctx.data.throttle = 0.0f;
-    ctx.data.target_rpm = 0.0f;
-    
-    // Initialize map viewer
-    if (!map_viewer_init(&ctx.map_viewer, "osm-2020-02-10-v3.11_canada_ontario.mbtiles", ctx.renderer)) {
+    init_dashboard_state(&ctx);
+    
+    // Live telemetry for companion processes (loggers, helmet bridge, diagnostics)
+    if (telemetry_shm_create(&ctx.telemetry)) {
+        printf("Telemetry published at %s\n", TELEMETRY_SHM_NAME);
+    }
+    if (metrics_server_start(&ctx.metrics_server, METRICS_SOCKET_PATH)) {
+        printf("Metrics endpoint listening on %s\n", METRICS_SOCKET_PATH);
+    }
+    
+    // Restore odometer, trips and engine hours from the last run
+    Uint64 load_start = SDL_GetTicksNS();
+    OdometerCounters counters = {1234.5, 0.0, 0.0, 127.5, NAN, NAN};  // First-boot defaults
+    if (odometer_store_open(&ctx.odometer_store, ODOMETER_STORE_PATH, &counters)) {
+        printf("Odometer restored in %.1f us (%.1f mi, %.1f hrs)\n",
+               (SDL_GetTicksNS() - load_start) / 1000.0, counters.odometer, counters.engine_hours);
+    } else {
+        printf("No saved odometer found, starting fresh\n");
+    }
+    ctx.data.odometer = counters.odometer;
+    ctx.data.trip_a = counters.trip_a;
+    ctx.data.trip_b = counters.trip_b;
+    ctx.data.engine_hours = counters.engine_hours;
+    
+    // Initialize map viewer (database opens in the background)
+    if (!map_viewer_init(&ctx.map_viewer, "osm-2020-02-10-v3.11_canada_ontario.mbtiles", ctx.renderer, &ctx.frame_arena,
+                         &ctx.textures, ctx.tile_format)) {
         printf("Warning: Could not load map tiles. Map view disabled.\n");
     }
     
+    // Hold the tiles along the planned route (or around where the last ride
+    // ended) in RAM so the ride itself rarely reads the SD card
+    bool have_position = isfinite(counters.latitude) && isfinite(counters.longitude);
+    if (have_position) map_viewer_recenter(&ctx.map_viewer, counters.latitude, counters.longitude);
+    double *route = NULL;
+    int route_points = 0;
+    if (route_path && tile_pack_load_route(route_path, &route, &route_points)) {
+        printf("Route %s: %d points, %.1f km corridor\n", route_path, route_points, corridor_m / 1000.0);
+        map_viewer_preseed(&ctx.map_viewer, route, route_points, corridor_m);
+    } else if (have_position && (route = malloc(2 * sizeof(double))) != NULL) {
+        route[0] = counters.latitude;
+        route[1] = counters.longitude;
+        map_viewer_preseed(&ctx.map_viewer, route, 1, corridor_m);
+    }
+    if (trail_index_open(&ctx.trails, TRAIL_INDEX_PATH)) {
+        printf("Trail index loaded: %u segments, %u restricted areas\n", ctx.trails.header->segment_count,
+               ctx.trails.header->area_count);
+        if (fuel_range_open(&ctx.fuel_range, &ctx.trails, &ctx.frame_arena)) {
+            map_viewer_set_layer_overlay(&ctx.map_viewer, fuel_range_draw, &ctx.fuel_range);
+            printf("Fuel range graph: %u nodes, %u fuel stations\n", ctx.trails.header->node_count,
+                   ctx.trails.header->fuel_count);
+        }
+    } else {
+        printf("No trail index (%s), trail snapping and geofence warnings disabled\n", TRAIL_INDEX_PATH);
+    }
+    const QualityProfile *profile = quality_governor_profile(&ctx.governor);
+    map_viewer_set_quality(&ctx.map_viewer, profile->map_refresh_ms, profile->prefetch_radius,
+                           profile->inset_refresh_ms);
+    
     // Main loop
     while (ctx.running) {
         Uint32 frame_start = SDL_GetTicks();
+        Uint64 frame_start_ns = SDL_GetTicksNS();
         
         handle_events(&ctx);
         update_dashboard(&ctx);
         render_dashboard(&ctx);
         
+        if (dash_metrics.first_frame_us == 0) {
+            dash_metrics.first_frame_us = (SDL_GetTicksNS() - start_ns) / 1000;
+            printf("First frame presented %.1f ms after start\n", dash_metrics.first_frame_us / 1000.0);
+        }
+        
+        frame_arena_reset(&ctx.frame_arena);
+        texture_registry_frame_end(&ctx.textures);
+        Uint32 frame_us = (Uint32)((SDL_GetTicksNS() - frame_start_ns) / 1000);
+        metrics_frame_end(frame_us);
+        update_quality(&ctx, frame_us);
+        metrics_server_poll(&ctx.metrics_server);
+        
         // Frame rate limiting
         Uint32 frame_time = SDL_GetTicks() - frame_start;
         if (frame_time < FRAME_DELAY) {
@@ -182,7 +413,7 @@ void init_sdl(AppContext *ctx) {
     }
     
     // Create window with renderer (SDL3 style)
-    if (!SDL_CreateWindowAndRenderer("Snow-Pi Dashboard", WINDOW_WIDTH, WINDOW_HEIGHT, 
+    if (!SDL_CreateWindowAndRenderer("Snow-Pi Dashboard", ctx->window_w, ctx->window_h, 
                                       0, &ctx->window, &ctx->renderer)) {
         fprintf(stderr, "Window/Renderer creation failed: %s\n", SDL_GetError());
         exit(1);
@@ -199,30 +430,158 @@ void init_sdl(AppContext *ctx) {
         exit(1);
     }
     
-    // Load fonts
-    ctx->font_digital_large = TTF_OpenFont("digital.ttf", 64);
-    ctx->font_digital_medium = TTF_OpenFont("digital.ttf", 42);
-    ctx->font_digital_small = TTF_OpenFont("digital.ttf", 28);
-    ctx->font_arial_bold = TTF_OpenFont("Arial.ttf", 24);
-    ctx->font_arial_small = TTF_OpenFont("Arial.ttf", 16);
+    // Upload the baked glyph atlas; font files are only opened if a glyph is missing
+    if (!frame_arena_init(&ctx->frame_arena, FRAME_ARENA_SIZE)) {
+        exit(1);
+    }
+    texture_registry_init(&ctx->textures, ctx->renderer, (size_t)ctx->texture_budget_mb * 1024 * 1024);
+    
+    // 16-bit formats only pay off if the renderer keeps them as-is
+    ctx->tile_format = SDL_PIXELFORMAT_XRGB8888;
+    ctx->glyph_format = SDL_PIXELFORMAT_ARGB8888;
+    if (ctx->low_depth) {
+        if (pixel_format_supported(ctx->renderer, SDL_PIXELFORMAT_RGB565)) {
+            ctx->tile_format = SDL_PIXELFORMAT_RGB565;
+        }
+        if (pixel_format_supported(ctx->renderer, SDL_PIXELFORMAT_ARGB4444)) {
+            ctx->glyph_format = SDL_PIXELFORMAT_ARGB4444;
+        }
+        printf("16 bpp pipeline: tiles %s, glyphs %s\n", SDL_GetPixelFormatName(ctx->tile_format),
+               SDL_GetPixelFormatName(ctx->glyph_format));
+    }
+    
+    if (!font_atlas_init(&ctx->fonts, ctx->renderer, &ctx->frame_arena, &ctx->textures, ctx->glyph_format)) {
+        fprintf(stderr, "Font atlas unavailable, falling back to TTF rendering\n");
+    }
     
-    if (!ctx->font_digital_large || !ctx->font_digital_medium || !ctx->font_digital_small ||
-        !ctx->font_arial_bold || !ctx->font_arial_small) {
-        fprintf(stderr, "Font loading failed: %s\n", SDL_GetError());
-        fprintf(stderr, "Make sure digital.ttf and Arial.ttf are in the same directory\n");
+    // Gauge screen recording runs on its own core; buffers are allocated once here
+    if (!frame_pipeline_init(&ctx->pipeline, build_gauge_screen, sizeof(GaugeSnapshot)) ||
+        !draw_list_init(&ctx->ui_list)) {
         exit(1);
     }
     
+    // Layout is a fixed height; wide panels get more horizontal room
+    ctx->view_h = LAYOUT_HEIGHT;
+    ctx->view_w = LAYOUT_HEIGHT * ctx->window_w / ctx->window_h;
+    
+    // Fill-rate-bound boards draw at a fraction of the panel and upscale once
+    ctx->render_target = NULL;
+    ctx->render_target_handle = -1;
+    if (ctx->render_scale < 1.0f) {
+        int target_w = (int)(ctx->window_w * ctx->render_scale);
+        int target_h = (int)(ctx->window_h * ctx->render_scale);
+        ctx->render_target_handle = texture_registry_create(&ctx->textures, SDL_PIXELFORMAT_XRGB8888,
+                                                            SDL_TEXTUREACCESS_TARGET, target_w, target_h,
+                                                            TEXTURE_STATIC, NULL, NULL, NULL, &ctx->render_target);
+        if (ctx->render_target) {
+            SDL_SetTextureScaleMode(ctx->render_target, SDL_SCALEMODE_LINEAR);
+            printf("Rendering at %dx%d, scaled to %dx%d\n", target_w, target_h, ctx->window_w, ctx->window_h);
+        } else {
+            fprintf(stderr, "Render target unavailable, drawing at full resolution\n");
+        }
+    }
+    
     printf("SDL3 and fonts initialized successfully\n");
 }
 
+// Dashboard state shared by the normal run and the frame benchmark
+void init_dashboard_state(AppContext *ctx) {
+    ctx->running = true;
+    ctx->boot_complete = false;
+    ctx->show_map = false;
+    ctx->show_inset = true;
+    ctx->boot_start_time = SDL_GetTicks();
+    ctx->last_frame_time = SDL_GetTicks();
+    ctx->data.drive_mode = MODE_DRIVE;
+    ctx->data.display_mode = DISPLAY_ODOMETER;
+    ctx->data.throttle = 0.0f;
+    ctx->data.target_rpm = 0.0f;
+    sensor_filter_init(&ctx->sensor_filters, SENSOR_FILTER_TABLE, SENSOR_FILTER_TABLE_SIZE);
+    warning_rules_compile(&ctx->warning_rules, WARNING_RULE_TABLE, WARNING_RULE_TABLE_SIZE);
+    for (int i = 0; i < STATS_SCOPE_COUNT; i++) {
+        ride_stats_reset(&ctx->stats[i]);
+    }
+    history_graph_init(&ctx->history);
+    track_store_init(&ctx->track);
+    quality_governor_init(&ctx->governor, FRAME_DELAY, QUALITY_HIGH);
+    ctx->thermal_next_ms = 0;
+    ctx->governor_last_ms = SDL_GetTicks();
+}
+
+// Feed the governor one frame; SoC sensors are read once a second
+void update_quality(AppContext *ctx, Uint32 frame_us) {
+    Uint64 now = SDL_GetTicks();
+    ThermalReading reading;
+    const ThermalReading *thermal = NULL;
+    if (now >= ctx->thermal_next_ms) {
+        ctx->thermal_next_ms = now + QUALITY_THERMAL_PERIOD_MS;
+        if (quality_governor_read_thermal(&reading)) thermal = &reading;
+    }
+    
+    QualityLevel before = ctx->governor.level;
+    QualityLevel level = quality_governor_update(&ctx->governor, frame_us / 1000.0f, thermal,
+                                                 (uint32_t)(now - ctx->governor_last_ms));
+    ctx->governor_last_ms = now;
+    
+    dash_metrics.quality_level = (uint32_t)level;
+    dash_metrics.quality_changes = ctx->governor.changes;
+    dash_metrics.soc_temp_c = ctx->governor.thermal.temp_c;
+    dash_metrics.cpu_khz = ctx->governor.thermal.cur_khz;
+    
+    if (level != before) {
+        const QualityProfile *profile = quality_governor_profile(&ctx->governor);
+        map_viewer_set_quality(&ctx->map_viewer, profile->map_refresh_ms, profile->prefetch_radius,
+                               profile->inset_refresh_ms);
+        printf("Quality %s -> %s (p90 %.1f ms, SoC %.1f C, %d MHz)\n", QUALITY_PROFILES[before].name, profile->name,
+               ctx->governor.change_p90, ctx->governor.thermal.temp_c, ctx->governor.thermal.cur_khz / 1000);
+    }
+}
+
+// One benchmark frame; cycles the gauge, stats and graph pages
+void bench_frame(void *user, int frame) {
+    AppContext *ctx = user;
+    int page = (frame / 50) % 3;
+    ctx->show_graphs = page == 2;
+    ctx->data.display_mode = page == 1 ? DISPLAY_RIDE_STATS : DISPLAY_ODOMETER;
+    
+    update_dashboard(ctx);
+    render_dashboard(ctx);
+    frame_arena_reset(&ctx->frame_arena);
+    texture_registry_frame_end(&ctx->textures);
+}
+
+// Counters to persist; the position is only known once the model is running
+OdometerCounters odometer_counters(const AppContext *ctx) {
+    OdometerCounters counters = {ctx->data.odometer, ctx->data.trip_a, ctx->data.trip_b, ctx->data.engine_hours,
+                                 ctx->odometer_store.saved.latitude, ctx->odometer_store.saved.longitude};
+    if (ctx->sim_started) {
+        counters.latitude = ctx->data.latitude;
+        counters.longitude = ctx->data.longitude;
+    }
+    return counters;
+}
+
 void cleanup_sdl(AppContext *ctx) {
+    // Final save so nothing since the last coalesced write is lost
+    OdometerCounters counters = odometer_counters(ctx);
+    odometer_store_flush(&ctx->odometer_store, &counters, SDL_GetTicks());
+    odometer_store_close(&ctx->odometer_store);
+    telemetry_shm_destroy(&ctx->telemetry);
+    metrics_server_stop(&ctx->metrics_server);
+    
+    frame_pipeline_cleanup(&ctx->pipeline);
+    draw_list_free(&ctx->ui_list);
     map_viewer_cleanup(&ctx->map_viewer);
-    if (ctx->font_digital_large) TTF_CloseFont(ctx->font_digital_large);
-    if (ctx->font_digital_medium) TTF_CloseFont(ctx->font_digital_medium);
-    if (ctx->font_digital_small) TTF_CloseFont(ctx->font_digital_small);
-    if (ctx->font_arial_bold) TTF_CloseFont(ctx->font_arial_bold);
-    if (ctx->font_arial_small) TTF_CloseFont(ctx->font_arial_small);
+    fuel_range_close(&ctx->fuel_range);
+    trail_index_close(&ctx->trails);
+    place_search_close(&ctx->places);
+    font_atlas_cleanup(&ctx->fonts);
+    texture_registry_destroy(&ctx->textures, ctx->render_target_handle);
+    ctx->render_target = NULL;
+    printf("Textures: peak %.1f of %d MB budget, %llu evictions\n", ctx->textures.peak / (1024.0 * 1024.0),
+           ctx->texture_budget_mb, (unsigned long long)ctx->textures.evictions);
+    texture_registry_cleanup(&ctx->textures);
+    frame_arena_destroy(&ctx->frame_arena);
     if (ctx->renderer) SDL_DestroyRenderer(ctx->renderer);
     if (ctx->window) SDL_DestroyWindow(ctx->window);
     TTF_Quit();
@@ -230,6 +589,7 @@ void cleanup_sdl(AppContext *ctx) {
 }
 
 void handle_events(AppContext *ctx) {
+    const bool *keys = SDL_GetKeyboardState(NULL);
     SDL_Event event;
     while (SDL_PollEvent(&event)) {
         switch (event.type) {
@@ -237,19 +597,48 @@ void handle_events(AppContext *ctx) {
                 ctx->running = false;
                 break;
             case SDL_EVENT_KEY_DOWN:
-                if (event.key.key == SDLK_ESCAPE || event.key.key == SDLK_Q) {
+                stamp_input(&ctx->data, LATENCY_KEY, event.key.timestamp);
+                // The search box takes every key while it is open
+                if (ctx->search_active) {
+                    handle_search_key(ctx, event.key.key);
+                    break;
+                }
+                // Esc first leaves a search result and goes back to the vehicle
+                if (event.key.key == SDLK_ESCAPE && ctx->map_browsing) {
+                    follow_vehicle(ctx);
+                }
+                else if (event.key.key == SDLK_ESCAPE || event.key.key == SDLK_Q) {
                     ctx->running = false;
                 }
                 // M to toggle between Drive/Reverse
                 else if (event.key.key == SDLK_M) {
                     ctx->data.drive_mode = (ctx->data.drive_mode == MODE_DRIVE) ? MODE_REVERSE : MODE_DRIVE;
+                    ctx->input.reverse = ctx->data.drive_mode == MODE_REVERSE;
                 }
                 // S to scroll display modes (Polaris-style)
                 else if (event.key.key == SDLK_S) {
-                    ctx->data.display_mode = (ctx->data.display_mode + 1) % 4;
+                    ctx->data.display_mode = (ctx->data.display_mode + 1) % DISPLAY_MODE_COUNT;
+                }
+                // T resets the shown trip, or cycles the stats scope on the stats page
+                else if (event.key.key == SDLK_T) {
+                    if (ctx->data.display_mode == DISPLAY_RIDE_STATS) {
+                        ctx->stats_scope = (ctx->stats_scope + 1) % STATS_SCOPE_COUNT;
+                    } else if (ctx->data.display_mode == DISPLAY_TRIP_A || ctx->data.display_mode == DISPLAY_TRIP_B) {
+                        if (ctx->data.display_mode == DISPLAY_TRIP_A) {
+                            ctx->data.trip_a = 0;
+                            ride_stats_reset(&ctx->stats[STATS_TRIP_A]);
+                        } else {
+                            ctx->data.trip_b = 0;
+                            ride_stats_reset(&ctx->stats[STATS_TRIP_B]);
+                        }
+                        // Save the reset right away rather than waiting for the next coalesced write
+                        OdometerCounters counters = odometer_counters(ctx);
+                        odometer_store_flush(&ctx->odometer_store, &counters, SDL_GetTicks());
+                    }
                 }
                 // TAB to toggle map view
                 else if (event.key.key == SDLK_TAB) {
+                    if (ctx->map_browsing) follow_vehicle(ctx);
                     ctx->show_map = !ctx->show_map;
                     map_viewer_toggle(&ctx->map_viewer);
                 }
@@ -261,24 +650,108 @@ void handle_events(AppContext *ctx) {
                     else if (event.key.key == SDLK_DOWN) map_viewer_pan(&ctx->map_viewer, 0, 50);
                     else if (event.key.key == SDLK_EQUALS || event.key.key == SDLK_PLUS) map_viewer_zoom(&ctx->map_viewer, 1);
                     else if (event.key.key == SDLK_MINUS) map_viewer_zoom(&ctx->map_viewer, -1);
+                    else if (event.key.key == SDLK_SLASH) open_search(ctx);
+                    else if (event.key.key == SDLK_H) map_viewer_toggle_heading_up(&ctx->map_viewer);
+                }
+                // N to toggle the mini-map on the gauge screen
+                else if (event.key.key == SDLK_N) {
+                    ctx->show_inset = !ctx->show_inset;
+                }
+                // P to toggle the profiler overlay
+                else if (event.key.key == SDLK_P) {
+                    ctx->show_profiler = !ctx->show_profiler;
+                }
+                // G to toggle history graphs
+                else if (event.key.key == SDLK_G) {
+                    ctx->show_graphs = !ctx->show_graphs;
+                }
+                // Arrow keys change the graph span (when graphs are shown)
+                else if (ctx->show_graphs && event.key.key == SDLK_LEFT) {
+                    ctx->history_span = ctx->history_span > 0 ? ctx->history_span - 1 : 0;
+                }
+                else if (ctx->show_graphs && event.key.key == SDLK_RIGHT) {
+                    ctx->history_span = ctx->history_span < HISTORY_SPAN_COUNT - 1 ? ctx->history_span + 1 : HISTORY_SPAN_COUNT - 1;
                 }
                 else if (event.key.key == SDLK_SPACE) {
                     // Space to skip boot screen
                     ctx->boot_complete = true;
                 }
                 break;
+            case SDL_EVENT_TEXT_INPUT:
+                if (ctx->search_active) {
+                    size_t len = strlen(ctx->search_text);
+                    // The '/' that opened the search can arrive as text too
+                    if (len == 0 && strcmp(event.text.text, "/") == 0) break;
+                    if (len + strlen(event.text.text) < sizeof(ctx->search_text)) {
+                        strcat(ctx->search_text, event.text.text);
+                        place_search_query(&ctx->places, ctx->search_text);
+                        ctx->search_selected = 0;
+                    }
+                }
+                break;
         }
     }
     
-    // Throttle control - hold key to throttle
-    const bool *keys = SDL_GetKeyboardState(NULL);
-    if (keys[SDL_SCANCODE_R] || keys[SDL_SCANCODE_UP]) {
-        // Throttle up
-        ctx->data.throttle = fminf(ctx->data.throttle + 0.05f, 1.0f);
-    } else {
-        // Release throttle
-        ctx->data.throttle = fmaxf(ctx->data.throttle - 0.08f, 0.0f);
+    // No driving while typing a search
+    if (ctx->search_active) {
+        ctx->input.throttle_target = 0.0f;
+        ctx->input.steer = 0.0f;
+        return;
     }
+    
+    // Throttle control - hold key to throttle; the model ramps it
+    ctx->input.throttle_target = (keys[SDL_SCANCODE_R] || keys[SDL_SCANCODE_UP]) ? 1.0f : 0.0f;
+    
+    // A/D steer, which turns the simulated heading
+    ctx->input.steer = (keys[SDL_SCANCODE_D] ? 1.0f : 0.0f) - (keys[SDL_SCANCODE_A] ? 1.0f : 0.0f);
+}
+
+// Open the search box; the index is opened the first time it is needed
+void open_search(AppContext *ctx) {
+    if (!ctx->places.db && !ctx->places.failed) {
+        Uint64 start = SDL_GetTicksNS();
+        if (place_search_open(&ctx->places, PLACE_INDEX_PATH)) {
+            printf("Place index opened in %.1f ms\n", (SDL_GetTicksNS() - start) / 1e6);
+        }
+    }
+    ctx->search_active = true;
+    ctx->search_text[0] = '\0';
+    ctx->search_selected = 0;
+    ctx->places.count = 0;
+    SDL_StartTextInput(ctx->window);
+}
+
+// Editing and result selection; ENTER jumps the map to the chosen place
+void handle_search_key(AppContext *ctx, SDL_Keycode key) {
+    size_t len = strlen(ctx->search_text);
+    if (key == SDLK_ESCAPE) {
+        ctx->search_active = false;
+    } else if (key == SDLK_BACKSPACE && len > 0) {
+        // Drop a whole UTF-8 character
+        do {
+            len--;
+        } while (len > 0 && ((unsigned char)ctx->search_text[len] & 0xC0) == 0x80);
+        ctx->search_text[len] = '\0';
+        place_search_query(&ctx->places, ctx->search_text);
+        ctx->search_selected = 0;
+    } else if (key == SDLK_UP) {
+        ctx->search_selected = ctx->search_selected > 0 ? ctx->search_selected - 1 : 0;
+    } else if (key == SDLK_DOWN) {
+        if (ctx->search_selected + 1 < ctx->places.count) ctx->search_selected++;
+    } else if (key == SDLK_RETURN && ctx->places.count > 0) {
+        const PlaceResult *place = &ctx->places.results[ctx->search_selected];
+        map_viewer_recenter(&ctx->map_viewer, place->latitude, place->longitude);
+        printf("Map centered on %s (%s)\n", place->name, place->kind);
+        ctx->search_active = false;
+        ctx->map_browsing = true;
+    }
+    if (!ctx->search_active) SDL_StopTextInput(ctx->window);
+}
+
+// Leave a search result: the map centres on the vehicle and follows it again
+void follow_vehicle(AppContext *ctx) {
+    ctx->map_browsing = false;
+    map_viewer_recenter(&ctx->map_viewer, ctx->data.latitude, ctx->data.longitude);
 }
 
 void update_dashboard(AppContext *ctx) {
@@ -287,114 +760,190 @@ void update_dashboard(AppContext *ctx) {
         Uint32 elapsed = SDL_GetTicks() - ctx->boot_start_time;
         if (elapsed > 3000) {  // 3 second boot
             ctx->boot_complete = true;
-            // Initialize data to zero on boot complete
-            ctx->data.speed = 0;
-            ctx->data.rpm = 1000;  // Idle RPM
-            ctx->data.target_rpm = 1000;
-            ctx->data.engine_temp = 70;
-            ctx->data.coolant_temp = 65;
-            ctx->data.belt_temp = 80;  // Belt starts cool
-            ctx->data.fuel_level = 85;
-            ctx->data.voltage = 13.8f;
-            ctx->data.odometer = 1234.5f;
-            ctx->data.trip_a = 0;
-            ctx->data.trip_b = 0;
-            ctx->data.engine_hours = 127.5f;  // Example hours
         }
         return;
     }
     
-    // Calculate delta time
+    // The model starts at idle once the boot screen is gone (timed out or skipped),
+    // so the boot time is never fed in as one huge step
+    if (!ctx->sim_started) {
+        sim_core_init(&ctx->sim, ctx->map_viewer.center_lat, ctx->map_viewer.center_lon, (Uint32)SDL_GetTicksNS());
+        sensor_filter_reset(&ctx->sensor_filters);
+        ctx->last_frame_time = SDL_GetTicks();
+        ctx->sim_started = true;
+        // Odometer, trips and engine hours were restored from the store at startup
+    }
+    
+    // Run every fixed step that is due
     Uint32 current_time = SDL_GetTicks();
-    float dt = (current_time - ctx->last_frame_time) / 1000.0f; // Delta in seconds
+    int steps = sim_core_accumulate(&ctx->sim, current_time - ctx->last_frame_time);
     ctx->last_frame_time = current_time;
-    
-    // Realistic engine physics
-    float idle_rpm = 1000.0f;
-    float max_rpm = 9000.0f;
-    
-    // Target RPM based on throttle
-    ctx->data.target_rpm = idle_rpm + (max_rpm - idle_rpm) * ctx->data.throttle;
-    
-    // RPM responds to throttle with some lag (acceleration/deceleration)
-    float rpm_diff = ctx->data.target_rpm - ctx->data.rpm;
-    float rpm_accel_rate = 3000.0f; // RPM per second when throttling
-    float rpm_decel_rate = 2000.0f; // RPM per second when releasing
-    
-    if (rpm_diff > 0) {
-        ctx->data.rpm += fminf(rpm_diff, rpm_accel_rate * dt);
-    } else {
-        ctx->data.rpm += fmaxf(rpm_diff, -rpm_decel_rate * dt);
+    for (int i = 0; i < steps; i++) {
+        sim_tick(ctx, &ctx->input);
     }
     
-    // Speed is derived from RPM and gear (simplified)
-    // In forward mode, higher RPM = higher speed
-    // In reverse, speed is limited
-    float target_speed = 0;
-    
-    if (ctx->data.drive_mode == MODE_DRIVE) {
-        // Forward: speed proportional to RPM above idle
-        float rpm_above_idle = fmaxf(0, ctx->data.rpm - idle_rpm);
-        target_speed = (rpm_above_idle / (max_rpm - idle_rpm)) * 120.0f; // Max 120 MPH
-    } else {
-        // Reverse: limited speed
-        float rpm_above_idle = fmaxf(0, ctx->data.rpm - idle_rpm);
-        target_speed = -(rpm_above_idle / (max_rpm - idle_rpm)) * 25.0f; // Max 25 MPH reverse
+    // Gauges show a blend of the last two steps so motion is smooth at any frame rate
+    float alpha = sim_core_alpha(&ctx->sim);
+    const float *filtered = ctx->sensor_filters.out;
+    float shown[SENSOR_CHANNEL_COUNT];
+    for (int ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++) {
+        shown[ch] = ctx->filtered_prev[ch] + (filtered[ch] - ctx->filtered_prev[ch]) * alpha;
     }
-    
-    // Speed has momentum and drag
-    float speed_diff = target_speed - ctx->data.speed;
-    float accel_rate = 40.0f; // MPH per second
-    float drag_rate = 60.0f;  // Deceleration from drag
-    
-    if (fabsf(speed_diff) < 0.1f) {
-        ctx->data.speed = target_speed;
-    } else if (speed_diff > 0) {
-        ctx->data.speed += fminf(speed_diff, accel_rate * dt);
-    } else {
-        ctx->data.speed += fmaxf(speed_diff, -drag_rate * dt);
+    ctx->data.speed = shown[SENSOR_SPEED];
+    ctx->data.rpm = shown[SENSOR_RPM];
+    ctx->data.engine_temp = shown[SENSOR_ENGINE_TEMP];
+    ctx->data.coolant_temp = shown[SENSOR_COOLANT_TEMP];
+    ctx->data.belt_temp = shown[SENSOR_BELT_TEMP];
+    ctx->data.fuel_level = shown[SENSOR_FUEL_LEVEL];
+    ctx->data.voltage = shown[SENSOR_VOLTAGE];
+    
+    // Follow the vehicle while it moves; when stopped the map can be panned freely,
+    // and it stays on a search result until Esc or TAB
+    if (steps > 0 && ctx->sim.curr.step_miles > 0) {
+        if (!ctx->map_browsing) map_viewer_update_position(&ctx->map_viewer, ctx->data.latitude, ctx->data.longitude);
+        map_viewer_set_heading(&ctx->map_viewer, ctx->sim.curr.heading);  // Course is only known while moving
     }
     
-    // Engine temp increases with RPM and throttle
-    float temp_increase = ctx->data.throttle * 0.5f * dt;
-    float temp_cooling = 1.0f * dt;
-    ctx->data.engine_temp += temp_increase - temp_cooling;
-    ctx->data.engine_temp = fmaxf(70.0f, fminf(ctx->data.engine_temp, 250.0f));
+    // Reachable trails: a new search when the rider moves on, a bounded slice of it per frame
+    bool redraw = false;
+    if (steps > 0) {
+        double range_m = fuel_range_estimate(&ctx->fuel_range, ctx->data.odometer, ctx->data.fuel_level);
+        redraw = fuel_range_update(&ctx->fuel_range, ctx->data.latitude, ctx->data.longitude, range_m);
+    }
+    if (fuel_range_step(&ctx->fuel_range, FUEL_RANGE_STEP_NODES) || redraw) {
+        map_viewer_invalidate_layer(&ctx->map_viewer);
+    }
+}
+
+// One fixed step: model, sensors, filters, counters, history, stats, warnings, telemetry
+void sim_tick(AppContext *ctx, const SimInput *input) {
+    const SimState *v = sim_core_step(&ctx->sim, input);
+    Uint32 dt_ms = SIM_STEP_MS;
+    float dt = SIM_STEP_MS / 1000.0f;
     
-    // Coolant temp follows engine temp
-    float coolant_diff = ctx->data.engine_temp - ctx->data.coolant_temp;
-    ctx->data.coolant_temp += coolant_diff * 0.1f * dt;
+    ctx->data.throttle = v->throttle;
+    ctx->data.target_rpm = v->target_rpm;
+    ctx->data.latitude = v->latitude;
+    ctx->data.longitude = v->longitude;
     
-    // Belt temp - CRITICAL for Polaris 600!
-    // Belt heats up faster than engine with high RPM and speed mismatch
-    float belt_heating = ctx->data.throttle * 1.2f * dt;  // Heats faster than engine
-    float belt_cooling = (ctx->data.speed / 120.0f) * 2.0f * dt;  // Airflow cooling
-    ctx->data.belt_temp += belt_heating - belt_cooling;
-    ctx->data.belt_temp = fmaxf(80.0f, fminf(ctx->data.belt_temp, 220.0f));
+    // Update odometer, trips, and engine hours
+    ctx->data.odometer += v->step_miles;
+    ctx->data.trip_a += v->step_miles;
+    ctx->data.trip_b += v->step_miles;
+    ctx->data.engine_hours += dt / 3600.0f;  // Convert seconds to hours
     
-    // Fuel consumption based on throttle
-    if (ctx->data.throttle > 0.1f) {
-        ctx->data.fuel_level -= ctx->data.throttle * 0.1f * dt;
-        ctx->data.fuel_level = fmaxf(0, ctx->data.fuel_level);
+    // Persist counters (coalesced by distance and time to limit SD wear)
+    OdometerCounters counters = odometer_counters(ctx);
+    odometer_store_update(&ctx->odometer_store, &counters, SDL_GetTicks());
+    
+    // Sample sensors and filter all channels in one pass
+    float raw[SENSOR_CHANNEL_COUNT];
+    sim_core_sample(&ctx->sim, raw);
+    update_trail_position(ctx, v, raw);
+    track_store_push(&ctx->track, ctx->data.latitude, ctx->data.longitude);
+    Uint64 sample_ns = SDL_GetTicksNS();
+    stamp_input(&ctx->data, LATENCY_SENSOR, sample_ns);
+    memcpy(ctx->filtered_prev, ctx->sensor_filters.out, sizeof(ctx->filtered_prev));
+    sensor_filter_process(&ctx->sensor_filters, raw);
+    
+    // Consumers below see this step's values, not the interpolated ones
+    const float *filtered = ctx->sensor_filters.out;
+    ctx->data.speed = filtered[SENSOR_SPEED];
+    ctx->data.rpm = filtered[SENSOR_RPM];
+    ctx->data.engine_temp = filtered[SENSOR_ENGINE_TEMP];
+    ctx->data.coolant_temp = filtered[SENSOR_COOLANT_TEMP];
+    ctx->data.belt_temp = filtered[SENSOR_BELT_TEMP];
+    ctx->data.fuel_level = filtered[SENSOR_FUEL_LEVEL];
+    ctx->data.voltage = filtered[SENSOR_VOLTAGE];
+    
+    // Min/max history pyramids for the graph page
+    history_graph_push(&ctx->history, filtered, dt_ms);
+    
+    // Streaming ride and trip statistics (O(1) per sample)
+    for (int i = 0; i < STATS_SCOPE_COUNT; i++) {
+        ride_stats_update(&ctx->stats[i], filtered, dt);
     }
     
-    // Update odometer, trips, and engine hours
-    float distance = fabsf(ctx->data.speed) * dt / 3600.0f; // Convert MPH to miles
-    ctx->data.odometer += distance;
-    ctx->data.trip_a += distance;
-    ctx->data.trip_b += distance;
-    ctx->data.engine_hours += dt / 3600.0f;  // Convert seconds to hours
+    // Update warnings from the rule table (thresholds, hysteresis, debounce)
+    Uint32 previous_warnings = ctx->data.warnings;
+    ctx->data.warnings = warning_rules_evaluate(&ctx->warning_rules, filtered, dt_ms);
+    warning_rules_log(&ctx->warning_rules, previous_warnings, ctx->data.warnings);
+    if (ctx->data.warnings & ~previous_warnings) stamp_input(&ctx->data, LATENCY_WARNING, sample_ns);
     
-    // Voltage fluctuates slightly with RPM
-    float voltage_base = 13.8f;
-    ctx->data.voltage = voltage_base + (ctx->data.rpm / max_rpm) * 0.3f + ((rand() % 10) - 5) / 100.0f;
+    publish_telemetry(ctx);
+}
+
+// Trail distance and geofence channels; near a trail the map follows the trail
+void update_trail_position(AppContext *ctx, const SimState *v, float raw[SENSOR_CHANNEL_COUNT]) {
+    if (!ctx->trails.header) return;  // No index: channels stay 0 and never warn
+    
+    TrailSnap snap;
+    bool near = trail_index_snap(&ctx->trails, v->latitude, v->longitude, TRAIL_SNAP_MAX_M, &snap);
+    raw[SENSOR_TRAIL_DISTANCE] = near ? snap.distance_m : TRAIL_SNAP_MAX_M;
+    raw[SENSOR_RESTRICTED_AREA] = trail_index_area_at(&ctx->trails, v->latitude, v->longitude) != TRAIL_AREA_NONE;
+    if (near && snap.distance_m <= TRAIL_SNAP_LOCK_M) {
+        ctx->data.latitude = snap.latitude;
+        ctx->data.longitude = snap.longitude;
+    }
+}
+
+// Run a script through the full per-step pipeline without a window, as fast as possible
+int run_simulation(AppContext *ctx, const char *script_path) {
+    static SimScript script;  // Too large for the stack
+    if (!sim_script_load(&script, script_path)) return 1;
+    
+    init_dashboard_state(ctx);
+    ctx->boot_complete = true;
+    // Keep away from the odometer file, shared memory and socket of a live dashboard
+    ctx->odometer_store.fd = -1;
+    ctx->telemetry.fd = -1;
+    ctx->metrics_server.listen_fd = ctx->metrics_server.epoll_fd = -1;
+    sim_core_init(&ctx->sim, 46.8797, -84.3397, 1);  // Fixed seed: runs are reproducible
+    trail_index_open(&ctx->trails, TRAIL_INDEX_PATH);
+    ctx->sim_started = true;
+    
+    Uint64 start = SDL_GetTicksNS();
+    int cursor = 0;
+    while (ctx->sim.time_ms < script.end_ms) {
+        sim_tick(ctx, sim_script_input(&script, ctx->sim.time_ms, &cursor));
+    }
+    double wall_s = (SDL_GetTicksNS() - start) / 1e9;
     
-    // Update warnings based on current values (Polaris thresholds)
-    ctx->data.warning_engine_temp = ctx->data.engine_temp > 220.0f;
-    ctx->data.warning_coolant_temp = ctx->data.coolant_temp > 210.0f;
-    ctx->data.warning_belt_temp = ctx->data.belt_temp > 180.0f;  // Critical for belt life!
-    ctx->data.warning_low_fuel = ctx->data.fuel_level < 20.0f;
-    ctx->data.warning_low_voltage = ctx->data.voltage < 12.5f;
+    printf("Simulated %.2f h in %.2f s: %llu steps (%.0f steps/s), %.1f mi, fuel %.1f%%, warnings 0x%08X\n",
+           ctx->sim.time_ms / 3600000.0, wall_s, (unsigned long long)ctx->sim.steps,
+           wall_s > 0 ? ctx->sim.steps / wall_s : 0.0, ctx->data.odometer, ctx->data.fuel_level,
+           (unsigned)ctx->data.warnings);
+    trail_index_close(&ctx->trails);
+    return 0;
+}
+
+// Copy this sensor tick into the shared-memory telemetry block
+void publish_telemetry(AppContext *ctx) {
+    const DashboardData *d = &ctx->data;
+    TelemetrySample sample = {
+        .tick = ++ctx->sensor_tick,
+        .timestamp_ns = SDL_GetTicksNS(),
+        .speed = d->speed,
+        .rpm = d->rpm,
+        .throttle = d->throttle,
+        .engine_temp = d->engine_temp,
+        .coolant_temp = d->coolant_temp,
+        .belt_temp = d->belt_temp,
+        .fuel_level = d->fuel_level,
+        .voltage = d->voltage,
+        .odometer = d->odometer,
+        .trip_a = d->trip_a,
+        .trip_b = d->trip_b,
+        .engine_hours = d->engine_hours,
+        .latitude = d->latitude,
+        .longitude = d->longitude,
+        .warnings = d->warnings,
+        .drive_mode = (Uint8)d->drive_mode,
+        .display_mode = (Uint8)d->display_mode,
+    };
+    telemetry_shm_publish(&ctx->telemetry, &sample);
+    metrics_server_stream(&ctx->metrics_server, &sample);
+    dash_metrics.sensor_ticks++;
 }
 
 void simulate_sensor_data(DashboardData *data) {
@@ -414,130 +963,283 @@ void simulate_sensor_data(DashboardData *data) {
     data->trip_b = fmod(time_offset, 100.0);
     data->latitude = 46.8797 + ((rand() % 20) - 10) / 10000.0;
     data->longitude = -113.9964 + ((rand() % 20) - 10) / 10000.0;
+    // Warnings are evaluated by the rule engine in update_dashboard
+}
+
+// Point drawing at the internal target (or the backbuffer) with layout units mapped onto it
+void begin_frame(AppContext *ctx) {
+    float pixels_w = (float)ctx->window_w;
+    float pixels_h = (float)ctx->window_h;
+    if (ctx->render_target) {
+        SDL_SetRenderTarget(ctx->renderer, ctx->render_target);
+        SDL_GetTextureSize(ctx->render_target, &pixels_w, &pixels_h);
+    }
+    SDL_SetRenderScale(ctx->renderer, pixels_w / ctx->view_w, pixels_h / ctx->view_h);
+}
+
+// Upscale the internal target to the panel in one pass, then present.
+// Every input waiting on this frame gets its input-to-present latency recorded.
+void present_frame(AppContext *ctx) {
+    if (ctx->show_profiler) draw_profiler(ctx);
+    if (ctx->render_target) {
+        SDL_SetRenderTarget(ctx->renderer, NULL);
+        SDL_RenderTexture(ctx->renderer, ctx->render_target, NULL, NULL);
+    }
+    SDL_RenderPresent(ctx->renderer);
     
-    // Warning flags
-    data->warning_engine_temp = data->engine_temp > 220.0f;
-    data->warning_coolant_temp = data->coolant_temp > 210.0f;
-    data->warning_low_fuel = data->fuel_level < 20.0f;
-    data->warning_low_voltage = data->voltage < 12.5f;
+    Uint64 presented_ns = SDL_GetTicksNS();
+    for (int c = 0; c < LATENCY_CATEGORY_COUNT; c++) {
+        Uint64 input_ns = ctx->data.input_ns[c];
+        if (input_ns == 0) continue;
+        metrics_latency_record((LatencyCategory)c, presented_ns > input_ns ? (presented_ns - input_ns) / 1000 : 0);
+        ctx->data.input_ns[c] = 0;
+    }
+}
+
+// Frame time, quality level and input latency percentiles (P)
+void draw_profiler(AppContext *ctx) {
+    int w = 260;
+    int x = ctx->view_w - w - 10;
+    int y = 70;
+    SDL_SetRenderDrawColor(ctx->renderer, 0, 0, 0, 200);
+    SDL_FRect panel = {(float)x, (float)y, (float)w, 174.0f};
+    SDL_RenderFillRect(ctx->renderer, &panel);
+    
+    char line[64];
+    snprintf(line, sizeof(line), "FRAME %.1f ms  MAX %.1f  %s", dash_metrics.frame_time_us / 1000.0,
+             dash_metrics.frame_time_max_us / 1000.0, quality_governor_profile(&ctx->governor)->name);
+    draw_text(ctx, FONT_ARIAL_SMALL, line, x + 10, y + 8, COLOR_PRIMARY, false);
+    draw_text(ctx, FONT_ARIAL_SMALL, "LATENCY    p50     p99     max", x + 10, y + 32, COLOR_PRIMARY, false);
+    for (int c = 0; c < LATENCY_CATEGORY_COUNT; c++) {
+        snprintf(line, sizeof(line), "%-8s %5.1f  %5.1f  %5.1f ms", LATENCY_CATEGORY_NAMES[c],
+                 metrics_latency_percentile((LatencyCategory)c, 0.5) / 1000.0,
+                 metrics_latency_percentile((LatencyCategory)c, 0.99) / 1000.0,
+                 dash_metrics.latency_max_us[c] / 1000.0);
+        draw_text(ctx, FONT_ARIAL_SMALL, line, x + 10, y + 54 + c * 22, COLOR_PRIMARY, false);
+    }
+    Uint64 pack_lookups = dash_metrics.tile_pack_hits + dash_metrics.tile_pack_misses;
+    snprintf(line, sizeof(line), "ROUTE PACK %5.1f%% of %llu tiles",
+             pack_lookups ? 100.0 * dash_metrics.tile_pack_hits / pack_lookups : 0.0,
+             (unsigned long long)pack_lookups);
+    draw_text(ctx, FONT_ARIAL_SMALL, line, x + 10, y + 54 + LATENCY_CATEGORY_COUNT * 22, COLOR_PRIMARY, false);
+    snprintf(line, sizeof(line), "BUILD %.1f ms  WAIT %.1f ms  DROP %u", dash_metrics.frame_build_us / 1000.0,
+             dash_metrics.frame_build_wait_us / 1000.0, dash_metrics.frame_build_dropped);
+    draw_text(ctx, FONT_ARIAL_SMALL, line, x + 10, y + 76 + LATENCY_CATEGORY_COUNT * 22, COLOR_PRIMARY, false);
 }
 
 void render_dashboard(AppContext *ctx) {
+    begin_frame(ctx);
+    
     // Clear with background gradient (simplified to solid color for performance)
     SDL_SetRenderDrawColor(ctx->renderer, COLOR_BG.r, COLOR_BG.g, COLOR_BG.b, COLOR_BG.a);
     SDL_RenderClear(ctx->renderer);
     
+    // Only the gauge screen goes through the pipeline; elsewhere its next build would be stale
+    // and the inputs it held are presented by this frame instead
+    if (!ctx->boot_complete || ctx->show_map || ctx->show_graphs) {
+        frame_pipeline_drop(&ctx->pipeline);
+        for (int c = 0; c < LATENCY_CATEGORY_COUNT; c++) {
+            if (ctx->building_input_ns[c]) ctx->data.input_ns[c] = ctx->building_input_ns[c];
+            ctx->building_input_ns[c] = 0;
+        }
+    }
+    
     // Show boot screen if not complete
     if (!ctx->boot_complete) {
         draw_boot_screen(ctx);
-        SDL_RenderPresent(ctx->renderer);
+        present_frame(ctx);
         return;
     }
     
     // Show map view if toggled
     if (ctx->show_map) {
-        map_viewer_render(&ctx->map_viewer, WINDOW_WIDTH, WINDOW_HEIGHT);
+        map_viewer_render(&ctx->map_viewer, ctx->view_w, ctx->view_h);
+        track_store_draw(&ctx->track, ctx->renderer, &ctx->frame_arena, &ctx->map_viewer.view, ctx->view_w, ctx->view_h);
         
         // Draw minimal overlay with key info
         SDL_SetRenderDrawColor(ctx->renderer, 10, 10, 10, 200);
-        SDL_FRect overlay = {10, 10, 250, 80};
+        SDL_FRect overlay = {10, 10, 320, ctx->fuel_range.index ? 104 : 80};
         SDL_RenderFillRect(ctx->renderer, &overlay);
         
         char info[128];
         snprintf(info, sizeof(info), "%.1f KM/H", fabsf(ctx->data.speed) * 1.60934f);
-        draw_text_ttf(ctx->renderer, ctx->font_digital_medium, info, 20, 20, COLOR_PRIMARY, false);
+        draw_text(ctx, FONT_DIGITAL_MEDIUM, info, 20, 20, COLOR_PRIMARY, false);
+        
+        draw_text(ctx, FONT_ARIAL_SMALL, "TAB: Dashboard  /: Search  H: Heading", 20, 60, COLOR_PRIMARY, false);
+        
+        if (ctx->fuel_range.index) {
+            double fuel_m = fuel_range_to_fuel_m(&ctx->fuel_range);
+            if (isnan(fuel_m)) {
+                snprintf(info, sizeof(info), "RANGE %.0f KM", ctx->fuel_range.range_m / 1000.0);
+            } else if (isinf(fuel_m)) {
+                snprintf(info, sizeof(info), "RANGE %.0f KM  NO FUEL IN RANGE", ctx->fuel_range.range_m / 1000.0);
+            } else {
+                snprintf(info, sizeof(info), "RANGE %.0f KM  FUEL %.1f KM", ctx->fuel_range.range_m / 1000.0,
+                         fuel_m / 1000.0);
+            }
+            draw_text(ctx, FONT_ARIAL_SMALL, info, 20, 84, isinf(fuel_m) ? COLOR_WARNING : COLOR_PRIMARY, false);
+        }
         
-        draw_text_ttf(ctx->renderer, ctx->font_arial_small, "TAB: Dashboard", 20, 60, COLOR_PRIMARY, false);
+        if (ctx->search_active) draw_search_panel(ctx);
         
-        SDL_RenderPresent(ctx->renderer);
+        present_frame(ctx);
         return;
     }
     
+    // Show history graphs if toggled
+    if (ctx->show_graphs) {
+        draw_history_page(ctx);
+        present_frame(ctx);
+        return;
+    }
+    
+    // Gauge screen: submit the list built from last frame's snapshot while
+    // the worker builds this frame's
+    fill_gauge_snapshot(ctx, frame_pipeline_begin(&ctx->pipeline));
+    const DrawList *list = frame_pipeline_end(&ctx->pipeline);
+    
+    // A list from the worker shows last frame's inputs; this frame's are presented with the next one
+    for (int c = 0; c < LATENCY_CATEGORY_COUNT; c++) {
+        Uint64 pending = ctx->data.input_ns[c];
+        if (ctx->pipeline.fresh) {
+            ctx->data.input_ns[c] = ctx->building_input_ns[c];
+            ctx->building_input_ns[c] = pending;
+        } else {
+            ctx->building_input_ns[c] = 0;  // Built from this frame's data, presented now
+        }
+    }
+    uint32_t next = draw_list_submit(list, ctx->renderer, &ctx->fonts, 0);
+    
+    // Mini-map right of the RPM gauge; redrawn at a few Hz, composited every frame
+    if (ctx->show_inset) {
+        MapViewer *map = &ctx->map_viewer;
+        if (map_viewer_inset_begin(map, ctx->data.latitude, ctx->data.longitude, MAP_INSET_SIZE)) {
+            track_store_draw(&ctx->track, ctx->renderer, &ctx->frame_arena, &map->inset.view,
+                             MAP_INSET_SIZE, MAP_INSET_SIZE);
+            map_viewer_inset_end(map);
+        }
+        map_viewer_inset_draw(map, ctx->data.latitude, ctx->data.longitude,
+                              (float)(ctx->view_w - MAP_INSET_SIZE - 10), 75.0f);
+    }
+    
+    // Panels and the warning overlay go over the inset
+    draw_list_submit(list, ctx->renderer, &ctx->fonts, next);
+    
+    present_frame(ctx);
+}
+
+void fill_gauge_snapshot(AppContext *ctx, GaugeSnapshot *snap) {
+    snap->data = ctx->data;
+    snap->stats_scope = ctx->stats_scope;
+    if (ctx->data.display_mode == DISPLAY_RIDE_STATS) snap->stats = ctx->stats[ctx->stats_scope];
+    snap->warning_messages = ctx->warning_rules.message;
+    snap->overlay_mask = ctx->warning_rules.overlay_mask;
+    snap->critical_mask = ctx->warning_rules.critical_mask;
+    const QualityProfile *quality = quality_governor_profile(&ctx->governor);
+    snap->gauge_segments_per_degree = quality->gauge_segments_per_degree;
+    snap->gauge_antialias = quality->gauge_antialias;
+    snap->view_w = ctx->view_w;
+    snap->view_h = ctx->view_h;
+    time_t now = time(NULL);
+    struct tm *t = localtime(&now);
+    snap->clock_hour = t->tm_hour;
+    snap->clock_minute = t->tm_min;
+}
+
+// Record the gauge screen from a snapshot. Runs on the render worker, so
+// it reads only the snapshot and touches no SDL state.
+void build_gauge_screen(DrawList *list, const void *snapshot) {
+    const GaugeSnapshot *snap = snapshot;
+    const DashboardData *data = &snap->data;
+    int view_w = snap->view_w;
+    
     // Draw header bar
-    SDL_SetRenderDrawColor(ctx->renderer, COLOR_GLASS.r, COLOR_GLASS.g, COLOR_GLASS.b, COLOR_GLASS.a);
-    draw_filled_rounded_rect(ctx->renderer, 10, 10, WINDOW_WIDTH - 20, 50, 10);
-    SDL_SetRenderDrawColor(ctx->renderer, COLOR_BORDER.r, COLOR_BORDER.g, COLOR_BORDER.b, COLOR_BORDER.a);
-    draw_rounded_rect(ctx->renderer, 10, 10, WINDOW_WIDTH - 20, 50, 10);
+    draw_list_color(list, COLOR_GLASS.r, COLOR_GLASS.g, COLOR_GLASS.b, COLOR_GLASS.a);
+    draw_list_filled_rounded_rect(list, 10, 10, view_w - 20, 50, 10);
+    draw_list_color(list, COLOR_BORDER.r, COLOR_BORDER.g, COLOR_BORDER.b, COLOR_BORDER.a);
+    draw_list_rounded_rect(list, 10, 10, view_w - 20, 50, 10);
     
     // Logo (Polaris branding)
-    draw_text_ttf(ctx->renderer, ctx->font_arial_bold, "POLARIS", 25, 15, COLOR_PRIMARY, false);
+    record_text(list, FONT_ARIAL_BOLD, "POLARIS", 25, 15, COLOR_PRIMARY, false);
     
     // Clock (Polaris feature - top right)
-    time_t now = time(NULL);
-    struct tm *t = localtime(&now);
     char clock_str[16];
-    snprintf(clock_str, sizeof(clock_str), "%02d:%02d", t->tm_hour, t->tm_min);
-    draw_text_ttf(ctx->renderer, ctx->font_digital_small, clock_str, WINDOW_WIDTH - 100, 25, COLOR_PRIMARY, false);
+    snprintf(clock_str, sizeof(clock_str), "%02d:%02d", snap->clock_hour, snap->clock_minute);
+    record_text(list, FONT_DIGITAL_SMALL, clock_str, view_w - 100, 25, COLOR_PRIMARY, false);
     
     // Connection indicator (green dot)
-    SDL_SetRenderDrawColor(ctx->renderer, COLOR_SUCCESS.r, COLOR_SUCCESS.g, COLOR_SUCCESS.b, 255);
-    draw_filled_circle(ctx->renderer, WINDOW_WIDTH - 30, 35, 6);
+    draw_list_color(list, COLOR_SUCCESS.r, COLOR_SUCCESS.g, COLOR_SUCCESS.b, 255);
+    draw_list_filled_circle(list, view_w - 30, 35, 6);
     
     // Drive mode indicator (large, top center)
-    draw_drive_mode(ctx, WINDOW_WIDTH / 2, 35, 40);
+    draw_drive_mode(list, data->drive_mode, view_w / 2, 35, 40);
     
     // Main gauges (moved down to not overlap header)
     int gauge_y = 200;
-    int speed_x = WINDOW_WIDTH / 2 - 150;
-    int rpm_x = WINDOW_WIDTH / 2 + 150;
+    int speed_x = view_w / 2 - 150;
+    int rpm_x = view_w / 2 + 150;
     
     // Speed gauge (large, left)
-    draw_gauge(ctx, speed_x, gauge_y, 110, ctx->data.speed, 120.0f, true);
+    draw_gauge(list, snap, speed_x, gauge_y, 110, data->speed, 120.0f, true);
     
     // Speed number (digital font) - show absolute value for display, convert to KM/H
     char speed_str[16];
-    int speed_kmh = (int)(fabsf(ctx->data.speed) * 1.60934f);  // Convert MPH to KM/H
+    int speed_kmh = (int)(fabsf(data->speed) * 1.60934f);  // Convert MPH to KM/H
     snprintf(speed_str, sizeof(speed_str), "%d", speed_kmh);
-    draw_text_ttf(ctx->renderer, ctx->font_digital_large, speed_str, speed_x, gauge_y - 10, COLOR_PRIMARY, true);
-    draw_text_ttf(ctx->renderer, ctx->font_arial_small, "KM/H", speed_x, gauge_y + 50, COLOR_PRIMARY, true);
+    record_text(list, FONT_DIGITAL_LARGE, speed_str, speed_x, gauge_y - 10, COLOR_PRIMARY, true);
+    record_text(list, FONT_ARIAL_SMALL, "KM/H", speed_x, gauge_y + 50, COLOR_PRIMARY, true);
     
     // RPM gauge (right)
-    draw_gauge(ctx, rpm_x, gauge_y, 85, ctx->data.rpm, 9000.0f, false);
+    draw_gauge(list, snap, rpm_x, gauge_y, 85, data->rpm, 9000.0f, false);
     
     // RPM number (digital font) - show actual RPM
     char rpm_str[16];
-    snprintf(rpm_str, sizeof(rpm_str), "%d", (int)ctx->data.rpm);
-    draw_text_ttf(ctx->renderer, ctx->font_digital_medium, rpm_str, rpm_x, gauge_y - 5, COLOR_PRIMARY, true);
-    draw_text_ttf(ctx->renderer, ctx->font_arial_small, "RPM", rpm_x, gauge_y + 35, COLOR_PRIMARY, true);
+    snprintf(rpm_str, sizeof(rpm_str), "%d", (int)data->rpm);
+    record_text(list, FONT_DIGITAL_MEDIUM, rpm_str, rpm_x, gauge_y - 5, COLOR_PRIMARY, true);
+    record_text(list, FONT_ARIAL_SMALL, "RPM", rpm_x, gauge_y + 35, COLOR_PRIMARY, true);
+    
+    // The mini-map is a texture, drawn by the main thread between the two halves
+    draw_list_mark(list);
     
     // Info panels at bottom
     int panel_y = 350;
     int panel_w = 180;
     int panel_h = 110;
     int panel_spacing = 10;
-    int start_x = (WINDOW_WIDTH - (panel_w * 4 + panel_spacing * 3)) / 2;
+    int start_x = (view_w - (panel_w * 4 + panel_spacing * 3)) / 2;
     
     // Temperature panel
-    SDL_SetRenderDrawColor(ctx->renderer, COLOR_GLASS.r, COLOR_GLASS.g, COLOR_GLASS.b, COLOR_GLASS.a);
-    draw_filled_rounded_rect(ctx->renderer, start_x, panel_y, panel_w, panel_h, 10);
-    SDL_SetRenderDrawColor(ctx->renderer, COLOR_BORDER.r, COLOR_BORDER.g, COLOR_BORDER.b, COLOR_BORDER.a);
-    draw_rounded_rect(ctx->renderer, start_x, panel_y, panel_w, panel_h, 10);
+    draw_list_color(list, COLOR_GLASS.r, COLOR_GLASS.g, COLOR_GLASS.b, COLOR_GLASS.a);
+    draw_list_filled_rounded_rect(list, start_x, panel_y, panel_w, panel_h, 10);
+    draw_list_color(list, COLOR_BORDER.r, COLOR_BORDER.g, COLOR_BORDER.b, COLOR_BORDER.a);
+    draw_list_rounded_rect(list, start_x, panel_y, panel_w, panel_h, 10);
     
-    draw_text_ttf(ctx->renderer, ctx->font_arial_bold, "TEMP", start_x + panel_w/2, panel_y + 12, COLOR_PRIMARY, true);
+    record_text(list, FONT_ARIAL_BOLD, "TEMP", start_x + panel_w/2, panel_y + 12, COLOR_PRIMARY, true);
     
     // Engine temp (Polaris amber/red scheme)
-    Color temp_color = ctx->data.warning_engine_temp ? COLOR_POLARIS_RED : COLOR_PRIMARY;
+    Uint32 warnings = data->warnings;
+    Color temp_color = (warnings & WARNING_BIT(WARN_ENGINE_TEMP)) ? COLOR_POLARIS_RED : COLOR_PRIMARY;
     char eng_temp_str[16];
-    snprintf(eng_temp_str, sizeof(eng_temp_str), "%d", (int)ctx->data.engine_temp);
-    draw_text_ttf(ctx->renderer, ctx->font_digital_small, eng_temp_str, start_x + 20, panel_y + 40, temp_color, false);
-    draw_text_ttf(ctx->renderer, ctx->font_arial_small, "ENG", start_x + 20, panel_y + 75, temp_color, false);
+    snprintf(eng_temp_str, sizeof(eng_temp_str), "%d", (int)data->engine_temp);
+    record_text(list, FONT_DIGITAL_SMALL, eng_temp_str, start_x + 20, panel_y + 40, temp_color, false);
+    record_text(list, FONT_ARIAL_SMALL, "ENG", start_x + 20, panel_y + 75, temp_color, false);
     
     // Belt temp - CRITICAL!
-    temp_color = ctx->data.warning_belt_temp ? COLOR_POLARIS_RED : 
-                 (ctx->data.belt_temp > 160.0f ? COLOR_POLARIS_AMBER : COLOR_PRIMARY);
+    temp_color = (warnings & WARNING_BIT(WARN_BELT_TEMP)) ? COLOR_POLARIS_RED : 
+                 ((warnings & WARNING_BIT(WARN_BELT_TEMP_RISING)) ? COLOR_POLARIS_AMBER : COLOR_PRIMARY);
     char belt_temp_str[16];
-    snprintf(belt_temp_str, sizeof(belt_temp_str), "%d", (int)ctx->data.belt_temp);
-    draw_text_ttf(ctx->renderer, ctx->font_digital_small, belt_temp_str, start_x + 100, panel_y + 40, temp_color, false);
-    draw_text_ttf(ctx->renderer, ctx->font_arial_small, "BELT", start_x + 100, panel_y + 75, temp_color, false);
+    snprintf(belt_temp_str, sizeof(belt_temp_str), "%d", (int)data->belt_temp);
+    record_text(list, FONT_DIGITAL_SMALL, belt_temp_str, start_x + 100, panel_y + 40, temp_color, false);
+    record_text(list, FONT_ARIAL_SMALL, "BELT", start_x + 100, panel_y + 75, temp_color, false);
     
     // Fuel panel
     start_x += panel_w + panel_spacing;
-    SDL_SetRenderDrawColor(ctx->renderer, COLOR_GLASS.r, COLOR_GLASS.g, COLOR_GLASS.b, COLOR_GLASS.a);
-    draw_filled_rounded_rect(ctx->renderer, start_x, panel_y, panel_w, panel_h, 10);
-    SDL_SetRenderDrawColor(ctx->renderer, COLOR_BORDER.r, COLOR_BORDER.g, COLOR_BORDER.b, COLOR_BORDER.a);
-    draw_rounded_rect(ctx->renderer, start_x, panel_y, panel_w, panel_h, 10);
+    draw_list_color(list, COLOR_GLASS.r, COLOR_GLASS.g, COLOR_GLASS.b, COLOR_GLASS.a);
+    draw_list_filled_rounded_rect(list, start_x, panel_y, panel_w, panel_h, 10);
+    draw_list_color(list, COLOR_BORDER.r, COLOR_BORDER.g, COLOR_BORDER.b, COLOR_BORDER.a);
+    draw_list_rounded_rect(list, start_x, panel_y, panel_w, panel_h, 10);
     
-    draw_text_ttf(ctx->renderer, ctx->font_arial_bold, "FUEL", start_x + panel_w/2, panel_y + 12, COLOR_PRIMARY, true);
+    record_text(list, FONT_ARIAL_BOLD, "FUEL", start_x + panel_w/2, panel_y + 12, COLOR_PRIMARY, true);
     
     // Fuel bar
     int bar_x = start_x + 10;
@@ -545,140 +1247,142 @@ void render_dashboard(AppContext *ctx) {
     int bar_w = panel_w - 20;
     int bar_h = 15;
     
-    SDL_SetRenderDrawColor(ctx->renderer, 40, 40, 40, 255);
+    draw_list_color(list, 40, 40, 40, 255);
     SDL_FRect bar_bg = {(float)bar_x, (float)bar_y, (float)bar_w, (float)bar_h};
-    SDL_RenderFillRect(ctx->renderer, &bar_bg);
+    draw_list_fill_rect(list, &bar_bg);
     
-    Color fuel_color = ctx->data.warning_low_fuel ? COLOR_WARNING : COLOR_SUCCESS;
-    SDL_SetRenderDrawColor(ctx->renderer, fuel_color.r, fuel_color.g, fuel_color.b, 255);
-    SDL_FRect bar_fill = {(float)bar_x, (float)bar_y, bar_w * ctx->data.fuel_level / 100.0f, (float)bar_h};
-    SDL_RenderFillRect(ctx->renderer, &bar_fill);
+    Color fuel_color = (warnings & WARNING_BIT(WARN_LOW_FUEL)) ? COLOR_WARNING : COLOR_SUCCESS;
+    draw_list_color(list, fuel_color.r, fuel_color.g, fuel_color.b, 255);
+    SDL_FRect bar_fill = {(float)bar_x, (float)bar_y, bar_w * data->fuel_level / 100.0f, (float)bar_h};
+    draw_list_fill_rect(list, &bar_fill);
     
     // Fuel percentage number (below bar, not overlapping)
     char fuel_str[16];
-    snprintf(fuel_str, sizeof(fuel_str), "%d%%", (int)ctx->data.fuel_level);
-    draw_text_ttf(ctx->renderer, ctx->font_digital_medium, fuel_str, start_x + panel_w/2, panel_y + 70, fuel_color, true);
+    snprintf(fuel_str, sizeof(fuel_str), "%d%%", (int)data->fuel_level);
+    record_text(list, FONT_DIGITAL_MEDIUM, fuel_str, start_x + panel_w/2, panel_y + 70, fuel_color, true);
     
     // Trip info panel
     start_x += panel_w + panel_spacing;
-    SDL_SetRenderDrawColor(ctx->renderer, COLOR_GLASS.r, COLOR_GLASS.g, COLOR_GLASS.b, COLOR_GLASS.a);
-    draw_filled_rounded_rect(ctx->renderer, start_x, panel_y, panel_w, panel_h, 10);
-    SDL_SetRenderDrawColor(ctx->renderer, COLOR_BORDER.r, COLOR_BORDER.g, COLOR_BORDER.b, COLOR_BORDER.a);
-    draw_rounded_rect(ctx->renderer, start_x, panel_y, panel_w, panel_h, 10);
+    draw_list_color(list, COLOR_GLASS.r, COLOR_GLASS.g, COLOR_GLASS.b, COLOR_GLASS.a);
+    draw_list_filled_rounded_rect(list, start_x, panel_y, panel_w, panel_h, 10);
+    draw_list_color(list, COLOR_BORDER.r, COLOR_BORDER.g, COLOR_BORDER.b, COLOR_BORDER.a);
+    draw_list_rounded_rect(list, start_x, panel_y, panel_w, panel_h, 10);
     
     // Scrolling display mode (Polaris-style)
     const char *mode_label;
     char display_value[32];
     
-    switch (ctx->data.display_mode) {
+    switch (data->display_mode) {
         case DISPLAY_ODOMETER:
             mode_label = "ODO";
-            snprintf(display_value, sizeof(display_value), "%.1f", ctx->data.odometer);
+            snprintf(display_value, sizeof(display_value), "%.1f", data->odometer);
             break;
         case DISPLAY_TRIP_A:
             mode_label = "TRIP A";
-            snprintf(display_value, sizeof(display_value), "%.1f", ctx->data.trip_a);
+            snprintf(display_value, sizeof(display_value), "%.1f", data->trip_a);
             break;
         case DISPLAY_TRIP_B:
             mode_label = "TRIP B";
-            snprintf(display_value, sizeof(display_value), "%.1f", ctx->data.trip_b);
+            snprintf(display_value, sizeof(display_value), "%.1f", data->trip_b);
+            break;
+        case DISPLAY_RIDE_STATS:
+            mode_label = NULL;  // Multi-line page, drawn below
+            display_value[0] = '\0';
             break;
         case DISPLAY_ENGINE_HOURS:
             mode_label = "HRS";
-            snprintf(display_value, sizeof(display_value), "%.1f", ctx->data.engine_hours);
+            snprintf(display_value, sizeof(display_value), "%.1f", data->engine_hours);
             break;
         default:
             mode_label = "ODO";
-            snprintf(display_value, sizeof(display_value), "%.1f", ctx->data.odometer);
+            snprintf(display_value, sizeof(display_value), "%.1f", data->odometer);
     }
     
-    draw_text_ttf(ctx->renderer, ctx->font_arial_bold, mode_label, start_x + panel_w/2, panel_y + 12, COLOR_PRIMARY, true);
-    draw_text_ttf(ctx->renderer, ctx->font_digital_medium, display_value, start_x + panel_w/2, panel_y + 55, COLOR_PRIMARY, true);
+    if (mode_label) {
+        record_text(list, FONT_ARIAL_BOLD, mode_label, start_x + panel_w/2, panel_y + 12, COLOR_PRIMARY, true);
+        record_text(list, FONT_DIGITAL_MEDIUM, display_value, start_x + panel_w/2, panel_y + 55, COLOR_PRIMARY, true);
+    } else {
+        draw_stats_page(list, &snap->stats, snap->stats_scope, start_x, panel_y, panel_w);
+    }
     
     // System panel
     start_x += panel_w + panel_spacing;
-    SDL_SetRenderDrawColor(ctx->renderer, COLOR_GLASS.r, COLOR_GLASS.g, COLOR_GLASS.b, COLOR_GLASS.a);
-    draw_filled_rounded_rect(ctx->renderer, start_x, panel_y, panel_w, panel_h, 10);
-    SDL_SetRenderDrawColor(ctx->renderer, COLOR_BORDER.r, COLOR_BORDER.g, COLOR_BORDER.b, COLOR_BORDER.a);
-    draw_rounded_rect(ctx->renderer, start_x, panel_y, panel_w, panel_h, 10);
+    draw_list_color(list, COLOR_GLASS.r, COLOR_GLASS.g, COLOR_GLASS.b, COLOR_GLASS.a);
+    draw_list_filled_rounded_rect(list, start_x, panel_y, panel_w, panel_h, 10);
+    draw_list_color(list, COLOR_BORDER.r, COLOR_BORDER.g, COLOR_BORDER.b, COLOR_BORDER.a);
+    draw_list_rounded_rect(list, start_x, panel_y, panel_w, panel_h, 10);
     
-    draw_text_ttf(ctx->renderer, ctx->font_arial_bold, "SYSTEM", start_x + panel_w/2, panel_y + 12, COLOR_PRIMARY, true);
+    record_text(list, FONT_ARIAL_BOLD, "SYSTEM", start_x + panel_w/2, panel_y + 12, COLOR_PRIMARY, true);
     
     // Battery voltage with decimal
-    Color volt_color = ctx->data.warning_low_voltage ? COLOR_WARNING : COLOR_SUCCESS;
+    Color volt_color = (warnings & WARNING_BIT(WARN_LOW_VOLTAGE)) ? COLOR_WARNING : COLOR_SUCCESS;
     char volt_str[16];
-    snprintf(volt_str, sizeof(volt_str), "%.1fV", ctx->data.voltage);
-    draw_text_ttf(ctx->renderer, ctx->font_digital_medium, volt_str, start_x + panel_w/2, panel_y + 55, volt_color, true);
+    snprintf(volt_str, sizeof(volt_str), "%.1fV", data->voltage);
+    record_text(list, FONT_DIGITAL_MEDIUM, volt_str, start_x + panel_w/2, panel_y + 55, volt_color, true);
     
     // Warning overlay (Polaris-style critical warnings)
-    bool has_warnings = ctx->data.warning_engine_temp || ctx->data.warning_belt_temp || 
-                       ctx->data.warning_low_fuel || ctx->data.warning_low_voltage;
+    Uint32 overlay_warnings = warnings & snap->overlay_mask;
     
-    if (has_warnings) {
+    if (overlay_warnings) {
         // Semi-transparent overlay
-        SDL_SetRenderDrawColor(ctx->renderer, 0, 0, 0, 200);
-        SDL_FRect overlay = {0, 0, WINDOW_WIDTH, WINDOW_HEIGHT};
-        SDL_RenderFillRect(ctx->renderer, &overlay);
+        draw_list_color(list, 0, 0, 0, 200);
+        SDL_FRect overlay = {0, 0, (float)view_w, (float)snap->view_h};
+        draw_list_fill_rect(list, &overlay);
         
         // Warning box
         int warn_w = 500;
         int warn_h = 200;
-        int warn_x = (WINDOW_WIDTH - warn_w) / 2;
-        int warn_y = (WINDOW_HEIGHT - warn_h) / 2;
+        int warn_x = (view_w - warn_w) / 2;
+        int warn_y = (snap->view_h - warn_h) / 2;
         
-        SDL_SetRenderDrawColor(ctx->renderer, 40, 10, 10, 230);
-        draw_filled_rounded_rect(ctx->renderer, warn_x, warn_y, warn_w, warn_h, 15);
-        SDL_SetRenderDrawColor(ctx->renderer, COLOR_WARNING.r, COLOR_WARNING.g, COLOR_WARNING.b, 255);
-        draw_rounded_rect(ctx->renderer, warn_x, warn_y, warn_w, warn_h, 15);
-        draw_rounded_rect(ctx->renderer, warn_x + 2, warn_y + 2, warn_w - 4, warn_h - 4, 13);
+        draw_list_color(list, 40, 10, 10, 230);
+        draw_list_filled_rounded_rect(list, warn_x, warn_y, warn_w, warn_h, 15);
+        draw_list_color(list, COLOR_WARNING.r, COLOR_WARNING.g, COLOR_WARNING.b, 255);
+        draw_list_rounded_rect(list, warn_x, warn_y, warn_w, warn_h, 15);
+        draw_list_rounded_rect(list, warn_x + 2, warn_y + 2, warn_w - 4, warn_h - 4, 13);
         
         // Warning triangle (Polaris red)
-        SDL_SetRenderDrawColor(ctx->renderer, COLOR_POLARIS_RED.r, COLOR_POLARIS_RED.g, COLOR_POLARIS_RED.b, 255);
+        draw_list_color(list, COLOR_POLARIS_RED.r, COLOR_POLARIS_RED.g, COLOR_POLARIS_RED.b, 255);
         for (int i = 0; i < 5; i++) {
-            SDL_RenderLine(ctx->renderer, warn_x + warn_w/2 - 40 + i, warn_y + 80, warn_x + warn_w/2, warn_y + 40 - i);
-            SDL_RenderLine(ctx->renderer, warn_x + warn_w/2, warn_y + 40 - i, warn_x + warn_w/2 + 40 - i, warn_y + 80);
-            SDL_RenderLine(ctx->renderer, warn_x + warn_w/2 - 40 + i, warn_y + 80, warn_x + warn_w/2 + 40 - i, warn_y + 80);
+            SDL_FPoint triangle[4] = {
+                {(float)(warn_x + warn_w/2 - 40 + i), (float)(warn_y + 80)},
+                {(float)(warn_x + warn_w/2), (float)(warn_y + 40 - i)},
+                {(float)(warn_x + warn_w/2 + 40 - i), (float)(warn_y + 80)},
+                {(float)(warn_x + warn_w/2 - 40 + i), (float)(warn_y + 80)}
+            };
+            draw_list_polyline(list, triangle, 4);
         }
         
-        // Warning messages (Polaris-style)
+        // Warning messages (Polaris-style), one per active bit in table order
         int msg_y = warn_y + 110;
-        if (ctx->data.warning_engine_temp) {
-            draw_text_ttf(ctx->renderer, ctx->font_arial_bold, "HIGH ENGINE TEMP", warn_x + warn_w / 2, msg_y, COLOR_POLARIS_RED, true);
+        while (overlay_warnings && msg_y < warn_y + warn_h) {
+            int id = __builtin_ctz(overlay_warnings);
+            overlay_warnings &= overlay_warnings - 1;
+            Color msg_color = (snap->critical_mask & WARNING_BIT(id)) ? COLOR_POLARIS_RED : COLOR_POLARIS_AMBER;
+            record_text(list, FONT_ARIAL_BOLD, snap->warning_messages[id], warn_x + warn_w / 2, msg_y, msg_color, true);
             msg_y += 30;
         }
-        if (ctx->data.warning_belt_temp) {
-            draw_text_ttf(ctx->renderer, ctx->font_arial_bold, "BELT TEMP HIGH!", warn_x + warn_w / 2, msg_y, COLOR_POLARIS_RED, true);
-            msg_y += 30;
-        }
-        if (ctx->data.warning_low_fuel) {
-            draw_text_ttf(ctx->renderer, ctx->font_arial_bold, "LOW FUEL", warn_x + warn_w / 2, msg_y, COLOR_POLARIS_AMBER, true);
-            msg_y += 30;
-        }
-        if (ctx->data.warning_low_voltage) {
-            draw_text_ttf(ctx->renderer, ctx->font_arial_bold, "LOW VOLTAGE", warn_x + warn_w / 2, msg_y, COLOR_POLARIS_AMBER, true);
-        }
     }
-    
-    SDL_RenderPresent(ctx->renderer);
 }
 
-void draw_gauge(AppContext *ctx, int cx, int cy, int radius, float value, float max_value, bool is_primary) {
+void draw_gauge(DrawList *list, const GaugeSnapshot *snap, int cx, int cy, int radius, float value, float max_value,
+                bool is_primary) {
     (void)is_primary;  // Unused but kept for API compatibility
     // Background circle (glass panel)
-    SDL_SetRenderDrawColor(ctx->renderer, COLOR_GLASS.r, COLOR_GLASS.g, COLOR_GLASS.b, COLOR_GLASS.a);
+    draw_list_color(list, COLOR_GLASS.r, COLOR_GLASS.g, COLOR_GLASS.b, COLOR_GLASS.a);
     for (int i = 0; i < 15; i++) {
-        draw_circle(ctx->renderer, cx, cy, radius + i);
+        draw_list_circle(list, cx, cy, radius + i);
     }
     
     // Border (more visible)
-    SDL_SetRenderDrawColor(ctx->renderer, COLOR_BORDER.r, COLOR_BORDER.g, COLOR_BORDER.b, COLOR_BORDER.a);
-    draw_circle(ctx->renderer, cx, cy, radius + 15);
-    draw_circle(ctx->renderer, cx, cy, radius + 16);
-    draw_circle(ctx->renderer, cx, cy, radius + 17);
+    draw_list_color(list, COLOR_BORDER.r, COLOR_BORDER.g, COLOR_BORDER.b, COLOR_BORDER.a);
+    draw_list_circle(list, cx, cy, radius + 15);
+    draw_list_circle(list, cx, cy, radius + 16);
+    draw_list_circle(list, cx, cy, radius + 17);
     
     // Background arc track (always visible, darker)
-    SDL_SetRenderDrawColor(ctx->renderer, COLOR_GAUGE_BG.r, COLOR_GAUGE_BG.g, COLOR_GAUGE_BG.b, COLOR_GAUGE_BG.a);
-    draw_arc(ctx->renderer, cx, cy, radius, -225, 45, 15);
+    draw_list_color(list, COLOR_GAUGE_BG.r, COLOR_GAUGE_BG.g, COLOR_GAUGE_BG.b, COLOR_GAUGE_BG.a);
+    draw_list_arc(list, cx, cy, radius, -225, 45, 15, snap->gauge_segments_per_degree);
     
     // Progress arc
     float percentage = fminf(value / max_value, 1.0f);
@@ -696,7 +1400,7 @@ void draw_gauge(AppContext *ctx, int cx, int cy, int radius, float value, float
         arc_color.b = 255;
     }
     
-    SDL_SetRenderDrawColor(ctx->renderer, arc_color.r, arc_color.g, arc_color.b, 255);
+    draw_list_color(list, arc_color.r, arc_color.g, arc_color.b, 255);
     
     // Draw filled arc (thick and bright)
     float start_angle = -225.0f * M_PI / 180.0f;
@@ -705,17 +1409,19 @@ void draw_gauge(AppContext *ctx, int cx, int cy, int radius, float value, float
     // Draw arc with multiple layers for solid, thick fill
     for (int thickness = 0; thickness < 15; thickness++) {
         int r = radius - 7 + thickness;
-        int num_segments = (int)(270 * percentage * 2);  // More segments for smoother arc
+        int num_segments = (int)(270 * percentage * snap->gauge_segments_per_degree);
         if (num_segments < 2) num_segments = 2;
         for (int i = 0; i <= num_segments; i++) {
             float angle = start_angle + (sweep_angle * i / num_segments);
             float px = cx + r * cosf(angle);
             float py = cy + r * sinf(angle);
-            // Draw multiple points for better coverage
-            SDL_RenderPoint(ctx->renderer, px, py);
-            SDL_RenderPoint(ctx->renderer, px + 1, py);
-            SDL_RenderPoint(ctx->renderer, px, py + 1);
-            SDL_RenderPoint(ctx->renderer, px + 1, py + 1);
+            draw_list_point(list, px, py);
+            // Extra points for better coverage
+            if (snap->gauge_antialias) {
+                draw_list_point(list, px + 1, py);
+                draw_list_point(list, px, py + 1);
+                draw_list_point(list, px + 1, py + 1);
+            }
         }
     }
     
@@ -725,88 +1431,6 @@ void draw_gauge(AppContext *ctx, int cx, int cy, int radius, float value, float
 }
 
 
-void draw_filled_circle(SDL_Renderer *renderer, int cx, int cy, int radius) {
-    for (int y = -radius; y <= radius; y++) {
-        for (int x = -radius; x <= radius; x++) {
-            if (x*x + y*y <= radius*radius) {
-                SDL_RenderPoint(renderer, (float)(cx + x), (float)(cy + y));
-            }
-        }
-    }
-}
-
-void draw_circle(SDL_Renderer *renderer, int cx, int cy, int radius) {
-    int x = radius;
-    int y = 0;
-    int err = 0;
-    
-    while (x >= y) {
-        SDL_RenderPoint(renderer, (float)(cx + x), (float)(cy + y));
-        SDL_RenderPoint(renderer, (float)(cx + y), (float)(cy + x));
-        SDL_RenderPoint(renderer, (float)(cx - y), (float)(cy + x));
-        SDL_RenderPoint(renderer, (float)(cx - x), (float)(cy + y));
-        SDL_RenderPoint(renderer, (float)(cx - x), (float)(cy - y));
-        SDL_RenderPoint(renderer, (float)(cx - y), (float)(cy - x));
-        SDL_RenderPoint(renderer, (float)(cx + y), (float)(cy - x));
-        SDL_RenderPoint(renderer, (float)(cx + x), (float)(cy - y));
-        
-        if (err <= 0) {
-            y += 1;
-            err += 2*y + 1;
-        }
-        if (err > 0) {
-            x -= 1;
-            err -= 2*x + 1;
-        }
-    }
-}
-
-void draw_arc(SDL_Renderer *renderer, int cx, int cy, int radius, float start_angle, float end_angle, int thickness) {
-    float start_rad = start_angle * M_PI / 180.0f;
-    float end_rad = end_angle * M_PI / 180.0f;
-    
-    int num_segments = (int)(fabs(end_angle - start_angle) * 2);
-    float angle_step = (end_rad - start_rad) / num_segments;
-    
-    for (int i = 0; i < num_segments; i++) {
-        float angle1 = start_rad + i * angle_step;
-        float angle2 = start_rad + (i + 1) * angle_step;
-        
-        for (int t = 0; t < thickness; t++) {
-            int r = radius + t - thickness / 2;
-            float x1 = cx + r * cosf(angle1);
-            float y1 = cy + r * sinf(angle1);
-            float x2 = cx + r * cosf(angle2);
-            float y2 = cy + r * sinf(angle2);
-            
-            SDL_RenderLine(renderer, x1, y1, x2, y2);
-        }
-    }
-}
-
-void draw_rounded_rect(SDL_Renderer *renderer, int x, int y, int w, int h, int radius) {
-    // Top line
-    SDL_RenderLine(renderer, (float)(x + radius), (float)y, (float)(x + w - radius), (float)y);
-    // Bottom line
-    SDL_RenderLine(renderer, (float)(x + radius), (float)(y + h), (float)(x + w - radius), (float)(y + h));
-    // Left line
-    SDL_RenderLine(renderer, (float)x, (float)(y + radius), (float)x, (float)(y + h - radius));
-    // Right line
-    SDL_RenderLine(renderer, (float)(x + w), (float)(y + radius), (float)(x + w), (float)(y + h - radius));
-    
-    // Corners (simplified)
-    for (int i = 0; i < radius; i++) {
-        float angle = i * M_PI / (2 * radius);
-        int dx = (int)(radius * cosf(angle));
-        int dy = (int)(radius * sinf(angle));
-        
-        SDL_RenderPoint(renderer, (float)(x + radius - dx), (float)(y + radius - dy));
-        SDL_RenderPoint(renderer, (float)(x + w - radius + dx), (float)(y + radius - dy));
-        SDL_RenderPoint(renderer, (float)(x + radius - dx), (float)(y + h - radius + dy));
-        SDL_RenderPoint(renderer, (float)(x + w - radius + dx), (float)(y + h - radius + dy));
-    }
-}
-
 // Draw a 7-segment style digit
 void draw_digit(SDL_Renderer *renderer, int digit, int x, int y, int width, int height, Color color) {
     SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
@@ -888,30 +1512,16 @@ void draw_number(SDL_Renderer *renderer, int value, int x, int y, int size, Colo
     }
 }
 
-// Draw text using TTF fonts
-void draw_text_ttf(SDL_Renderer *renderer, TTF_Font *font, const char *text, int x, int y, Color color, bool centered) {
-    if (!font || !text) return;
-    
+// Draw text from the baked glyph atlas (TTF fallback for unbaked glyphs)
+void draw_text(AppContext *ctx, FontFace face, const char *text, int x, int y, Color color, bool centered) {
     SDL_Color sdl_color = {color.r, color.g, color.b, color.a};
-    SDL_Surface *surface = TTF_RenderText_Blended(font, text, 0, sdl_color);
-    if (!surface) return;
-    
-    SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, surface);
-    if (!texture) {
-        SDL_DestroySurface(surface);
-        return;
-    }
-    
-    SDL_FRect dest = {(float)x, (float)y, (float)surface->w, (float)surface->h};
-    if (centered) {
-        dest.x -= surface->w / 2.0f;
-        dest.y -= surface->h / 2.0f;
-    }
-    
-    SDL_RenderTexture(renderer, texture, NULL, &dest);
-    
-    SDL_DestroyTexture(texture);
-    SDL_DestroySurface(surface);
+    font_atlas_draw(&ctx->fonts, face, text, x, y, sdl_color, centered);
+}
+
+// Same as draw_text, recorded into a draw list for later submission
+void record_text(DrawList *list, FontFace face, const char *text, int x, int y, Color color, bool centered) {
+    SDL_Color sdl_color = {color.r, color.g, color.b, color.a};
+    draw_list_text(list, face, text, x, y, sdl_color, centered);
 }
 
 // Draw simple text labels using rectangles (fallback)
@@ -933,8 +1543,7 @@ void draw_label(SDL_Renderer *renderer, const char *text, int x, int y, int size
 }
 
 // Draw drive mode indicator
-void draw_drive_mode(AppContext *ctx, int x, int y, int size) {
-    DriveMode mode = ctx->data.drive_mode;
+void draw_drive_mode(DrawList *list, DriveMode mode, int x, int y, int size) {
     Color mode_color;
     const char *mode_text;
     
@@ -951,88 +1560,142 @@ void draw_drive_mode(AppContext *ctx, int x, int y, int size) {
     }
     
     // Draw using TTF font
-    draw_text_ttf(ctx->renderer, ctx->font_arial_bold, mode_text, x, y, mode_color, true);
+    record_text(list, FONT_ARIAL_BOLD, mode_text, x, y, mode_color, true);
     
     // Background circle
-    SDL_SetRenderDrawColor(ctx->renderer, COLOR_GLASS.r, COLOR_GLASS.g, COLOR_GLASS.b, 100);
-    draw_filled_circle(ctx->renderer, x, y, size);
-    SDL_SetRenderDrawColor(ctx->renderer, mode_color.r, mode_color.g, mode_color.b, 255);
-    draw_circle(ctx->renderer, x, y, size);
-    
-    return;  // TTF rendered, skip old shape drawing
-    
-    // Draw large letter for mode (old code - not reached)
-    SDL_SetRenderDrawColor(ctx->renderer, mode_color.r, mode_color.g, mode_color.b, 255);
-    
-    // Draw D, R, or N using simple shapes (old fallback code - not reached)
-    int w = size;
-    int h = size * 2;
-    int thickness = size / 5;
-    
-    if (mode == MODE_DRIVE) {
-        // Draw D shape
-        SDL_FRect left = {(float)(x - w/2), (float)(y - h/2), (float)thickness, (float)h};
-        SDL_RenderFillRect(ctx->renderer, &left);
-        SDL_FRect top = {(float)(x - w/2), (float)(y - h/2), (float)w, (float)thickness};
-        SDL_RenderFillRect(ctx->renderer, &top);
-        SDL_FRect bottom = {(float)(x - w/2), (float)(y + h/2 - thickness), (float)w, (float)thickness};
-        SDL_RenderFillRect(ctx->renderer, &bottom);
-        // Right curve (simplified)
-        for (int i = 0; i < h; i++) {
-            int offset = (int)(w * 0.3 * sinf(M_PI * i / h));
-            SDL_RenderPoint(ctx->renderer, (float)(x + w/2 - offset), (float)(y - h/2 + i));
-        }
-    } else if (mode == MODE_REVERSE) {
-        // Draw R shape
-        SDL_FRect left = {(float)(x - w/2), (float)(y - h/2), (float)thickness, (float)h};
-        SDL_RenderFillRect(ctx->renderer, &left);
-        SDL_FRect top = {(float)(x - w/2), (float)(y - h/2), (float)w, (float)thickness};
-        SDL_RenderFillRect(ctx->renderer, &top);
-        SDL_FRect mid = {(float)(x - w/2), (float)y, (float)w, (float)thickness};
-        SDL_RenderFillRect(ctx->renderer, &mid);
-        SDL_FRect right_top = {(float)(x + w/2 - thickness), (float)(y - h/2), (float)thickness, (float)h/2};
-        SDL_RenderFillRect(ctx->renderer, &right_top);
-        // Diagonal leg
-        for (int i = 0; i < h/2; i++) {
-            SDL_RenderPoint(ctx->renderer, (float)(x + i * thickness / 10), (float)(y + i));
-        }
-    } else {
-        // Draw N shape
-        SDL_FRect left = {(float)(x - w/2), (float)(y - h/2), (float)thickness, (float)h};
-        SDL_RenderFillRect(ctx->renderer, &left);
-        SDL_FRect right = {(float)(x + w/2 - thickness), (float)(y - h/2), (float)thickness, (float)h};
-        SDL_RenderFillRect(ctx->renderer, &right);
-        // Diagonal
-        for (int i = 0; i < h; i++) {
-            SDL_RenderLine(ctx->renderer, (float)(x - w/2), (float)(y - h/2 + i), 
-                          (float)(x + w/2), (float)(y - h/2 + i));
+    draw_list_color(list, COLOR_GLASS.r, COLOR_GLASS.g, COLOR_GLASS.b, 100);
+    draw_list_filled_circle(list, x, y, size);
+    draw_list_color(list, mode_color.r, mode_color.g, mode_color.b, 255);
+    draw_list_circle(list, x, y, size);
+}
+
+// Query line and result list over the map
+void draw_search_panel(AppContext *ctx) {
+    const PlaceSearch *places = &ctx->places;
+    int x = ctx->view_w - 330, y = 10, w = 320;
+    int h = 60 + (places->count > 0 ? places->count : 1) * 24;
+    SDL_SetRenderDrawColor(ctx->renderer, 10, 10, 10, 220);
+    SDL_FRect panel = {(float)x, (float)y, (float)w, (float)h};
+    SDL_RenderFillRect(ctx->renderer, &panel);
+    
+    char line[PLACE_SEARCH_MAX_QUERY + 16];
+    snprintf(line, sizeof(line), "FIND: %s_", ctx->search_text);
+    draw_text(ctx, FONT_ARIAL_BOLD, line, x + 10, y + 10, COLOR_PRIMARY, false);
+    
+    if (!places->db) {
+        draw_text(ctx, FONT_ARIAL_SMALL, "No place index (make indexes)", x + 10, y + 44, COLOR_POLARIS_AMBER, false);
+        return;
+    }
+    if (places->count == 0) {
+        draw_text(ctx, FONT_ARIAL_SMALL, ctx->search_text[0] ? "No matches" : "Type a name",
+                  x + 10, y + 44, COLOR_PRIMARY, false);
+        return;
+    }
+    for (int i = 0; i < places->count; i++) {
+        const PlaceResult *place = &places->results[i];
+        int row_y = y + 44 + i * 24;
+        if (i == ctx->search_selected) {
+            SDL_SetRenderDrawColor(ctx->renderer, COLOR_PRIMARY.r, COLOR_PRIMARY.g, COLOR_PRIMARY.b, 60);
+            SDL_FRect highlight = {(float)(x + 4), (float)(row_y - 2), (float)(w - 8), 22};
+            SDL_RenderFillRect(ctx->renderer, &highlight);
         }
+        snprintf(line, sizeof(line), "%.40s", place->name);
+        draw_text(ctx, FONT_ARIAL_SMALL, line, x + 10, row_y, COLOR_PRIMARY, false);
+        draw_text(ctx, FONT_ARIAL_SMALL, place->kind, x + w - 80, row_y, COLOR_POLARIS_AMBER, false);
     }
+    snprintf(line, sizeof(line), "%.1f ms", places->last_query_ms);
+    draw_text(ctx, FONT_ARIAL_SMALL, line, x + w - 70, y + 12, COLOR_PRIMARY, false);
+}
+
+// Ride statistics page: belt/engine temp p50/p95/p99, speed and belt heat time
+void draw_stats_page(DrawList *list, const RideStats *stats, StatsScope scope, int x, int y, int w) {
+    static const char *scope_labels[STATS_SCOPE_COUNT] = {"RIDE", "TRIP A", "TRIP B"};
+    char line[48];
+    
+    snprintf(line, sizeof(line), "%s STATS", scope_labels[scope]);
+    record_text(list, FONT_ARIAL_BOLD, line, x + w/2, y + 12, COLOR_PRIMARY, true);
+    
+    snprintf(line, sizeof(line), "BELT %d/%d/%d",
+             (int)ride_stats_quantile(stats, STATS_HIST_BELT_TEMP, 0.50f),
+             (int)ride_stats_quantile(stats, STATS_HIST_BELT_TEMP, 0.95f),
+             (int)ride_stats_quantile(stats, STATS_HIST_BELT_TEMP, 0.99f));
+    record_text(list, FONT_ARIAL_SMALL, line, x + 10, y + 30, COLOR_PRIMARY, false);
+    
+    snprintf(line, sizeof(line), "ENG %d/%d/%d",
+             (int)ride_stats_quantile(stats, STATS_HIST_ENGINE_TEMP, 0.50f),
+             (int)ride_stats_quantile(stats, STATS_HIST_ENGINE_TEMP, 0.95f),
+             (int)ride_stats_quantile(stats, STATS_HIST_ENGINE_TEMP, 0.99f));
+    record_text(list, FONT_ARIAL_SMALL, line, x + 10, y + 48, COLOR_PRIMARY, false);
+    
+    // Speed in KM/H like the main gauge
+    float max_kmh = stats->seconds > 0 ? fmaxf(stats->max[SENSOR_SPEED], -stats->min[SENSOR_SPEED]) * 1.60934f : 0.0f;
+    snprintf(line, sizeof(line), "MAX %d AVG %d", (int)max_kmh,
+             (int)(fabsf(ride_stats_mean(stats, SENSOR_SPEED)) * 1.60934f));
+    record_text(list, FONT_ARIAL_SMALL, line, x + 10, y + 66, COLOR_PRIMARY, false);
+    
+    int hot_seconds = (int)stats->above_seconds[SENSOR_BELT_TEMP];
+    snprintf(line, sizeof(line), "BELT HOT %d:%02d", hot_seconds / 60, hot_seconds % 60);
+    record_text(list, FONT_ARIAL_SMALL, line, x + 10, y + 84, COLOR_PRIMARY, false);
+}
+
+// History graph page: belt temp, RPM and speed over the selected span
+void draw_history_page(AppContext *ctx) {
+    static const struct {
+        HistoryChannelId id;
+        const char *label;
+        float lo, hi;
+        Color color;
+    } graphs[HISTORY_CHANNEL_COUNT] = {
+        {HISTORY_BELT_TEMP, "BELT", 80.0f, 220.0f, {255, 180, 0, 255}},
+        {HISTORY_RPM, "RPM", 0.0f, 9000.0f, {0, 212, 255, 255}},
+        {HISTORY_SPEED, "MPH", -25.0f, 120.0f, {0, 255, 136, 255}},
+    };
     
-    (void)mode_text;  // Not used in simple rendering
+    char title[32];
+    snprintf(title, sizeof(title), "HISTORY  %s", HISTORY_SPAN_LABELS[ctx->history_span]);
+    draw_text(ctx, FONT_ARIAL_BOLD, title, 25, 15, COLOR_PRIMARY, false);
+    draw_text(ctx, FONT_ARIAL_SMALL, "LEFT/RIGHT: ZOOM  G: DASHBOARD", ctx->view_w - 290, 20, COLOR_PRIMARY, false);
+    
+    int panel_h = (ctx->view_h - 60) / HISTORY_CHANNEL_COUNT;
+    for (int i = 0; i < HISTORY_CHANNEL_COUNT; i++) {
+        int y = 50 + i * panel_h;
+        draw_list_reset(&ctx->ui_list);
+        draw_list_color(&ctx->ui_list, COLOR_GLASS.r, COLOR_GLASS.g, COLOR_GLASS.b, COLOR_GLASS.a);
+        draw_list_filled_rounded_rect(&ctx->ui_list, 10, y, ctx->view_w - 20, panel_h - 10, 10);
+        draw_list_submit(&ctx->ui_list, ctx->renderer, &ctx->fonts, 0);
+        draw_text(ctx, FONT_ARIAL_BOLD, graphs[i].label, 25, y + 10, graphs[i].color, false);
+        
+        SDL_FRect rect = {100.0f, (float)(y + 8), (float)(ctx->view_w - 120), (float)(panel_h - 26)};
+        SDL_Color color = {graphs[i].color.r, graphs[i].color.g, graphs[i].color.b, 255};
+        int columns = (int)rect.w / quality_governor_profile(&ctx->governor)->graph_column_divisor;
+        history_graph_draw(&ctx->history, ctx->renderer, &ctx->frame_arena, graphs[i].id,
+                           HISTORY_SPANS_MS[ctx->history_span], &rect, columns, graphs[i].lo, graphs[i].hi, color);
+    }
 }
 
 // Boot screen animation
 void draw_boot_screen(AppContext *ctx) {
     Uint32 elapsed = SDL_GetTicks() - ctx->boot_start_time;
     float progress = fminf(elapsed / 3000.0f, 1.0f);
+    DrawList *list = &ctx->ui_list;
+    draw_list_reset(list);
     
     // Draw SNOW-PI logo
-    int center_x = WINDOW_WIDTH / 2;
-    int center_y = WINDOW_HEIGHT / 2;
+    int center_x = ctx->view_w / 2;
+    int center_y = ctx->view_h / 2;
     
     // Animated circle
-    SDL_SetRenderDrawColor(ctx->renderer, COLOR_PRIMARY.r, COLOR_PRIMARY.g, COLOR_PRIMARY.b, 255);
+    draw_list_color(list, COLOR_PRIMARY.r, COLOR_PRIMARY.g, COLOR_PRIMARY.b, 255);
     int circle_radius = (int)(100 * progress);
-    draw_circle(ctx->renderer, center_x, center_y, circle_radius);
+    draw_list_circle(list, center_x, center_y, circle_radius);
     
     // Boot text using TTF
     if (progress > 0.3f) {
-        draw_text_ttf(ctx->renderer, ctx->font_arial_bold, "SNOW-PI", center_x, center_y - 150, COLOR_PRIMARY, true);
+        record_text(list, FONT_ARIAL_BOLD, "SNOW-PI", center_x, center_y - 150, COLOR_PRIMARY, true);
     }
     
     if (progress > 0.5f) {
-        draw_text_ttf(ctx->renderer, ctx->font_arial_small, "Pi-Dash", center_x, center_y, COLOR_SUCCESS, true);
+        record_text(list, FONT_ARIAL_SMALL, "Pi-Dash", center_x, center_y, COLOR_SUCCESS, true);
     }
     
     // Progress bar
@@ -1042,42 +1705,19 @@ void draw_boot_screen(AppContext *ctx) {
         int bar_x = center_x - bar_w / 2;
         int bar_y = center_y + 120;
         
-        SDL_SetRenderDrawColor(ctx->renderer, COLOR_BORDER.r, COLOR_BORDER.g, COLOR_BORDER.b, 255);
+        draw_list_color(list, COLOR_BORDER.r, COLOR_BORDER.g, COLOR_BORDER.b, 255);
         SDL_FRect bar_bg = {(float)bar_x, (float)bar_y, (float)bar_w, (float)bar_h};
-        SDL_RenderRect(ctx->renderer, &bar_bg);
+        draw_list_rect(list, &bar_bg);
         
-        SDL_SetRenderDrawColor(ctx->renderer, COLOR_PRIMARY.r, COLOR_PRIMARY.g, COLOR_PRIMARY.b, 255);
+        draw_list_color(list, COLOR_PRIMARY.r, COLOR_PRIMARY.g, COLOR_PRIMARY.b, 255);
         SDL_FRect bar_fill = {(float)bar_x, (float)bar_y, bar_w * progress, (float)bar_h};
-        SDL_RenderFillRect(ctx->renderer, &bar_fill);
+        draw_list_fill_rect(list, &bar_fill);
     }
     
     // Hint text
     if (progress > 0.7f) {
-        draw_text_ttf(ctx->renderer, ctx->font_arial_small, "PRESS SPACE TO SKIP", center_x, WINDOW_HEIGHT - 50, COLOR_SUCCESS, true);
-    }
-}
-
-void draw_filled_rounded_rect(SDL_Renderer *renderer, int x, int y, int w, int h, int radius) {
-    // Main rectangle
-    SDL_FRect center = {(float)(x + radius), (float)y, (float)(w - 2 * radius), (float)h};
-    SDL_RenderFillRect(renderer, &center);
-    
-    SDL_FRect left = {(float)x, (float)(y + radius), (float)radius, (float)(h - 2 * radius)};
-    SDL_RenderFillRect(renderer, &left);
-    
-    SDL_FRect right = {(float)(x + w - radius), (float)(y + radius), (float)radius, (float)(h - 2 * radius)};
-    SDL_RenderFillRect(renderer, &right);
-    
-    // Corners (simplified filled circles)
-    for (int cy = 0; cy < radius; cy++) {
-        for (int cx = 0; cx < radius; cx++) {
-            if (cx*cx + cy*cy <= radius*radius) {
-                SDL_RenderPoint(renderer, (float)(x + radius - cx), (float)(y + radius - cy));
-                SDL_RenderPoint(renderer, (float)(x + w - radius + cx), (float)(y + radius - cy));
-                SDL_RenderPoint(renderer, (float)(x + radius - cx), (float)(y + h - radius + cy));
-                SDL_RenderPoint(renderer, (float)(x + w - radius + cx), (float)(y + h - radius + cy));
-            }
-        }
+        record_text(list, FONT_ARIAL_SMALL, "PRESS SPACE TO SKIP", center_x, ctx->view_h - 50, COLOR_SUCCESS, true);
     }
+    draw_list_submit(list, ctx->renderer, &ctx->fonts, 0);
 }
 
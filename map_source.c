@@ -0,0 +1,446 @@
+/*
+ * Snow-Pi Map Source - One MBTiles layer of the map
+ * Author: /x64/dumped
+ * GitHub: @Ma110w
+ *
+ * Each source has its own database handle, tile cache and existence
+ * index. The index is a bitmap per zoom built on the loader thread, so a
+ * sparse overlay answers "no tile here" without touching SQLite. Overlay
+ * tiles decode to ARGB with transparency: BMP tiles keep their alpha and
+ * vector tiles have their lines drawn in the source's colour. Decoded
+ * pixels also go to the shared disk cache for the next start.
+ */
+
+#include "map_source.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "metrics.h"
+#include "mvt_decode.h"
+#include "pixel_convert.h"
+
+bool map_source_init(MapSource *source, const char *name, const char *path, bool overlay, SDL_Color line_color,
+                     SDL_PixelFormat format, size_t cache_bytes) {
+    memset(source, 0, sizeof(*source));
+    source->name = name;
+    SDL_strlcpy(source->path, path, sizeof(source->path));
+    source->overlay = overlay;
+    source->line_color = line_color;
+    source->format = format;
+    SDL_SetAtomicInt(&source->ready, 0);
+    SDL_SetAtomicInt(&source->indexed, 0);
+    int slots = (int)(cache_bytes / (MAP_TILE_SIZE * MAP_TILE_SIZE * SDL_BYTESPERPIXEL(format)));
+    if (!fixed_pool_init(&source->tile_pool, sizeof(MapTile), slots > 0 ? slots : 1)) {
+        fprintf(stderr, "Cannot allocate %s tile pool\n", name);
+        return false;
+    }
+    return true;
+}
+
+// Open the database and touch the schema so the first tile query is fast.
+// Runs on the loader thread; nothing reads the source until ready is 1.
+bool map_source_open(MapSource *source) {
+    Uint64 start = SDL_GetTicksNS();
+    sqlite3 *db = NULL;
+
+    int rc = sqlite3_open_v2(source->path, &db, SQLITE_OPEN_READONLY, NULL);
+    if (rc == SQLITE_OK) {
+        rc = sqlite3_exec(db, "SELECT 1 FROM tiles LIMIT 1", NULL, NULL, NULL);
+    }
+    if (rc != SQLITE_OK) {
+        // Overlays are optional; only a missing base map is an error
+        if (source->overlay) printf("No %s layer (%s)\n", source->name, source->path);
+        else fprintf(stderr, "Cannot open MBTiles database: %s\n", sqlite3_errmsg(db));
+        sqlite3_close(db);
+        SDL_SetAtomicInt(&source->ready, -1);
+        return false;
+    }
+
+    source->db = db;
+    SDL_SetAtomicInt(&source->ready, 1);
+    printf("%s layer opened in %.1f ms\n", source->name, (SDL_GetTicksNS() - start) / 1e6);
+    return true;
+}
+
+// Scan which tiles exist. Uses its own connection so tile reads on the
+// main thread never wait behind the scan.
+void map_source_build_index(MapSource *source, SDL_AtomicInt *stop) {
+    if (SDL_GetAtomicInt(&source->ready) != 1) return;
+    Uint64 start = SDL_GetTicksNS();
+    sqlite3 *db = NULL;
+    sqlite3_stmt *stmt = NULL;
+    if (sqlite3_open_v2(source->path, &db, SQLITE_OPEN_READONLY, NULL) != SQLITE_OK ||
+        sqlite3_prepare_v2(db, "SELECT zoom_level, MIN(tile_column), MAX(tile_column), MIN(tile_row), MAX(tile_row) "
+                               "FROM tiles GROUP BY zoom_level", -1, &stmt, NULL) != SQLITE_OK) {
+        sqlite3_close(db);
+        return;
+    }
+
+    for (int z = 0; z <= MAP_SOURCE_MAX_ZOOM; z++) source->index[z].empty = true;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        int z = sqlite3_column_int(stmt, 0);
+        if (z < 0 || z > MAP_SOURCE_MAX_ZOOM) continue;
+        MapTileIndex *index = &source->index[z];
+        index->empty = false;
+        index->min_x = sqlite3_column_int(stmt, 1);
+        index->min_y = sqlite3_column_int(stmt, 3);  // TMS rows, as stored
+        index->w = sqlite3_column_int(stmt, 2) - index->min_x + 1;
+        index->h = sqlite3_column_int(stmt, 4) - index->min_y + 1;
+        size_t bits = (size_t)index->w * (size_t)index->h;
+        if (bits <= MAP_SOURCE_INDEX_MAX_BITS) index->bits = calloc((bits + 7) / 8, 1);
+    }
+    sqlite3_finalize(stmt);
+
+    size_t tiles = 0;
+    bool stopped = false;
+    if (sqlite3_prepare_v2(db, "SELECT tile_column, tile_row FROM tiles WHERE zoom_level = ?", -1, &stmt,
+                           NULL) == SQLITE_OK) {
+        for (int z = 0; z <= MAP_SOURCE_MAX_ZOOM && !stopped; z++) {
+            MapTileIndex *index = &source->index[z];
+            if (!index->bits) continue;
+            sqlite3_bind_int(stmt, 1, z);
+            while (sqlite3_step(stmt) == SQLITE_ROW) {
+                size_t bit = (size_t)(sqlite3_column_int(stmt, 1) - index->min_y) * index->w +
+                             (size_t)(sqlite3_column_int(stmt, 0) - index->min_x);
+                index->bits[bit >> 3] |= (uint8_t)(1u << (bit & 7));
+                if ((++tiles & 4095) == 0 && SDL_GetAtomicInt(stop)) {
+                    stopped = true;
+                    break;
+                }
+            }
+            sqlite3_reset(stmt);
+        }
+        sqlite3_finalize(stmt);
+    }
+    sqlite3_close(db);
+    if (stopped) return;
+
+    SDL_SetAtomicInt(&source->indexed, 1);
+    printf("%s layer indexed: %zu tiles in %.1f ms\n", source->name, tiles, (SDL_GetTicksNS() - start) / 1e6);
+}
+
+// False only when the source certainly has no such tile
+bool map_source_may_have(MapSource *source, int zoom, int tile_x, int tile_y) {
+    if (SDL_GetAtomicInt(&source->ready) != 1 || zoom < 0 || zoom > MAP_SOURCE_MAX_ZOOM) return false;
+    if (SDL_GetAtomicInt(&source->indexed) != 1) return true;
+
+    const MapTileIndex *index = &source->index[zoom];
+    if (index->empty) return false;
+    if (!index->bits) return true;
+    int ix = tile_x - index->min_x;
+    int iy = (1 << zoom) - 1 - tile_y - index->min_y;
+    if (ix < 0 || iy < 0 || ix >= index->w || iy >= index->h) return false;
+    size_t bit = (size_t)iy * index->w + (size_t)ix;
+    return index->bits[bit >> 3] & (1u << (bit & 7));
+}
+
+// Record what a lookup found, or that a tile was added
+void map_source_mark(MapSource *source, int zoom, int tile_x, int tile_y, bool present) {
+    if (SDL_GetAtomicInt(&source->indexed) != 1 || zoom < 0 || zoom > MAP_SOURCE_MAX_ZOOM) return;
+
+    MapTileIndex *index = &source->index[zoom];
+    int ix = tile_x - index->min_x;
+    int iy = (1 << zoom) - 1 - tile_y - index->min_y;
+    bool inside = !index->empty && ix >= 0 && iy >= 0 && ix < index->w && iy < index->h;
+    if (index->bits && inside) {
+        size_t bit = (size_t)iy * index->w + (size_t)ix;
+        if (present) index->bits[bit >> 3] |= (uint8_t)(1u << (bit & 7));
+        else index->bits[bit >> 3] &= (uint8_t)~(1u << (bit & 7));
+    } else if (present && !inside) {
+        // Outside what was scanned: stop trusting the index at this zoom
+        free(index->bits);
+        index->bits = NULL;
+        index->empty = false;
+    }
+}
+
+// Copy XRGB8888 rows into a tile buffer, packing them to RGB565 on the 16 bpp pipeline
+static void map_source_copy_xrgb(MapSource *source, void *dst, const Uint32 *pixels, int pitch) {
+    for (int y = 0; y < MAP_TILE_SIZE; y++) {
+        const Uint32 *row = (const Uint32 *)((const Uint8 *)pixels + (size_t)y * pitch);
+        if (source->format == SDL_PIXELFORMAT_RGB565) {
+            pixel_convert_xrgb8888_to_rgb565(row, (Uint16 *)dst + y * MAP_TILE_SIZE, MAP_TILE_SIZE);
+        } else {
+            memcpy((Uint32 *)dst + y * MAP_TILE_SIZE, row, MAP_TILE_SIZE * sizeof(Uint32));
+        }
+    }
+}
+
+// Vector overlay lines drawn into a transparent tile
+typedef struct {
+    Uint32 *pixels;
+    Uint32 color;
+    int drawn;
+} MapRaster;
+
+static void map_raster_line(MapRaster *raster, int x0, int y0, int x1, int y1) {
+    int dx = abs(x1 - x0), dy = -abs(y1 - y0);
+    int sx = x0 < x1 ? 1 : -1, sy = y0 < y1 ? 1 : -1;
+    int err = dx + dy;
+    for (;;) {
+        // Two pixels wide so lines survive the 16 bpp pipeline and scaling
+        for (int i = 0; i < 2; i++) {
+            int x = x0 + i;
+            if (x >= 0 && x < MAP_TILE_SIZE && y0 >= 0 && y0 < MAP_TILE_SIZE) {
+                raster->pixels[y0 * MAP_TILE_SIZE + x] = raster->color;
+                raster->drawn++;
+            }
+        }
+        if (x0 == x1 && y0 == y1) break;
+        int e2 = 2 * err;
+        if (e2 >= dy) { err += dy; x0 += sx; }
+        if (e2 <= dx) { err += dx; y0 += sy; }
+    }
+}
+
+static void map_raster_feature(void *user, const MvtLayer *layer, const MvtFeature *feature) {
+    MapRaster *raster = user;
+    if (feature->type != MVT_LINESTRING && feature->type != MVT_POLYGON) return;
+    double scale = (double)MAP_TILE_SIZE / (layer->extent ? layer->extent : 4096);
+    for (int p = 0; p < feature->part_count; p++) {
+        int first = feature->part_start[p], end = feature->part_start[p + 1];
+        for (int i = first + 1; i <= end; i++) {
+            // Polygon rings close back to their first point
+            if (i == end && feature->type != MVT_POLYGON) break;
+            const MvtPoint *a = &feature->points[i - 1];
+            const MvtPoint *b = &feature->points[i == end ? first : i];
+            map_raster_line(raster, (int)lround(a->x * scale), (int)lround(a->y * scale),
+                            (int)lround(b->x * scale), (int)lround(b->y * scale));
+        }
+    }
+}
+
+// Decode a tile blob to pixels in the source's texture format, tightly
+// packed. The buffer comes from the frame arena; NULL means nothing to draw.
+static void *map_source_decode_pixels(MapSource *source, FrameArena *arena, const void *blob, int blob_size) {
+    int bpp = SDL_BYTESPERPIXEL(source->format);
+    void *pixels = frame_arena_alloc(arena, (size_t)MAP_TILE_SIZE * MAP_TILE_SIZE * bpp);
+    if (!pixels) return NULL;
+
+    // BMP tiles decode through SDL; only those pay for a surface
+    if (blob_size > 2 && memcmp(blob, "BM", 2) == 0) {
+        SDL_IOStream *io = SDL_IOFromConstMem(blob, blob_size);
+        SDL_Surface *surface = io ? SDL_LoadBMP_IO(io, true) : NULL;
+        SDL_PixelFormat wanted = source->overlay ? SDL_PIXELFORMAT_ARGB8888 : SDL_PIXELFORMAT_XRGB8888;
+        SDL_Surface *converted = surface ? SDL_ConvertSurface(surface, wanted) : NULL;
+        bool ok = converted && converted->w == MAP_TILE_SIZE && converted->h == MAP_TILE_SIZE;
+        if (ok) map_source_copy_xrgb(source, pixels, converted->pixels, converted->pitch);
+        SDL_DestroySurface(converted);
+        SDL_DestroySurface(surface);
+        if (ok) return pixels;
+    }
+
+    // Vector overlays: draw every line and ring in the layer colour
+    if (source->overlay) {
+        uint8_t *data = NULL;
+        size_t len = 0;
+        MapRaster raster = {pixels, 0xFF000000u | (Uint32)source->line_color.r << 16 |
+                            (Uint32)source->line_color.g << 8 | source->line_color.b, 0};
+        memset(pixels, 0, MAP_TILE_SIZE * MAP_TILE_SIZE * sizeof(Uint32));
+        bool ok = mvt_inflate(blob, (size_t)blob_size, &data, &len) &&
+                  mvt_decode(data, len, map_raster_feature, &raster) && raster.drawn > 0;
+        free(data);
+        return ok ? pixels : NULL;
+    }
+
+    // Most MBTiles are PNG/JPG, which would need SDL3_image.
+    // For now draw a placeholder colored tile, written in the texture's own format.
+    if (source->format == SDL_PIXELFORMAT_RGB565) {
+        pixel_fill_rgb565(pixels, PIXEL_RGB565(100, 120, 140), MAP_TILE_SIZE * MAP_TILE_SIZE);
+    } else {
+        Uint32 *px = pixels;
+        for (int i = 0; i < MAP_TILE_SIZE * MAP_TILE_SIZE; i++) {
+            px[i] = 0xFF64788Cu;  // RGB 100, 120, 140
+        }
+    }
+    return pixels;
+}
+
+// The registry reclaimed a tile's texture; give its slot back
+static void map_source_tile_evicted(void *owner, void *item) {
+    MapSource *source = owner;
+    MapTile *tile = item;
+    tile->texture = NULL;
+    tile->handle = -1;
+    fixed_pool_free(&source->tile_pool, tile);
+}
+
+MapTile *map_tile_find(FixedPool *pool, int zoom, int tile_x, int tile_y) {
+    for (int i = 0; i < pool->capacity; i++) {
+        MapTile *tile = (MapTile *)(pool->slots + (size_t)i * pool->slot_size);
+        if (tile->texture && tile->zoom == zoom && tile->x == tile_x && tile->y == tile_y) return tile;
+    }
+    return NULL;
+}
+
+// Free the pool's least recently drawn tile. Returns false when every
+// tile in it was drawn this frame.
+bool map_tile_pool_evict(FixedPool *pool, TextureRegistry *textures) {
+    MapTile *victim = NULL;
+    uint64_t oldest = textures->frame;
+    for (int i = 0; i < pool->capacity; i++) {
+        MapTile *tile = (MapTile *)(pool->slots + (size_t)i * pool->slot_size);
+        if (!tile->texture || textures->entries[tile->handle].last_used >= oldest) continue;
+        oldest = textures->entries[tile->handle].last_used;
+        victim = tile;
+    }
+    if (!victim) return false;
+    texture_registry_destroy(textures, victim->handle);
+    victim->texture = NULL;
+    victim->handle = -1;
+    fixed_pool_free(pool, victim);
+    return true;
+}
+
+static void map_source_release(MapSource *source, TextureRegistry *textures, MapTile *tile) {
+    texture_registry_destroy(textures, tile->handle);
+    tile->texture = NULL;
+    tile->handle = -1;
+    fixed_pool_free(&source->tile_pool, tile);
+}
+
+// A cache slot with a texture for the tile, or NULL
+static MapTile *map_source_new_tile(MapSource *source, TextureRegistry *textures, int zoom, int tile_x, int tile_y) {
+    // A full cache gives up its own least recently drawn tile
+    MapTile *tile = fixed_pool_alloc(&source->tile_pool);
+    if (!tile && map_tile_pool_evict(&source->tile_pool, textures)) {
+        tile = fixed_pool_alloc(&source->tile_pool);
+    }
+    if (!tile) {
+        source->pool_full = true;
+        return NULL;
+    }
+
+    tile->zoom = zoom;
+    tile->x = tile_x;
+    tile->y = tile_y;
+    tile->handle = texture_registry_create(textures, source->format, SDL_TEXTUREACCESS_STATIC, MAP_TILE_SIZE,
+                                           MAP_TILE_SIZE, TEXTURE_TILE, map_source_tile_evicted, source, tile,
+                                           &tile->texture);
+    if (!tile->texture) {
+        fixed_pool_free(&source->tile_pool, tile);
+        return NULL;
+    }
+    if (source->overlay) SDL_SetTextureBlendMode(tile->texture, SDL_BLENDMODE_BLEND);
+    return tile;
+}
+
+// Get a tile from this source's cache, the disk cache, or its database on
+// a miss. NULL means the source has nothing to draw there.
+MapTile *map_source_get_tile(MapSource *source, TextureRegistry *textures, FrameArena *arena, int zoom, int tile_x,
+                             int tile_y) {
+    MapTile *tile = map_tile_find(&source->tile_pool, zoom, tile_x, tile_y);
+    if (tile) {
+        texture_registry_touch(textures, tile->handle);
+        return tile;
+    }
+
+    // Decoded on an earlier run: upload straight from the mapped file,
+    // even before the database has opened
+    int pitch = MAP_TILE_SIZE * SDL_BYTESPERPIXEL(source->format);
+    uint64_t disk_key = TILE_DISK_KEY(source->disk_id, zoom, tile_x, tile_y);
+    const void *cached = source->disk ? tile_disk_cache_find(source->disk, disk_key, source->format) : NULL;
+    if (cached && (tile = map_source_new_tile(source, textures, zoom, tile_x, tile_y)) != NULL) {
+        if (SDL_UpdateTexture(tile->texture, NULL, cached, pitch)) {
+            dash_metrics.tile_disk_hits++;
+            return tile;
+        }
+        map_source_release(source, textures, tile);
+        tile = NULL;
+    }
+    if (!map_source_may_have(source, zoom, tile_x, tile_y)) return NULL;
+
+    // MBTiles uses TMS (inverted Y), need to flip
+    int max_y = (1 << zoom) - 1;
+    int tms_y = max_y - tile_y;
+
+    // Route tiles come from RAM; everything else from the database
+    const void *blob = NULL;
+    int blob_size = 0;
+    sqlite3_stmt *stmt = NULL;
+    const TilePack *pack = SDL_GetAtomicPointer((void **)&source->pack);
+    if (pack) {
+        if (tile_pack_find(pack, zoom, tile_x, tms_y, &blob, &blob_size)) dash_metrics.tile_pack_hits++;
+        else dash_metrics.tile_pack_misses++;
+    }
+    if (!blob) {
+        // Prepared once and reused, so a lookup allocates nothing in SQLite's parser
+        if (!source->tile_stmt) {
+            const char *sql = "SELECT tile_data FROM tiles WHERE zoom_level=? AND tile_column=? AND tile_row=?";
+            if (sqlite3_prepare_v3(source->db, sql, -1, SQLITE_PREPARE_PERSISTENT, &source->tile_stmt,
+                                   NULL) != SQLITE_OK) {
+                return NULL;
+            }
+        }
+        stmt = source->tile_stmt;
+        sqlite3_bind_int(stmt, 1, zoom);
+        sqlite3_bind_int(stmt, 2, tile_x);
+        sqlite3_bind_int(stmt, 3, tms_y);
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            blob = sqlite3_column_blob(stmt, 0);
+            blob_size = sqlite3_column_bytes(stmt, 0);
+        }
+    }
+
+    bool absent = true;
+    if (blob) {
+        absent = false;
+        Uint64 decode_start = SDL_GetTicksNS();
+
+        tile = map_source_new_tile(source, textures, zoom, tile_x, tile_y);
+        if (tile) {
+            size_t mark = frame_arena_mark(arena);
+            void *pixels = map_source_decode_pixels(source, arena, blob, blob_size);
+            if (pixels && SDL_UpdateTexture(tile->texture, NULL, pixels, pitch)) {
+                // Kept for the next start; the copy is written in the background
+                if (source->disk) {
+                    tile_disk_cache_put(source->disk, disk_key, source->format, pixels, (size_t)pitch * MAP_TILE_SIZE);
+                }
+            } else {
+                map_source_release(source, textures, tile);
+                tile = NULL;
+                absent = source->overlay && !pixels;  // An overlay tile with nothing drawable is as good as none
+            }
+            frame_arena_rewind(arena, mark);
+        }
+
+        dash_metrics.tile_decodes++;
+        dash_metrics.tile_decode_us += (SDL_GetTicksNS() - decode_start) / 1000;
+    }
+
+    if (stmt) sqlite3_reset(stmt);
+    if (absent) map_source_mark(source, zoom, tile_x, tile_y, false);
+    return tile;
+}
+
+// The tile changed in the database; the next lookup reads it again
+void map_source_drop_tile(MapSource *source, TextureRegistry *textures, int zoom, int tile_x, int tile_y) {
+    MapTile *tile = map_tile_find(&source->tile_pool, zoom, tile_x, tile_y);
+    if (tile) map_source_release(source, textures, tile);
+    if (source->disk) tile_disk_cache_drop(source->disk, TILE_DISK_KEY(source->disk_id, zoom, tile_x, tile_y));
+    map_source_mark(source, zoom, tile_x, tile_y, true);
+}
+
+// The loader thread must have finished
+void map_source_close(MapSource *source, TextureRegistry *textures) {
+    for (int i = 0; i < source->tile_pool.capacity; i++) {
+        MapTile *tile = (MapTile *)(source->tile_pool.slots + (size_t)i * source->tile_pool.slot_size);
+        if (tile->texture) texture_registry_destroy(textures, tile->handle);
+    }
+    fixed_pool_destroy(&source->tile_pool);
+    for (int z = 0; z <= MAP_SOURCE_MAX_ZOOM; z++) {
+        free(source->index[z].bits);
+        source->index[z].bits = NULL;
+    }
+    SDL_SetAtomicInt(&source->indexed, 0);
+    tile_pack_free(SDL_SetAtomicPointer((void **)&source->pack, NULL));
+    if (source->tile_stmt) {
+        sqlite3_finalize(source->tile_stmt);
+        source->tile_stmt = NULL;
+    }
+    if (source->db) {
+        sqlite3_close(source->db);
+        source->db = NULL;
+    }
+}
@@ -0,0 +1,79 @@
+/*
+ * Snow-Pi Map Source Header
+ * Author: /x64/dumped
+ */
+
+#ifndef MAP_SOURCE_H
+#define MAP_SOURCE_H
+
+#include <SDL3/SDL.h>
+#include <sqlite3.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "frame_memory.h"
+#include "texture_registry.h"
+#include "tile_disk_cache.h"
+#include "tile_pack.h"
+
+#define MAP_TILE_SIZE 256
+#define MAP_SOURCE_MAX_ZOOM 18
+#define MAP_SOURCE_INDEX_MAX_BITS (8 * 1024 * 1024)   // 1 MB per zoom; larger zooms ask the database
+
+typedef enum {
+    MAP_SOURCE_BASE,             // Opaque base map
+    MAP_SOURCE_TRAILS,           // Trail network overlay
+    MAP_SOURCE_ANNOTATIONS,      // The rider's own marks
+    MAP_SOURCE_COUNT
+} MapSourceId;
+
+// Cached decoded tile; the slot is free while texture is NULL
+typedef struct {
+    SDL_Texture *texture;
+    int handle;                  // Texture registry entry
+    int zoom;
+    int x;
+    int y;
+} MapTile;
+
+// Tiles present at one zoom, as a bitmap over that zoom's bounding box
+typedef struct {
+    uint8_t *bits;               // NULL = not indexed, ask the database
+    int min_x;
+    int min_y;
+    int w;
+    int h;
+    bool empty;                  // The source has no tiles at this zoom
+} MapTileIndex;
+
+typedef struct {
+    const char *name;
+    char path[256];
+    bool overlay;                // Blended over the base; may be missing entirely
+    SDL_Color line_color;        // Vector overlay tiles are drawn in this colour
+    SDL_PixelFormat format;      // Texture format of decoded tiles
+    sqlite3 *db;                 // Only valid once ready is 1
+    sqlite3_stmt *tile_stmt;
+    SDL_AtomicInt ready;         // 0 = opening, 1 = open, -1 = failed or absent
+    SDL_AtomicInt indexed;       // 1 once index[] is complete
+    MapTileIndex index[MAP_SOURCE_MAX_ZOOM + 1];
+    FixedPool tile_pool;         // This source's decoded tiles
+    TilePack *pack;              // Preseeded route tiles; set once through SDL_SetAtomicPointer
+    TileDiskCache *disk;         // Decoded tiles kept across restarts, shared by all sources
+    int disk_id;                 // This source's part of the disk cache key
+    bool pool_full;              // A tile was skipped because every slot was drawn this frame
+} MapSource;
+
+bool map_source_init(MapSource *source, const char *name, const char *path, bool overlay, SDL_Color line_color,
+                     SDL_PixelFormat format, size_t cache_bytes);
+bool map_source_open(MapSource *source);
+void map_source_build_index(MapSource *source, SDL_AtomicInt *stop);
+bool map_source_may_have(MapSource *source, int zoom, int tile_x, int tile_y);
+void map_source_mark(MapSource *source, int zoom, int tile_x, int tile_y, bool present);
+MapTile *map_tile_find(FixedPool *pool, int zoom, int tile_x, int tile_y);
+bool map_tile_pool_evict(FixedPool *pool, TextureRegistry *textures);
+MapTile *map_source_get_tile(MapSource *source, TextureRegistry *textures, FrameArena *arena, int zoom, int tile_x,
+                             int tile_y);
+void map_source_drop_tile(MapSource *source, TextureRegistry *textures, int zoom, int tile_x, int tile_y);
+void map_source_close(MapSource *source, TextureRegistry *textures);
+
+#endif
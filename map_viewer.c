@@ -3,7 +3,9 @@
  * Author: /x64/dumped
  * GitHub: @Ma110w
  * 
- * Reads MBTiles (SQLite) format for offline map display
+ * Reads MBTiles (SQLite) format for offline map display. The base map,
+ * trail overlay and annotations are separate sources (map_source.c),
+ * blended per tile only where more than one of them has data.
  */
 
 #include <SDL3/SDL.h>
@@ -12,21 +14,15 @@
 #include <stdlib.h>
 #include <math.h>
 #include <stdbool.h>
+#include <string.h>
+#include "map_viewer.h"
+#include "metrics.h"
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 
-#define TILE_SIZE 256
-
-typedef struct {
-    sqlite3 *db;
-    SDL_Renderer *renderer;
-    double center_lat;
-    double center_lon;
-    int zoom_level;
-    bool active;
-} MapViewer;
+#define TILE_SIZE MAP_TILE_SIZE
 
 // Convert lat/lon to tile coordinates
 void latlon_to_tile(double lat, double lon, int zoom, int *tile_x, int *tile_y) {
@@ -37,116 +33,422 @@ void latlon_to_tile(double lat, double lon, int zoom, int *tile_x, int *tile_y)
     *tile_y = (int)((1.0 - log(tan(lat_rad) + 1.0 / cos(lat_rad)) / M_PI) / 2.0 * n);
 }
 
-// Initialize map viewer
-bool map_viewer_init(MapViewer *viewer, const char *mbtiles_path, SDL_Renderer *renderer) {
+// Same projection, in world pixels rather than whole tiles
+static void latlon_to_world(double lat, double lon, int zoom, double *world_x, double *world_y) {
+    double lat_rad = lat * M_PI / 180.0;
+    double n = pow(2.0, zoom) * TILE_SIZE;
+    
+    *world_x = (lon + 180.0) / 360.0 * n;
+    *world_y = (1.0 - log(tan(lat_rad) + 1.0 / cos(lat_rad)) / M_PI) / 2.0 * n;
+}
+
+// Open every source, base first so the map can draw as soon as possible,
+// then build the existence indexes. Runs on its own thread; each source
+// is ignored until its ready flag is set.
+static int map_viewer_open_thread(void *data) {
+    MapViewer *viewer = data;
+    for (int s = 0; s < MAP_SOURCE_COUNT; s++) {
+        map_source_open(&viewer->sources[s]);
+    }
+    // Sparse overlays first: they are small and save the most lookups
+    for (int s = MAP_SOURCE_COUNT - 1; s >= 0 && !SDL_GetAtomicInt(&viewer->stop); s--) {
+        map_source_build_index(&viewer->sources[s], &viewer->stop);
+    }
+    return 0;
+}
+
+static bool map_viewer_ready(MapViewer *viewer) {
+    return SDL_GetAtomicInt(&viewer->sources[MAP_SOURCE_BASE].ready) == 1;
+}
+
+// Initialize map viewer. Returns once the open has been started;
+// failures to open are reported from the background thread.
+bool map_viewer_init(MapViewer *viewer, const char *mbtiles_path, SDL_Renderer *renderer, FrameArena *arena,
+                     TextureRegistry *textures, SDL_PixelFormat tile_format) {
     viewer->renderer = renderer;
+    viewer->tile_format = tile_format;
+    viewer->arena = arena;
+    viewer->textures = textures;
     viewer->center_lat = 46.8797;  // Default to northern Ontario
     viewer->center_lon = -84.3397;
     viewer->zoom_level = 10;
     viewer->active = false;
+    viewer->heading_up = false;
+    viewer->heading = 0.0f;
+    viewer->open_thread = NULL;
+    viewer->preseed_thread = NULL;
+    viewer->route = NULL;
+    viewer->route_points = 0;
+    SDL_SetAtomicInt(&viewer->stop, 0);
+    viewer->sources_seen = 0;
+    viewer->layer = NULL;
+    viewer->layer_handle = -1;
+    viewer->layer_dirty = true;
+    viewer->refresh_ms = 0;
+    viewer->prefetch_radius = 0;
+    viewer->prefetch_cursor = 0;
+    viewer->prefetch_zoom = -1;
+    memset(&viewer->inset, 0, sizeof(viewer->inset));
+    viewer->inset.handle = -1;
+    viewer->inset.refresh_ms = 250;
     
-    // Open MBTiles database
-    int rc = sqlite3_open(mbtiles_path, &viewer->db);
-    if (rc != SQLITE_OK) {
-        fprintf(stderr, "Cannot open MBTiles database: %s\n", sqlite3_errmsg(viewer->db));
+    SDL_Color trail_color = {0, 255, 136, 255};
+    SDL_Color note_color = {255, 0, 255, 255};
+    if (!map_source_init(&viewer->sources[MAP_SOURCE_BASE], "Base", mbtiles_path, false, trail_color, tile_format,
+                         MAP_TILE_CACHE_BYTES) ||
+        !map_source_init(&viewer->sources[MAP_SOURCE_TRAILS], "Trails", MAP_TRAILS_PATH, true, trail_color,
+                         SDL_PIXELFORMAT_ARGB8888, MAP_OVERLAY_CACHE_BYTES) ||
+        !map_source_init(&viewer->sources[MAP_SOURCE_ANNOTATIONS], "Annotations", MAP_ANNOTATIONS_PATH, true,
+                         note_color, SDL_PIXELFORMAT_ARGB8888, MAP_OVERLAY_CACHE_BYTES) ||
+        !fixed_pool_init(&viewer->composite_pool, sizeof(MapTile), MAP_COMPOSITE_SLOTS)) {
+        fprintf(stderr, "Cannot allocate map tile pool\n");
         return false;
     }
     
-    printf("MBTiles database opened successfully\n");
+    // Tiles decoded before the last power-down draw without their databases
+    tile_disk_cache_open(&viewer->disk_cache, TILE_DISK_CACHE_PATH, TILE_DISK_CACHE_BYTES);
+    for (int s = 0; s < MAP_SOURCE_COUNT; s++) {
+        tile_disk_cache_check_source(&viewer->disk_cache, s, viewer->sources[s].path);
+        viewer->sources[s].disk = &viewer->disk_cache;
+        viewer->sources[s].disk_id = s;
+    }
+    
+    viewer->open_thread = SDL_CreateThread(map_viewer_open_thread, "map-open", viewer);
+    if (!viewer->open_thread) {
+        fprintf(stderr, "Cannot start map loader: %s\n", SDL_GetError());
+        return false;
+    }
     return true;
 }
 
-// Get tile from database
-SDL_Texture* map_viewer_get_tile(MapViewer *viewer, int zoom, int tile_x, int tile_y) {
-    sqlite3_stmt *stmt;
+// Work out the corridor tiles, then read them from each source as it
+// opens. Low priority so the render thread always wins the CPU.
+static int map_viewer_preseed_thread(void *data) {
+    MapViewer *viewer = data;
+    SDL_SetCurrentThreadPriority(SDL_THREAD_PRIORITY_LOW);
+    Uint64 start = SDL_GetTicksNS();
     
-    // MBTiles uses TMS (inverted Y), need to flip
-    int max_y = (1 << zoom) - 1;
-    int tms_y = max_y - tile_y;
-    
-    // Query tile from database
-    const char *sql = "SELECT tile_data FROM tiles WHERE zoom_level=? AND tile_column=? AND tile_row=?";
+    uint64_t *keys = NULL;
+    uint32_t wanted = tile_pack_corridor(viewer->route, viewer->route_points, viewer->corridor_m, &keys);
+    size_t budget = TILE_PACK_MAX_BYTES;
+    uint32_t packed = 0;
+    for (int s = 0; s < MAP_SOURCE_COUNT && !SDL_GetAtomicInt(&viewer->stop); s++) {
+        MapSource *source = &viewer->sources[s];
+        while (SDL_GetAtomicInt(&source->ready) == 0 && !SDL_GetAtomicInt(&viewer->stop)) SDL_Delay(20);
+        if (SDL_GetAtomicInt(&source->ready) != 1) continue;
+        TilePack *pack = tile_pack_read(source->path, keys, wanted, budget, &viewer->stop);
+        if (!pack) continue;
+        budget -= pack->data_size;
+        packed += pack->count;
+        SDL_SetAtomicPointer((void **)&source->pack, pack);
+    }
+    free(keys);
+    printf("Preseeded %u tiles (%.1f MB) from %u corridor cells at zoom %d-%d in %.0f ms\n", packed,
+           (TILE_PACK_MAX_BYTES - budget) / (1024.0 * 1024.0), wanted, TILE_PACK_MIN_ZOOM, TILE_PACK_MAX_ZOOM,
+           (SDL_GetTicksNS() - start) / 1e6);
+    return 0;
+}
+
+// Hold the tiles along a route (or around one point) in RAM for the ride.
+// Takes ownership of route, which is malloc'd lat, lon pairs.
+bool map_viewer_preseed(MapViewer *viewer, double *route, int route_points, double corridor_m) {
+    if (viewer->preseed_thread || route_points <= 0) {
+        free(route);
+        return false;
+    }
+    viewer->route = route;
+    viewer->route_points = route_points;
+    viewer->corridor_m = corridor_m;
+    viewer->preseed_thread = SDL_CreateThread(map_viewer_preseed_thread, "map-preseed", viewer);
+    if (!viewer->preseed_thread) {
+        fprintf(stderr, "Cannot start tile preseed: %s\n", SDL_GetError());
+        return false;
+    }
+    return true;
+}
+
+// Drop every cached composite; the next lookup blends the sources again
+static void map_viewer_flush_composites(MapViewer *viewer) {
+    for (int i = 0; i < viewer->composite_pool.capacity; i++) {
+        MapTile *tile = (MapTile *)(viewer->composite_pool.slots + (size_t)i * viewer->composite_pool.slot_size);
+        if (!tile->texture) continue;
+        texture_registry_destroy(viewer->textures, tile->handle);
+        tile->texture = NULL;
+        tile->handle = -1;
+        fixed_pool_free(&viewer->composite_pool, tile);
+    }
+}
+
+// An overlay that finishes opening after tiles were drawn without it
+// needs the composites, cached layer and inset redrawn once
+static void map_viewer_check_sources(MapViewer *viewer) {
+    int seen = 0;
+    for (int s = 0; s < MAP_SOURCE_COUNT; s++) {
+        if (SDL_GetAtomicInt(&viewer->sources[s].ready) == 1) seen |= 1 << s;
+    }
+    if (seen != viewer->sources_seen) {
+        viewer->sources_seen = seen;
+        map_viewer_flush_composites(viewer);
+        viewer->layer_dirty = true;
+        viewer->inset.drawn = false;
+    }
+}
+
+static void map_composite_evicted(void *owner, void *item) {
+    MapViewer *viewer = owner;
+    MapTile *tile = item;
+    tile->texture = NULL;
+    tile->handle = -1;
+    fixed_pool_free(&viewer->composite_pool, tile);
+}
+
+// The texture to draw for a tile. Where only one source has something
+// that source's own tile is used; otherwise the sources are blended once
+// into a cached composite, so overlays cost nothing while it stays cached.
+static SDL_Texture *map_viewer_get_tile(MapViewer *viewer, int zoom, int tile_x, int tile_y) {
+    dash_metrics.tile_requests++;
     
-    int rc = sqlite3_prepare_v2(viewer->db, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        return NULL;
+    MapTile *composite = map_tile_find(&viewer->composite_pool, zoom, tile_x, tile_y);
+    if (composite) {
+        dash_metrics.tile_cache_hits++;
+        texture_registry_touch(viewer->textures, composite->handle);
+        return composite->texture;
     }
     
-    sqlite3_bind_int(stmt, 1, zoom);
-    sqlite3_bind_int(stmt, 2, tile_x);
-    sqlite3_bind_int(stmt, 3, tms_y);
+    uint64_t decodes = dash_metrics.tile_decodes;
+    MapTile *layers[MAP_SOURCE_COUNT];
+    int count = 0;
+    for (int s = 0; s < MAP_SOURCE_COUNT; s++) {
+        MapSource *source = &viewer->sources[s];
+        MapTile *tile = map_source_get_tile(source, viewer->textures, viewer->arena, zoom, tile_x, tile_y);
+        if (tile) layers[count++] = tile;
+        // Skipped for want of a slot, not absent: draw the layer again
+        // next frame, when this frame's tiles can be evicted
+        if (source->pool_full) {
+            source->pool_full = false;
+            viewer->layer_dirty = true;
+        }
+    }
+    if (dash_metrics.tile_decodes == decodes) dash_metrics.tile_cache_hits++;
+    if (count == 0) return NULL;
+    if (count == 1) return layers[0]->texture;
     
-    SDL_Texture *texture = NULL;
+    // Source tiles were touched this frame, so eviction cannot take them
+    composite = fixed_pool_alloc(&viewer->composite_pool);
+    if (!composite && map_tile_pool_evict(&viewer->composite_pool, viewer->textures)) {
+        composite = fixed_pool_alloc(&viewer->composite_pool);
+    }
+    if (!composite) {
+        viewer->layer_dirty = true;
+        return layers[0]->texture;
+    }
+    composite->zoom = zoom;
+    composite->x = tile_x;
+    composite->y = tile_y;
+    composite->handle = texture_registry_create(viewer->textures, viewer->tile_format, SDL_TEXTUREACCESS_TARGET,
+                                                TILE_SIZE, TILE_SIZE, TEXTURE_TILE, map_composite_evicted, viewer,
+                                                composite, &composite->texture);
+    if (!composite->texture) {
+        fixed_pool_free(&viewer->composite_pool, composite);
+        return layers[0]->texture;
+    }
     
-    if (sqlite3_step(stmt) == SQLITE_ROW) {
-        // Get tile data
-        const void *blob = sqlite3_column_blob(stmt, 0);
-        int blob_size = sqlite3_column_bytes(stmt, 0);
-        
-        // Create SDL_IOStream from memory (SDL3 API)
-        SDL_IOStream *io = SDL_IOFromConstMem(blob, blob_size);
-        if (io) {
-            // Load image from memory (try BMP first, then PNG)
-            SDL_Surface *surface = SDL_LoadBMP_IO(io, false);
+    SDL_Texture *previous = SDL_GetRenderTarget(viewer->renderer);
+    SDL_SetRenderTarget(viewer->renderer, composite->texture);
+    SDL_SetRenderDrawColor(viewer->renderer, 0, 0, 0, 255);
+    SDL_RenderClear(viewer->renderer);
+    for (int i = 0; i < count; i++) {
+        SDL_RenderTexture(viewer->renderer, layers[i]->texture, NULL, NULL);
+    }
+    SDL_SetRenderTarget(viewer->renderer, previous);
+    return composite->texture;
+}
+
+// True if drawing the tile would not touch a database
+static bool map_viewer_tile_cached(MapViewer *viewer, int zoom, int tile_x, int tile_y) {
+    return map_tile_find(&viewer->composite_pool, zoom, tile_x, tile_y) ||
+           map_tile_find(&viewer->sources[MAP_SOURCE_BASE].tile_pool, zoom, tile_x, tile_y);
+}
+
+// Draw the tiles covering a width x height area into the current render
+// target, placed at origin and turned by angle degrees about pivot
+static void map_viewer_draw_tiles(MapViewer *viewer, int start_tile_x, int start_tile_y, int tiles_x, int tiles_y,
+                                  int screen_width, int screen_height, SDL_FPoint origin, double angle,
+                                  SDL_FPoint pivot) {
+    for (int ty = 0; ty < tiles_y; ty++) {
+        for (int tx = 0; tx < tiles_x; tx++) {
+            int tile_x = start_tile_x + tx;
+            int tile_y = start_tile_y + ty;
             
-            // Most MBTiles are PNG/JPG, try generic image loader
-            if (!surface) {
-                // For now, skip image loading - would need SDL3_image
-                // Just create a placeholder colored tile
-                surface = SDL_CreateSurface(TILE_SIZE, TILE_SIZE, SDL_PIXELFORMAT_RGB888);
-                if (surface) {
-                    // Fill with a pattern based on tile coords
-                    SDL_FillSurfaceRect(surface, NULL, SDL_MapSurfaceRGB(surface, 100, 120, 140));
+            SDL_Texture *texture = map_viewer_get_tile(viewer, viewer->zoom_level, tile_x, tile_y);
+            if (texture) {
+                SDL_FRect dest = {
+                    origin.x + (float)(tx * TILE_SIZE - (screen_width / 2 - TILE_SIZE / 2)),
+                    origin.y + (float)(ty * TILE_SIZE - (screen_height / 2 - TILE_SIZE / 2)),
+                    TILE_SIZE,
+                    TILE_SIZE
+                };
+                if (angle != 0.0) {
+                    SDL_FPoint center = {pivot.x - dest.x, pivot.y - dest.y};
+                    SDL_RenderTextureRotated(viewer->renderer, texture, NULL, &dest, angle, &center, SDL_FLIP_NONE);
+                } else {
+                    SDL_RenderTexture(viewer->renderer, texture, NULL, &dest);
                 }
             }
-            
-            if (surface) {
-                texture = SDL_CreateTextureFromSurface(viewer->renderer, surface);
-                SDL_DestroySurface(surface);
-            }
-            
-            SDL_CloseIO(io);
         }
     }
+}
+
+static void map_layer_evicted(void *owner, void *item) {
+    (void)item;
+    MapViewer *viewer = owner;
+    viewer->layer = NULL;
+    viewer->layer_handle = -1;
+}
+
+// Recomposite the tile layer if the view changed. Returns false if there
+// is no layer texture, in which case tiles are drawn directly.
+static bool map_viewer_update_layer(MapViewer *viewer, int start_tile_x, int start_tile_y, int tiles_x, int tiles_y,
+                                    int screen_width, int screen_height) {
+    if (viewer->layer && (viewer->layer_w != screen_width || viewer->layer_h != screen_height)) {
+        texture_registry_destroy(viewer->textures, viewer->layer_handle);
+        viewer->layer = NULL;
+        viewer->layer_handle = -1;
+    }
+    bool stale = viewer->layer_dirty || viewer->layer_zoom != viewer->zoom_level;
+    if (!viewer->layer) {
+        viewer->layer_handle = texture_registry_create(viewer->textures, viewer->tile_format, SDL_TEXTUREACCESS_TARGET,
+                                                       screen_width, screen_height, TEXTURE_LAYER, map_layer_evicted,
+                                                       viewer, NULL, &viewer->layer);
+        if (!viewer->layer) return false;
+        viewer->layer_w = screen_width;
+        viewer->layer_h = screen_height;
+        stale = true;
+    }
+    
+    // GPS movement is throttled by the quality profile
+    Uint64 now = SDL_GetTicks();
+    bool moved = viewer->layer_lat != viewer->center_lat || viewer->layer_lon != viewer->center_lon;
+    if (moved && now - viewer->layer_drawn_ms >= viewer->refresh_ms) stale = true;
+    
+    texture_registry_touch(viewer->textures, viewer->layer_handle);
+    if (!stale) return true;
+    
+    viewer->layer_dirty = false;  // Tiles skipped while drawing set it again
+    SDL_Texture *previous = SDL_GetRenderTarget(viewer->renderer);
+    SDL_SetRenderTarget(viewer->renderer, viewer->layer);
+    SDL_SetRenderDrawColor(viewer->renderer, 0, 0, 0, 255);
+    SDL_RenderClear(viewer->renderer);
+    SDL_FPoint origin = {0, 0};
+    map_viewer_draw_tiles(viewer, start_tile_x, start_tile_y, tiles_x, tiles_y, screen_width, screen_height,
+                          origin, 0.0, origin);
+    if (viewer->layer_overlay) {
+        MapView view = {true, viewer->zoom_level,
+                        (double)start_tile_x * TILE_SIZE + (screen_width / 2 - TILE_SIZE / 2),
+                        (double)start_tile_y * TILE_SIZE + (screen_height / 2 - TILE_SIZE / 2),
+                        0.0f, 0.0f, 1.0f, 0.0f};
+        viewer->layer_overlay(viewer->layer_overlay_user, viewer->renderer, &view, screen_width, screen_height);
+    }
+    SDL_SetRenderTarget(viewer->renderer, previous);
     
-    sqlite3_finalize(stmt);
-    return texture;
+    viewer->layer_zoom = viewer->zoom_level;
+    viewer->layer_start_x = start_tile_x;
+    viewer->layer_start_y = start_tile_y;
+    viewer->layer_lat = viewer->center_lat;
+    viewer->layer_lon = viewer->center_lon;
+    viewer->layer_drawn_ms = now;
+    return true;
+}
+
+// Warm at most one tile per frame from the ring around the visible area,
+// and only into free slots so visible tiles are never pushed out
+static void map_viewer_prefetch(MapViewer *viewer, int start_tile_x, int start_tile_y, int tiles_x, int tiles_y) {
+    int radius = viewer->prefetch_radius;
+    if (radius <= 0 || viewer->sources[MAP_SOURCE_BASE].tile_pool.free_count == 0) return;
+    
+    if (viewer->prefetch_x != start_tile_x || viewer->prefetch_y != start_tile_y ||
+        viewer->prefetch_zoom != viewer->zoom_level) {
+        viewer->prefetch_x = start_tile_x;
+        viewer->prefetch_y = start_tile_y;
+        viewer->prefetch_zoom = viewer->zoom_level;
+        viewer->prefetch_cursor = 0;
+    }
+    
+    int span_x = tiles_x + 2 * radius;
+    int span_y = tiles_y + 2 * radius;
+    while (viewer->prefetch_cursor < span_x * span_y) {
+        int i = viewer->prefetch_cursor++;
+        int tx = i % span_x - radius;
+        int ty = i / span_x - radius;
+        if (tx >= 0 && tx < tiles_x && ty >= 0 && ty < tiles_y) continue;
+        
+        int tile_x = start_tile_x + tx;
+        int tile_y = start_tile_y + ty;
+        if (!map_viewer_tile_cached(viewer, viewer->zoom_level, tile_x, tile_y)) {
+            map_viewer_get_tile(viewer, viewer->zoom_level, tile_x, tile_y);
+            return;
+        }
+    }
 }
 
 // Render map view
 void map_viewer_render(MapViewer *viewer, int screen_width, int screen_height) {
-    if (!viewer->active) return;
+    viewer->view.valid = false;
+    if (!viewer->active || !map_viewer_ready(viewer)) return;
+    map_viewer_check_sources(viewer);
     
     // Calculate center tile
     int center_tile_x, center_tile_y;
     latlon_to_tile(viewer->center_lat, viewer->center_lon, viewer->zoom_level, 
                    &center_tile_x, &center_tile_y);
     
-    // Calculate how many tiles we need to cover the screen
-    int tiles_x = (screen_width / TILE_SIZE) + 2;
-    int tiles_y = (screen_height / TILE_SIZE) + 2;
+    // Heading-up covers the rotated screen's bounding box: a square the
+    // size of the diagonal fits every angle, so turning never changes the
+    // tile set and only the final draw is rotated
+    int area_w = screen_width;
+    int area_h = screen_height;
+    double angle = 0.0;
+    if (viewer->heading_up) {
+        area_w = area_h = (int)ceil(sqrt((double)screen_width * screen_width + (double)screen_height * screen_height));
+        angle = -viewer->heading;
+    }
+    
+    // Calculate how many tiles we need to cover the area
+    int tiles_x = (area_w / TILE_SIZE) + 2;
+    int tiles_y = (area_h / TILE_SIZE) + 2;
     
     int start_tile_x = center_tile_x - tiles_x / 2;
     int start_tile_y = center_tile_y - tiles_y / 2;
     
-    // Render tiles
-    for (int ty = 0; ty < tiles_y; ty++) {
-        for (int tx = 0; tx < tiles_x; tx++) {
-            int tile_x = start_tile_x + tx;
-            int tile_y = start_tile_y + ty;
-            
-            SDL_Texture *tile = map_viewer_get_tile(viewer, viewer->zoom_level, tile_x, tile_y);
-            if (tile) {
-                SDL_FRect dest = {
-                    (float)(tx * TILE_SIZE - (screen_width / 2 - TILE_SIZE / 2)),
-                    (float)(ty * TILE_SIZE - (screen_height / 2 - TILE_SIZE / 2)),
-                    TILE_SIZE,
-                    TILE_SIZE
-                };
-                SDL_RenderTexture(viewer->renderer, tile, NULL, &dest);
-                SDL_DestroyTexture(tile);
-            }
+    SDL_FRect dest = {(screen_width - area_w) / 2.0f, (screen_height - area_h) / 2.0f, (float)area_w, (float)area_h};
+    SDL_FPoint pivot = {screen_width / 2.0f, screen_height / 2.0f};
+    int drawn_x = start_tile_x, drawn_y = start_tile_y;
+    if (map_viewer_update_layer(viewer, start_tile_x, start_tile_y, tiles_x, tiles_y, area_w, area_h)) {
+        drawn_x = viewer->layer_start_x;  // A throttled layer may still show an older position
+        drawn_y = viewer->layer_start_y;
+        if (angle != 0.0) {
+            SDL_RenderTextureRotated(viewer->renderer, viewer->layer, NULL, &dest, angle, NULL, SDL_FLIP_NONE);
+        } else {
+            SDL_RenderTexture(viewer->renderer, viewer->layer, NULL, &dest);
         }
+    } else {
+        SDL_FPoint origin = {dest.x, dest.y};
+        map_viewer_draw_tiles(viewer, start_tile_x, start_tile_y, tiles_x, tiles_y, area_w, area_h,
+                              origin, angle, pivot);
+    }
+    map_viewer_prefetch(viewer, start_tile_x, start_tile_y, tiles_x, tiles_y);
+    
+    // Tile (tx, ty) of the area lands at dest + tile * TILE_SIZE - (area / 2 - TILE_SIZE / 2)
+    viewer->view.valid = true;
+    viewer->view.zoom = viewer->zoom_level;
+    viewer->view.world_x = (double)drawn_x * TILE_SIZE + (area_w / 2 - TILE_SIZE / 2) - dest.x;
+    viewer->view.world_y = (double)drawn_y * TILE_SIZE + (area_h / 2 - TILE_SIZE / 2) - dest.y;
+    viewer->view.pivot_x = pivot.x;
+    viewer->view.pivot_y = pivot.y;
+    viewer->view.cos_a = (float)cos(angle * M_PI / 180.0);
+    viewer->view.sin_a = (float)sin(angle * M_PI / 180.0);
+    if (!viewer->layer && viewer->layer_overlay) {
+        viewer->layer_overlay(viewer->layer_overlay_user, viewer->renderer, &viewer->view, screen_width, screen_height);
     }
     
     // Draw crosshair at center (current position)
@@ -155,6 +457,16 @@ void map_viewer_render(MapViewer *viewer, int screen_width, int screen_height) {
     int cy = screen_height / 2;
     SDL_RenderLine(viewer->renderer, (float)(cx - 20), (float)cy, (float)(cx + 20), (float)cy);
     SDL_RenderLine(viewer->renderer, (float)cx, (float)(cy - 20), (float)cx, (float)(cy + 20));
+    
+    // North pointer so a rotated map stays readable
+    if (viewer->heading_up) {
+        double north = angle * M_PI / 180.0;
+        float nx = (float)sin(north), ny = (float)-cos(north);
+        float tip_x = screen_width - 40 + nx * 20, tip_y = 40 + ny * 20;
+        SDL_RenderLine(viewer->renderer, screen_width - 40 - nx * 20, 40 - ny * 20, tip_x, tip_y);
+        SDL_RenderLine(viewer->renderer, tip_x, tip_y, tip_x - nx * 8 - ny * 6, tip_y - ny * 8 + nx * 6);
+        SDL_RenderLine(viewer->renderer, tip_x, tip_y, tip_x - nx * 8 + ny * 6, tip_y - ny * 8 - nx * 6);
+    }
 }
 
 // Update GPS position
@@ -163,6 +475,13 @@ void map_viewer_update_position(MapViewer *viewer, double lat, double lon) {
     viewer->center_lon = lon;
 }
 
+// Jump to a chosen place; redrawn right away rather than at the GPS rate
+void map_viewer_recenter(MapViewer *viewer, double lat, double lon) {
+    viewer->center_lat = lat;
+    viewer->center_lon = lon;
+    viewer->layer_dirty = true;
+}
+
 // Pan map
 void map_viewer_pan(MapViewer *viewer, int dx, int dy) {
     // Convert pixel movement to lat/lon delta
@@ -171,6 +490,7 @@ void map_viewer_pan(MapViewer *viewer, int dx, int dy) {
     
     viewer->center_lon += dx * meters_per_pixel / 111320.0;
     viewer->center_lat -= dy * meters_per_pixel / 110540.0;
+    viewer->layer_dirty = true;
 }
 
 // Zoom in/out
@@ -180,16 +500,185 @@ void map_viewer_zoom(MapViewer *viewer, int delta) {
     if (viewer->zoom_level > 18) viewer->zoom_level = 18;
 }
 
+// Course from GPS; only the final draw uses it
+void map_viewer_set_heading(MapViewer *viewer, float heading) {
+    viewer->heading = heading;
+}
+
+// The layer is resized to the diagonal square once; no tile is reloaded
+void map_viewer_toggle_heading_up(MapViewer *viewer) {
+    viewer->heading_up = !viewer->heading_up;
+}
+
 // Toggle map view
 void map_viewer_toggle(MapViewer *viewer) {
     viewer->active = !viewer->active;
+    viewer->layer_dirty = true;
+}
+
+// Applied by the quality governor
+void map_viewer_set_quality(MapViewer *viewer, uint32_t refresh_ms, int prefetch_radius, uint32_t inset_refresh_ms) {
+    viewer->refresh_ms = refresh_ms;
+    // Tile pools are sized for the widest ring
+    viewer->prefetch_radius = prefetch_radius > MAP_PREFETCH_RADIUS_MAX ? MAP_PREFETCH_RADIUS_MAX : prefetch_radius;
+    viewer->inset.refresh_ms = inset_refresh_ms;
+}
+
+static void map_inset_evicted(void *owner, void *item) {
+    (void)item;
+    MapViewer *viewer = owner;
+    viewer->inset.texture = NULL;
+    viewer->inset.handle = -1;
+    viewer->inset.drawn = false;
+}
+
+// Redraw the inset centred on the rider if it is due: after refresh_ms of
+// movement, or at once when the rider is MAP_INSET_MOVE_PX off centre.
+// Returns true with the inset as render target so overlays can be added
+// through inset.view; map_viewer_inset_end() restores the target.
+bool map_viewer_inset_begin(MapViewer *viewer, double lat, double lon, int size) {
+    MapInset *inset = &viewer->inset;
+    if (!map_viewer_ready(viewer)) return false;
+    map_viewer_check_sources(viewer);
+    
+    if (inset->texture && inset->size != size) {
+        texture_registry_destroy(viewer->textures, inset->handle);
+        inset->texture = NULL;
+        inset->handle = -1;
+        inset->drawn = false;
+    }
+    if (!inset->texture) {
+        inset->handle = texture_registry_create(viewer->textures, viewer->tile_format, SDL_TEXTUREACCESS_TARGET,
+                                                size, size, TEXTURE_LAYER, map_inset_evicted, viewer, NULL,
+                                                &inset->texture);
+        if (!inset->texture) return false;
+        inset->size = size;
+        inset->drawn = false;
+    }
+    texture_registry_touch(viewer->textures, inset->handle);
+    
+    double world_x, world_y;
+    latlon_to_world(lat, lon, MAP_INSET_ZOOM, &world_x, &world_y);
+    Uint64 now = SDL_GetTicks();
+    double moved = hypot(world_x - inset->drawn_x, world_y - inset->drawn_y);
+    bool due = !inset->drawn || moved >= MAP_INSET_MOVE_PX ||
+               (moved >= 0.5 && now - inset->drawn_ms >= inset->refresh_ms);
+    if (!due) return false;
+    
+    inset->previous = SDL_GetRenderTarget(viewer->renderer);
+    SDL_SetRenderTarget(viewer->renderer, inset->texture);
+    SDL_SetRenderDrawColor(viewer->renderer, 0, 0, 0, 255);
+    SDL_RenderClear(viewer->renderer);
+    
+    // Whole pixels, so tiles are never resampled
+    double left = floor(world_x - size / 2.0);
+    double top = floor(world_y - size / 2.0);
+    int tiles = 1 << MAP_INSET_ZOOM;
+    int tx0 = (int)floor(left / TILE_SIZE), tx1 = (int)floor((left + size - 1) / TILE_SIZE);
+    int ty0 = (int)floor(top / TILE_SIZE), ty1 = (int)floor((top + size - 1) / TILE_SIZE);
+    for (int ty = ty0; ty <= ty1; ty++) {
+        if (ty < 0 || ty >= tiles) continue;
+        for (int tx = tx0; tx <= tx1; tx++) {
+            SDL_Texture *texture = map_viewer_get_tile(viewer, MAP_INSET_ZOOM, (tx % tiles + tiles) % tiles, ty);
+            if (!texture) continue;
+            SDL_FRect dest = {(float)(tx * TILE_SIZE - left), (float)(ty * TILE_SIZE - top), TILE_SIZE, TILE_SIZE};
+            SDL_RenderTexture(viewer->renderer, texture, NULL, &dest);
+        }
+    }
+    
+    inset->view.valid = true;
+    inset->view.zoom = MAP_INSET_ZOOM;
+    inset->view.world_x = left;
+    inset->view.world_y = top;
+    inset->view.pivot_x = size / 2.0f;
+    inset->view.pivot_y = size / 2.0f;
+    inset->view.cos_a = 1.0f;
+    inset->view.sin_a = 0.0f;
+    inset->drawn_x = world_x;
+    inset->drawn_y = world_y;
+    inset->drawn_ms = now;
+    inset->drawn = true;
+    return true;
+}
+
+void map_viewer_inset_end(MapViewer *viewer) {
+    SDL_SetRenderTarget(viewer->renderer, viewer->inset.previous);
+    viewer->inset.previous = NULL;
+}
+
+// Composite the cached inset at (x, y). The position marker is placed
+// from the live fix, so it keeps moving between redraws.
+void map_viewer_inset_draw(MapViewer *viewer, double lat, double lon, float x, float y) {
+    MapInset *inset = &viewer->inset;
+    if (!inset->texture || !inset->drawn) return;
+    
+    float size = (float)inset->size;
+    SDL_FRect dest = {x, y, size, size};
+    SDL_RenderTexture(viewer->renderer, inset->texture, NULL, &dest);
+    SDL_SetRenderDrawColor(viewer->renderer, 255, 255, 255, 60);
+    SDL_RenderRect(viewer->renderer, &dest);
+    
+    double world_x, world_y;
+    latlon_to_world(lat, lon, MAP_INSET_ZOOM, &world_x, &world_y);
+    float cx = x + (float)(world_x - inset->view.world_x);
+    float cy = y + (float)(world_y - inset->view.world_y);
+    if (cx < x || cx > x + size || cy < y || cy > y + size) return;
+    SDL_SetRenderDrawColor(viewer->renderer, 255, 0, 0, 255);
+    SDL_RenderLine(viewer->renderer, cx - 6, cy, cx + 6, cy);
+    SDL_RenderLine(viewer->renderer, cx, cy - 6, cx, cy + 6);
+}
+
+// Drawn over the tiles each time the layer is recomposited
+void map_viewer_set_layer_overlay(MapViewer *viewer, MapLayerDrawFn draw, void *user) {
+    viewer->layer_overlay = draw;
+    viewer->layer_overlay_user = user;
+    viewer->layer_dirty = true;
+}
+
+// The overlay changed: recomposite the layer on the next render
+void map_viewer_invalidate_layer(MapViewer *viewer) {
+    viewer->layer_dirty = true;
+}
+
+// A source's tile changed in its database: drop the decoded copy and any
+// composite built from it. Nothing else is redrawn.
+void map_viewer_invalidate_tile(MapViewer *viewer, MapSourceId source, int zoom, int tile_x, int tile_y) {
+    map_source_drop_tile(&viewer->sources[source], viewer->textures, zoom, tile_x, tile_y);
+    MapTile *composite = map_tile_find(&viewer->composite_pool, zoom, tile_x, tile_y);
+    if (composite) {
+        texture_registry_destroy(viewer->textures, composite->handle);
+        composite->texture = NULL;
+        composite->handle = -1;
+        fixed_pool_free(&viewer->composite_pool, composite);
+    }
+    viewer->layer_dirty = true;
+    viewer->inset.drawn = false;
 }
 
 // Cleanup
 void map_viewer_cleanup(MapViewer *viewer) {
-    if (viewer->db) {
-        sqlite3_close(viewer->db);
-        viewer->db = NULL;
+    if (!viewer->textures) return;  // Never initialised, as under --bench
+    SDL_SetAtomicInt(&viewer->stop, 1);
+    if (viewer->open_thread) {
+        SDL_WaitThread(viewer->open_thread, NULL);
+        viewer->open_thread = NULL;
+    }
+    if (viewer->preseed_thread) {
+        SDL_WaitThread(viewer->preseed_thread, NULL);
+        viewer->preseed_thread = NULL;
     }
+    free(viewer->route);
+    viewer->route = NULL;
+    map_viewer_flush_composites(viewer);
+    fixed_pool_destroy(&viewer->composite_pool);
+    texture_registry_destroy(viewer->textures, viewer->layer_handle);
+    viewer->layer = NULL;
+    viewer->layer_handle = -1;
+    texture_registry_destroy(viewer->textures, viewer->inset.handle);
+    viewer->inset.texture = NULL;
+    viewer->inset.handle = -1;
+    for (int s = 0; s < MAP_SOURCE_COUNT; s++) {
+        map_source_close(&viewer->sources[s], viewer->textures);
+    }
+    tile_disk_cache_close(&viewer->disk_cache);
 }
-
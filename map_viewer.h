@@ -9,22 +9,128 @@
 #include <SDL3/SDL.h>
 #include <sqlite3.h>
 #include <stdbool.h>
+#include "frame_memory.h"
+#include "map_source.h"
+#include "texture_registry.h"
+
+#define MAP_TILE_CACHE_BYTES (16 * 1024 * 1024)   // Decoded tiles kept resident (64 at 32 bpp, 128 at 16 bpp)
+#define MAP_VIEW_TILES_SPAN 5         // Tiles across the heading-up square of an 800x480 panel (5 x 3 north-up)
+#define MAP_PREFETCH_RADIUS_MAX 2     // Widest prefetch ring of any quality profile
+#define MAP_VIEW_TILE_SLOTS ((MAP_VIEW_TILES_SPAN + 2 * MAP_PREFETCH_RADIUS_MAX) * \
+                             (MAP_VIEW_TILES_SPAN + 2 * MAP_PREFETCH_RADIUS_MAX))
+// Overlays and composites hold the whole view and prefetch ring
+#define MAP_OVERLAY_CACHE_BYTES (MAP_VIEW_TILE_SLOTS * MAP_TILE_SIZE * MAP_TILE_SIZE * 4)  // Per overlay source, ARGB
+#define MAP_COMPOSITE_SLOTS MAP_VIEW_TILE_SLOTS
+#define MAP_POOL_TEXTURE_BYTES ((MAP_SOURCE_COUNT - 1) * MAP_OVERLAY_CACHE_BYTES + MAP_TILE_CACHE_BYTES + \
+                                MAP_COMPOSITE_SLOTS * MAP_TILE_SIZE * MAP_TILE_SIZE * 4)
+#define MAP_SCREEN_TEXTURE_RESERVE (16 * 1024 * 1024)  // Render target, map layer, inset and glyphs
+
+// Every pool full at once must still leave room for the screen textures
+_Static_assert(MAP_POOL_TEXTURE_BYTES + MAP_SCREEN_TEXTURE_RESERVE <= TEXTURE_BUDGET_DEFAULT_MB * 1024 * 1024,
+               "map tile pools do not fit the default texture budget");
+#define MAP_TRAILS_PATH "trails.mbtiles"
+#define MAP_ANNOTATIONS_PATH "annotations.mbtiles"
+#define MAP_INSET_ZOOM 13
+#define MAP_INSET_MOVE_PX 6.0        // Redraw the inset early once the rider is this far from its centre
+
+// Where the last rendered map sits on screen, for overlays drawn on top
+typedef struct {
+    bool valid;
+    int zoom;
+    double world_x;              // World pixel at this zoom drawn at screen (0, 0) before rotation
+    double world_y;
+    float pivot_x;               // Rotation centre on screen
+    float pivot_y;
+    float cos_a;                 // Screen rotation (identity when north-up)
+    float sin_a;
+} MapView;
+
+// Drawn into the cached tile layer on top of the tiles, so it costs
+// nothing on the frames the layer is reused
+typedef void (*MapLayerDrawFn)(void *user, SDL_Renderer *renderer, const MapView *view, int width, int height);
+
+// Small north-up map for the gauge screen. It is drawn into its own
+// target at a low rate and only composited on the frames in between.
+typedef struct {
+    SDL_Texture *texture;
+    int handle;
+    int size;                    // Square, in layout units
+    uint32_t refresh_ms;         // Redraw at most this often while moving
+    bool drawn;                  // Texture holds a map
+    double drawn_x;              // World pixel at the texture's centre
+    double drawn_y;
+    Uint64 drawn_ms;
+    SDL_Texture *previous;       // Render target to restore after a redraw
+    MapView view;                // Transform of the texture contents
+} MapInset;
 
 typedef struct {
-    sqlite3 *db;
+    MapSource sources[MAP_SOURCE_COUNT];  // Drawn in order, base first
+    SDL_Thread *open_thread;     // Opens and indexes the sources off the main thread
+    SDL_AtomicInt stop;          // Asks the loader and preseed threads to give up early
+    SDL_Thread *preseed_thread;  // Reads the route corridor into each source's pack
+    double *route;               // lat, lon pairs the corridor follows
+    int route_points;
+    double corridor_m;
+    int sources_seen;            // Ready sources as of the last draw, as a bit mask
+    FixedPool composite_pool;    // Tiles where more than one source has something
+    TileDiskCache disk_cache;    // Decoded source tiles from earlier runs
+    FrameArena *arena;           // Decode scratch
+    TextureRegistry *textures;
     SDL_Renderer *renderer;
+    SDL_PixelFormat tile_format; // XRGB8888, or RGB565 for the 16 bpp pipeline
     double center_lat;
     double center_lon;
     int zoom_level;
     bool active;
+    bool heading_up;             // Rotate so the course points up
+    float heading;               // Course in degrees clockwise from north
+    
+    // Tiles composited once and redrawn only when the view changes
+    SDL_Texture *layer;
+    int layer_handle;
+    int layer_w;
+    int layer_h;
+    int layer_zoom;
+    double layer_lat;
+    double layer_lon;
+    int layer_start_x;           // First tile composited into the layer
+    int layer_start_y;
+    Uint64 layer_drawn_ms;
+    bool layer_dirty;            // Pan/zoom redraws right away
+    MapLayerDrawFn layer_overlay;
+    void *layer_overlay_user;
+    uint32_t refresh_ms;         // GPS moves redraw at most this often
+    
+    // Tiles just outside the view, warmed one per frame
+    int prefetch_radius;
+    int prefetch_cursor;
+    int prefetch_x;
+    int prefetch_y;
+    int prefetch_zoom;
+    
+    MapView view;                // Transform used by the last render
+    MapInset inset;
 } MapViewer;
 
-bool map_viewer_init(MapViewer *viewer, const char *mbtiles_path, SDL_Renderer *renderer);
+bool map_viewer_init(MapViewer *viewer, const char *mbtiles_path, SDL_Renderer *renderer, FrameArena *arena,
+                     TextureRegistry *textures, SDL_PixelFormat tile_format);
 void map_viewer_render(MapViewer *viewer, int screen_width, int screen_height);
 void map_viewer_update_position(MapViewer *viewer, double lat, double lon);
+void map_viewer_recenter(MapViewer *viewer, double lat, double lon);
 void map_viewer_pan(MapViewer *viewer, int dx, int dy);
 void map_viewer_zoom(MapViewer *viewer, int delta);
 void map_viewer_toggle(MapViewer *viewer);
+void map_viewer_set_heading(MapViewer *viewer, float heading);
+void map_viewer_toggle_heading_up(MapViewer *viewer);
+void map_viewer_set_quality(MapViewer *viewer, uint32_t refresh_ms, int prefetch_radius, uint32_t inset_refresh_ms);
+bool map_viewer_inset_begin(MapViewer *viewer, double lat, double lon, int size);
+void map_viewer_inset_end(MapViewer *viewer);
+void map_viewer_inset_draw(MapViewer *viewer, double lat, double lon, float x, float y);
+bool map_viewer_preseed(MapViewer *viewer, double *route, int route_points, double corridor_m);
+void map_viewer_set_layer_overlay(MapViewer *viewer, MapLayerDrawFn draw, void *user);
+void map_viewer_invalidate_layer(MapViewer *viewer);
+void map_viewer_invalidate_tile(MapViewer *viewer, MapSourceId source, int zoom, int tile_x, int tile_y);
 void map_viewer_cleanup(MapViewer *viewer);
 
 #endif
@@ -0,0 +1,53 @@
+/*
+ * Snow-Pi Internal Metrics
+ * Author: /x64/dumped
+ * GitHub: @Ma110w
+ */
+
+#include "metrics.h"
+
+DashMetrics dash_metrics;
+
+// Record one finished frame
+void metrics_frame_end(uint32_t frame_us) {
+    static uint64_t draw_calls_at_frame_start = 0;
+
+    dash_metrics.frames++;
+    dash_metrics.frame_time_us = frame_us;
+    dash_metrics.frame_time_sum_us += frame_us;
+    if (frame_us > dash_metrics.frame_time_max_us) dash_metrics.frame_time_max_us = frame_us;
+
+    int bucket = 0;
+    while (frame_us > METRICS_FRAME_BUCKET_US[bucket]) bucket++;
+    dash_metrics.frame_buckets[bucket]++;
+
+    dash_metrics.frame_draw_calls = (uint32_t)(dash_metrics.draw_calls - draw_calls_at_frame_start);
+    draw_calls_at_frame_start = dash_metrics.draw_calls;
+}
+
+// Record one input-to-present latency in its log2 histogram
+void metrics_latency_record(LatencyCategory category, uint64_t latency_us) {
+    int bucket = latency_us > 1 ? 63 - __builtin_clzll(latency_us) : 0;
+    if (bucket >= METRICS_LATENCY_BUCKETS) bucket = METRICS_LATENCY_BUCKETS - 1;
+    dash_metrics.latency_buckets[category][bucket]++;
+    dash_metrics.latency_count[category]++;
+    dash_metrics.latency_sum_us[category] += latency_us;
+    if (latency_us > dash_metrics.latency_max_us[category]) dash_metrics.latency_max_us[category] = (uint32_t)latency_us;
+}
+
+// Upper bound (us) of the bucket holding the given fraction of samples, capped at
+// the largest latency seen; 0 if none
+uint64_t metrics_latency_percentile(LatencyCategory category, double fraction) {
+    uint64_t count = dash_metrics.latency_count[category];
+    if (count == 0) return 0;
+    uint64_t target = (uint64_t)(fraction * count);
+    uint64_t cumulative = 0;
+    for (int b = 0; b < METRICS_LATENCY_BUCKETS - 1; b++) {
+        cumulative += dash_metrics.latency_buckets[category][b];
+        if (cumulative > target) {
+            uint64_t bound = 2ull << b;
+            return bound < dash_metrics.latency_max_us[category] ? bound : dash_metrics.latency_max_us[category];
+        }
+    }
+    return dash_metrics.latency_max_us[category];
+}
@@ -0,0 +1,88 @@
+/*
+ * Snow-Pi Internal Metrics Header
+ * Author: /x64/dumped
+ *
+ * Process-wide counters served by the metrics endpoint. Including this
+ * header counts every SDL render call in that file as a draw call.
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <SDL3/SDL.h>
+#include <stdint.h>
+
+#define METRICS_FRAME_BUCKETS 7
+#define METRICS_TEXTURE_CATEGORIES 4   // Matches TextureCategory
+#define METRICS_LATENCY_BUCKETS 20     // Bucket i counts latencies below 2^(i+1) us; the last is open-ended
+
+// Upper bounds (microseconds) of the frame time histogram buckets; last is +Inf
+static const uint32_t METRICS_FRAME_BUCKET_US[METRICS_FRAME_BUCKETS] = {
+    8000, 16000, 25000, 33000, 50000, 100000, UINT32_MAX
+};
+
+// Where an input came from, for input-to-present latency
+typedef enum {
+    LATENCY_KEY,          // Keyboard event timestamp
+    LATENCY_SENSOR,       // Sensor sample
+    LATENCY_WARNING,      // Sample that raised a warning
+    LATENCY_CATEGORY_COUNT
+} LatencyCategory;
+
+static const char *const LATENCY_CATEGORY_NAMES[LATENCY_CATEGORY_COUNT] = {"key", "sensor", "warning"};
+
+typedef struct {
+    uint64_t frames;
+    uint64_t frame_time_sum_us;
+    uint32_t frame_time_us;        // Last frame (work only, excludes the frame delay)
+    uint32_t frame_time_max_us;
+    uint64_t frame_buckets[METRICS_FRAME_BUCKETS];
+    uint64_t draw_calls;
+    uint32_t frame_draw_calls;     // Draw calls in the last completed frame
+    uint64_t tile_requests;
+    uint64_t tile_cache_hits;
+    uint64_t tile_decodes;
+    uint64_t tile_decode_us;
+    uint64_t tile_pack_hits;       // Tile reads served from the preseeded route pack
+    uint64_t tile_pack_misses;     // Tile reads that went to the database while a pack was loaded
+    uint64_t tile_disk_hits;       // Tiles uploaded from the disk cache without decoding
+    uint32_t frame_build_us;       // Last gauge screen build on the render worker
+    uint32_t frame_build_wait_us;  // Time the main thread last waited for that build
+    uint32_t frame_build_dropped;  // Primitives that build had no room for
+    uint64_t draw_dropped;         // All primitives dropped from shown builds
+    uint64_t sensor_ticks;
+    uint64_t first_frame_us;       // Process start to first presented frame
+    uint64_t texture_bytes[METRICS_TEXTURE_CATEGORIES];
+    uint64_t texture_budget_bytes;
+    uint64_t texture_peak_bytes;
+    uint64_t texture_evictions;
+    uint32_t quality_level;        // QualityLevel, 0 = lowest
+    uint32_t quality_changes;
+    float soc_temp_c;              // Negative when unavailable
+    int32_t cpu_khz;
+    uint64_t latency_buckets[LATENCY_CATEGORY_COUNT][METRICS_LATENCY_BUCKETS];
+    uint64_t latency_count[LATENCY_CATEGORY_COUNT];
+    uint64_t latency_sum_us[LATENCY_CATEGORY_COUNT];
+    uint32_t latency_max_us[LATENCY_CATEGORY_COUNT];
+} DashMetrics;
+
+extern DashMetrics dash_metrics;
+
+void metrics_frame_end(uint32_t frame_us);
+void metrics_latency_record(LatencyCategory category, uint64_t latency_us);
+uint64_t metrics_latency_percentile(LatencyCategory category, double fraction);
+
+// SDL is included above so the wrappers never depend on include order
+#define SDL_RenderPoint(...) (dash_metrics.draw_calls++, SDL_RenderPoint(__VA_ARGS__))
+#define SDL_RenderPoints(...) (dash_metrics.draw_calls++, SDL_RenderPoints(__VA_ARGS__))
+#define SDL_RenderLine(...) (dash_metrics.draw_calls++, SDL_RenderLine(__VA_ARGS__))
+#define SDL_RenderLines(...) (dash_metrics.draw_calls++, SDL_RenderLines(__VA_ARGS__))
+#define SDL_RenderRect(...) (dash_metrics.draw_calls++, SDL_RenderRect(__VA_ARGS__))
+#define SDL_RenderRects(...) (dash_metrics.draw_calls++, SDL_RenderRects(__VA_ARGS__))
+#define SDL_RenderFillRect(...) (dash_metrics.draw_calls++, SDL_RenderFillRect(__VA_ARGS__))
+#define SDL_RenderFillRects(...) (dash_metrics.draw_calls++, SDL_RenderFillRects(__VA_ARGS__))
+#define SDL_RenderTexture(...) (dash_metrics.draw_calls++, SDL_RenderTexture(__VA_ARGS__))
+#define SDL_RenderTextureRotated(...) (dash_metrics.draw_calls++, SDL_RenderTextureRotated(__VA_ARGS__))
+#define SDL_RenderGeometry(...) (dash_metrics.draw_calls++, SDL_RenderGeometry(__VA_ARGS__))
+
+#endif
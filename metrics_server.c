@@ -0,0 +1,388 @@
+/*
+ * Snow-Pi Metrics Server - Local telemetry and metrics endpoint
+ * Author: /x64/dumped
+ * GitHub: @Ma110w
+ *
+ * Non-blocking HTTP/1.0 over a Unix domain socket, polled once per frame
+ * with a zero-timeout epoll_wait. /metrics returns a Prometheus text
+ * snapshot, /stream a binary feed of TelemetrySample records. Slow stream
+ * clients lose samples instead of stalling the frame.
+ */
+
+#define _GNU_SOURCE
+
+#include "metrics_server.h"
+#include "metrics.h"
+#include "texture_registry.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static const char STREAM_RESPONSE[] =
+    "HTTP/1.0 200 OK\r\nContent-Type: application/octet-stream\r\n\r\n";
+static const char NOT_FOUND_RESPONSE[] =
+    "HTTP/1.0 404 Not Found\r\nContent-Length: 0\r\n\r\n";
+
+// Gather write (writev semantics) without raising SIGPIPE on a closed peer
+static ssize_t send_iov(int fd, struct iovec *iov, int count) {
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = count;
+    return sendmsg(fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+}
+
+// Send, keeping whatever the socket did not take in pending, which must
+// be empty. False if the client is gone or the rest does not fit.
+static bool client_send(MetricsClient *client, struct iovec *iov, int count) {
+    ssize_t sent = send_iov(client->fd, iov, count);
+    if (sent < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK) return false;
+        sent = 0;
+    }
+    size_t skip = (size_t)sent;
+    for (int i = 0; i < count; i++) {
+        if (skip >= iov[i].iov_len) {
+            skip -= iov[i].iov_len;
+            continue;
+        }
+        size_t rest = iov[i].iov_len - skip;
+        if (client->pending_len + rest > sizeof(client->pending)) return false;
+        memcpy(client->pending + client->pending_len, (const uint8_t *)iov[i].iov_base + skip, rest);
+        client->pending_len += (int)rest;
+        skip = 0;
+    }
+    return true;
+}
+
+// Send as much of pending as the socket takes. False if the client is gone.
+static bool client_flush(MetricsClient *client) {
+    ssize_t sent = send(client->fd, client->pending, client->pending_len, MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (sent < 0) return errno == EAGAIN || errno == EWOULDBLOCK;
+    memmove(client->pending, client->pending + sent, client->pending_len - sent);
+    client->pending_len -= (int)sent;
+    return true;
+}
+
+static void client_close(MetricsServer *server, MetricsClient *client) {
+    if (client->state == CLIENT_STREAMING) server->streaming_clients--;
+    epoll_ctl(server->epoll_fd, EPOLL_CTL_DEL, client->fd, NULL);
+    close(client->fd);
+    client->fd = -1;
+    client->state = CLIENT_FREE;
+    client->request_len = 0;
+    client->pending_len = 0;
+}
+
+bool metrics_server_start(MetricsServer *server, const char *path) {
+    memset(server, 0, sizeof(*server));
+    server->listen_fd = -1;
+    server->epoll_fd = -1;
+    for (int i = 0; i < METRICS_MAX_CLIENTS; i++) server->clients[i].fd = -1;
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path);
+    unlink(path);  // Stale socket from a previous run
+
+    server->listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (server->listen_fd < 0 ||
+        bind(server->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(server->listen_fd, METRICS_MAX_CLIENTS) != 0) {
+        fprintf(stderr, "Cannot listen on %s: %s\n", path, strerror(errno));
+        metrics_server_stop(server);
+        return false;
+    }
+
+    server->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event ev = {.events = EPOLLIN, .data.u32 = 0};
+    if (server->epoll_fd < 0 || epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, server->listen_fd, &ev) != 0) {
+        fprintf(stderr, "Cannot set up epoll for metrics server\n");
+        metrics_server_stop(server);
+        return false;
+    }
+    return true;
+}
+
+static void text_append(MetricsServer *server, const char *fmt, ...) {
+    int room = (int)sizeof(server->text) - server->text_len;
+    if (room <= 1) return;
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(server->text + server->text_len, room, fmt, args);
+    va_end(args);
+    server->text_len += n < room ? n : room - 1;
+}
+
+static void format_metrics(MetricsServer *server) {
+    const DashMetrics *m = &dash_metrics;
+    server->text_len = 0;
+
+    text_append(server, "# TYPE snowpi_frame_time_seconds histogram\n");
+    uint64_t cumulative = 0;
+    for (int i = 0; i < METRICS_FRAME_BUCKETS; i++) {
+        cumulative += m->frame_buckets[i];
+        if (METRICS_FRAME_BUCKET_US[i] == UINT32_MAX) {
+            text_append(server, "snowpi_frame_time_seconds_bucket{le=\"+Inf\"} %llu\n", (unsigned long long)cumulative);
+        } else {
+            text_append(server, "snowpi_frame_time_seconds_bucket{le=\"%.3f\"} %llu\n",
+                        METRICS_FRAME_BUCKET_US[i] / 1e6, (unsigned long long)cumulative);
+        }
+    }
+    text_append(server, "snowpi_frame_time_seconds_sum %.6f\n", m->frame_time_sum_us / 1e6);
+    text_append(server, "snowpi_frame_time_seconds_count %llu\n", (unsigned long long)m->frames);
+    text_append(server, "# TYPE snowpi_frame_time_last_seconds gauge\nsnowpi_frame_time_last_seconds %.6f\n",
+                m->frame_time_us / 1e6);
+    text_append(server, "# TYPE snowpi_frame_time_max_seconds gauge\nsnowpi_frame_time_max_seconds %.6f\n",
+                m->frame_time_max_us / 1e6);
+    text_append(server, "# TYPE snowpi_input_latency_seconds histogram\n");
+    for (int c = 0; c < LATENCY_CATEGORY_COUNT; c++) {
+        cumulative = 0;
+        for (int b = 0; b < METRICS_LATENCY_BUCKETS; b++) {
+            cumulative += m->latency_buckets[c][b];
+            if (b == METRICS_LATENCY_BUCKETS - 1) {
+                text_append(server, "snowpi_input_latency_seconds_bucket{category=\"%s\",le=\"+Inf\"} %llu\n",
+                            LATENCY_CATEGORY_NAMES[c], (unsigned long long)cumulative);
+            } else {
+                text_append(server, "snowpi_input_latency_seconds_bucket{category=\"%s\",le=\"%.6f\"} %llu\n",
+                            LATENCY_CATEGORY_NAMES[c], (2ull << b) / 1e6, (unsigned long long)cumulative);
+            }
+        }
+        text_append(server, "snowpi_input_latency_seconds_sum{category=\"%s\"} %.6f\n", LATENCY_CATEGORY_NAMES[c],
+                    m->latency_sum_us[c] / 1e6);
+        text_append(server, "snowpi_input_latency_seconds_count{category=\"%s\"} %llu\n", LATENCY_CATEGORY_NAMES[c],
+                    (unsigned long long)m->latency_count[c]);
+    }
+    text_append(server, "# TYPE snowpi_draw_calls_total counter\nsnowpi_draw_calls_total %llu\n",
+                (unsigned long long)m->draw_calls);
+    text_append(server, "# TYPE snowpi_frame_draw_calls gauge\nsnowpi_frame_draw_calls %u\n", m->frame_draw_calls);
+    text_append(server, "# TYPE snowpi_tile_requests_total counter\nsnowpi_tile_requests_total %llu\n",
+                (unsigned long long)m->tile_requests);
+    text_append(server, "# TYPE snowpi_tile_cache_hits_total counter\nsnowpi_tile_cache_hits_total %llu\n",
+                (unsigned long long)m->tile_cache_hits);
+    text_append(server, "# TYPE snowpi_tile_decodes_total counter\nsnowpi_tile_decodes_total %llu\n",
+                (unsigned long long)m->tile_decodes);
+    text_append(server, "# TYPE snowpi_tile_decode_seconds_total counter\nsnowpi_tile_decode_seconds_total %.6f\n",
+                m->tile_decode_us / 1e6);
+    text_append(server, "# TYPE snowpi_tile_pack_hits_total counter\nsnowpi_tile_pack_hits_total %llu\n",
+                (unsigned long long)m->tile_pack_hits);
+    text_append(server, "# TYPE snowpi_tile_pack_misses_total counter\nsnowpi_tile_pack_misses_total %llu\n",
+                (unsigned long long)m->tile_pack_misses);
+    text_append(server, "# TYPE snowpi_tile_disk_hits_total counter\nsnowpi_tile_disk_hits_total %llu\n",
+                (unsigned long long)m->tile_disk_hits);
+    text_append(server, "# TYPE snowpi_frame_build_seconds gauge\nsnowpi_frame_build_seconds %.6f\n",
+                m->frame_build_us / 1e6);
+    text_append(server, "# TYPE snowpi_frame_build_wait_seconds gauge\nsnowpi_frame_build_wait_seconds %.6f\n",
+                m->frame_build_wait_us / 1e6);
+    text_append(server, "# TYPE snowpi_frame_build_dropped gauge\nsnowpi_frame_build_dropped %u\n",
+                m->frame_build_dropped);
+    text_append(server, "# TYPE snowpi_draw_dropped_total counter\nsnowpi_draw_dropped_total %llu\n",
+                (unsigned long long)m->draw_dropped);
+    text_append(server, "# TYPE snowpi_sensor_ticks_total counter\nsnowpi_sensor_ticks_total %llu\n",
+                (unsigned long long)m->sensor_ticks);
+    text_append(server, "# TYPE snowpi_first_frame_seconds gauge\nsnowpi_first_frame_seconds %.6f\n",
+                m->first_frame_us / 1e6);
+    text_append(server, "# TYPE snowpi_texture_bytes gauge\n");
+    for (int c = 0; c < TEXTURE_CATEGORY_COUNT; c++) {
+        text_append(server, "snowpi_texture_bytes{category=\"%s\"} %llu\n", TEXTURE_CATEGORY_NAMES[c],
+                    (unsigned long long)m->texture_bytes[c]);
+    }
+    text_append(server, "# TYPE snowpi_texture_budget_bytes gauge\nsnowpi_texture_budget_bytes %llu\n",
+                (unsigned long long)m->texture_budget_bytes);
+    text_append(server, "# TYPE snowpi_texture_peak_bytes gauge\nsnowpi_texture_peak_bytes %llu\n",
+                (unsigned long long)m->texture_peak_bytes);
+    text_append(server, "# TYPE snowpi_texture_evictions_total counter\nsnowpi_texture_evictions_total %llu\n",
+                (unsigned long long)m->texture_evictions);
+    text_append(server, "# TYPE snowpi_quality_level gauge\nsnowpi_quality_level %u\n", m->quality_level);
+    text_append(server, "# TYPE snowpi_quality_changes_total counter\nsnowpi_quality_changes_total %u\n",
+                m->quality_changes);
+    if (m->soc_temp_c >= 0.0f) {
+        text_append(server, "# TYPE snowpi_soc_temperature_celsius gauge\nsnowpi_soc_temperature_celsius %.1f\n",
+                    m->soc_temp_c);
+    }
+    if (m->cpu_khz > 0) {
+        text_append(server, "# TYPE snowpi_cpu_frequency_hertz gauge\nsnowpi_cpu_frequency_hertz %lld\n",
+                    (long long)m->cpu_khz * 1000);
+    }
+    text_append(server, "# TYPE snowpi_stream_clients gauge\nsnowpi_stream_clients %d\n", server->streaming_clients);
+    text_append(server, "# TYPE snowpi_stream_dropped_total counter\nsnowpi_stream_dropped_total %llu\n",
+                (unsigned long long)server->samples_dropped);
+}
+
+// Send a whole response, then close. Whatever does not go out now is
+// finished from poll when the socket can take more.
+static void client_reply(MetricsServer *server, MetricsClient *client, struct iovec *iov, int count) {
+    if (!client_send(client, iov, count) || client->pending_len == 0) {
+        client_close(server, client);
+        return;
+    }
+    client->state = CLIENT_REPLYING;
+    struct epoll_event ev = {.events = EPOLLOUT | EPOLLRDHUP, .data.u32 = (uint32_t)(client - server->clients) + 1};
+    epoll_ctl(server->epoll_fd, EPOLL_CTL_MOD, client->fd, &ev);
+}
+
+// Answer a complete request line; metrics text is formatted at most once per poll
+static void handle_request(MetricsServer *server, MetricsClient *client, bool *formatted) {
+    if (strncmp(client->request, "GET /metrics", 12) == 0) {
+        if (!*formatted) {
+            format_metrics(server);
+            *formatted = true;
+        }
+        char header[128];
+        int header_len = snprintf(header, sizeof(header),
+                                  "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"
+                                  "Content-Length: %d\r\n\r\n", server->text_len);
+        struct iovec iov[2] = {{header, (size_t)header_len}, {server->text, (size_t)server->text_len}};
+        client_reply(server, client, iov, 2);
+    } else if (strncmp(client->request, "GET /stream", 11) == 0) {
+        // An unsent part of the header goes out before the first record
+        struct iovec iov = {(void *)STREAM_RESPONSE, sizeof(STREAM_RESPONSE) - 1};
+        if (!client_send(client, &iov, 1)) {
+            client_close(server, client);
+            return;
+        }
+        client->state = CLIENT_STREAMING;
+        server->streaming_clients++;
+    } else {
+        struct iovec iov = {(void *)NOT_FOUND_RESPONSE, sizeof(NOT_FOUND_RESPONSE) - 1};
+        client_reply(server, client, &iov, 1);
+    }
+}
+
+static void accept_clients(MetricsServer *server) {
+    int fd;
+    while ((fd = accept4(server->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+        int slot = -1;
+        for (int i = 0; i < METRICS_MAX_CLIENTS && slot < 0; i++) {
+            if (server->clients[i].state == CLIENT_FREE) slot = i;
+        }
+        if (slot < 0) {
+            close(fd);
+            continue;
+        }
+
+        MetricsClient *client = &server->clients[slot];
+        client->fd = fd;
+        client->state = CLIENT_READING;
+        client->request_len = 0;
+        client->pending_len = 0;
+        struct epoll_event ev = {.events = EPOLLIN | EPOLLRDHUP, .data.u32 = (uint32_t)slot + 1};
+        epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+    }
+}
+
+// Accept and answer whatever is ready; never blocks
+void metrics_server_poll(MetricsServer *server) {
+    if (server->epoll_fd < 0) return;
+
+    struct epoll_event events[METRICS_MAX_CLIENTS + 1];
+    int n = epoll_wait(server->epoll_fd, events, METRICS_MAX_CLIENTS + 1, 0);
+    bool formatted = false;
+
+    for (int e = 0; e < n; e++) {
+        if (events[e].data.u32 == 0) {
+            accept_clients(server);
+            continue;
+        }
+
+        MetricsClient *client = &server->clients[events[e].data.u32 - 1];
+        if (client->state == CLIENT_FREE) continue;
+
+        if (client->state == CLIENT_READING) {
+            int room = (int)sizeof(client->request) - 1 - client->request_len;
+            ssize_t got = read(client->fd, client->request + client->request_len, room);
+            if (got <= 0) {
+                client_close(server, client);
+                continue;
+            }
+            client->request_len += (int)got;
+            client->request[client->request_len] = '\0';
+            if (strchr(client->request, '\n') || client->request_len == (int)sizeof(client->request) - 1) {
+                handle_request(server, client, &formatted);
+            }
+        } else if (events[e].events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+            client_close(server, client);
+        } else if (client->state == CLIENT_REPLYING) {
+            if (!client_flush(client) || client->pending_len == 0) client_close(server, client);
+        } else {
+            char discard[64];
+            if (read(client->fd, discard, sizeof(discard)) == 0) client_close(server, client);
+        }
+    }
+}
+
+// Send one sample to every streaming client without blocking
+void metrics_server_stream(MetricsServer *server, const TelemetrySample *sample) {
+    if (server->streaming_clients == 0) return;
+
+    MetricsStreamHeader header = {METRICS_STREAM_MAGIC, TELEMETRY_VERSION, sizeof(TelemetrySample)};
+    size_t total = sizeof(header) + sizeof(*sample);
+
+    for (int i = 0; i < METRICS_MAX_CLIENTS; i++) {
+        MetricsClient *client = &server->clients[i];
+        if (client->state != CLIENT_STREAMING) continue;
+
+        // Finish the previous record first so the stream stays aligned
+        if (client->pending_len > 0) {
+            if (!client_flush(client)) {
+                client_close(server, client);
+                continue;
+            }
+            if (client->pending_len > 0) {
+                server->samples_dropped++;
+                continue;
+            }
+        }
+
+        struct iovec iov[2] = {{&header, sizeof(header)}, {(void *)sample, sizeof(*sample)}};
+        ssize_t sent = send_iov(client->fd, iov, 2);
+        if (sent < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                server->samples_dropped++;
+            } else {
+                client_close(server, client);
+            }
+        } else if ((size_t)sent < total) {
+            // Keep the unsent tail of this record
+            uint8_t record[sizeof(MetricsStreamHeader) + sizeof(TelemetrySample)];
+            memcpy(record, &header, sizeof(header));
+            memcpy(record + sizeof(header), sample, sizeof(*sample));
+            client->pending_len = (int)(total - sent);
+            memcpy(client->pending, record + sent, client->pending_len);
+        }
+    }
+}
+
+void metrics_server_stop(MetricsServer *server) {
+    for (int i = 0; i < METRICS_MAX_CLIENTS; i++) {
+        if (server->clients[i].state != CLIENT_FREE) client_close(server, &server->clients[i]);
+    }
+    if (server->epoll_fd >= 0) close(server->epoll_fd);
+    if (server->listen_fd >= 0) close(server->listen_fd);
+    server->epoll_fd = -1;
+    server->listen_fd = -1;
+}
+
+#else
+
+// Unix domain sockets and epoll are Linux-only; the endpoint is disabled on Windows
+bool metrics_server_start(MetricsServer *server, const char *path) {
+    (void)path;
+    memset(server, 0, sizeof(*server));
+    server->listen_fd = server->epoll_fd = -1;
+    return false;
+}
+void metrics_server_poll(MetricsServer *server) { (void)server; }
+void metrics_server_stream(MetricsServer *server, const TelemetrySample *sample) { (void)server; (void)sample; }
+void metrics_server_stop(MetricsServer *server) { (void)server; }
+
+#endif
@@ -0,0 +1,62 @@
+/*
+ * Snow-Pi Metrics Server Header
+ * Author: /x64/dumped
+ *
+ * Local-only endpoint on a Unix domain socket, e.g.:
+ *     curl --unix-socket /tmp/snow-pi.sock http://dash/metrics
+ *     curl --unix-socket /tmp/snow-pi.sock http://dash/stream --output samples.bin
+ */
+
+#ifndef METRICS_SERVER_H
+#define METRICS_SERVER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "telemetry_shm.h"
+
+#define METRICS_SOCKET_PATH "/tmp/snow-pi.sock"
+#define METRICS_MAX_CLIENTS 8
+#define METRICS_STREAM_MAGIC 0x53495053u  // "SPIS"
+#define METRICS_TEXT_BYTES 16384
+#define METRICS_PENDING_BYTES (METRICS_TEXT_BYTES + 256)  // A whole /metrics reply with its header
+
+// Prefix of every record on /stream, followed by one TelemetrySample
+typedef struct {
+    uint32_t magic;
+    uint16_t version;      // TELEMETRY_VERSION
+    uint16_t size;         // sizeof(TelemetrySample)
+} MetricsStreamHeader;
+
+typedef enum {
+    CLIENT_FREE,
+    CLIENT_READING,        // Waiting for the request line
+    CLIENT_REPLYING,       // Draining the rest of a reply, closed once it is sent
+    CLIENT_STREAMING       // Receiving the sample feed
+} MetricsClientState;
+
+typedef struct {
+    int fd;
+    MetricsClientState state;
+    char request[256];
+    int request_len;
+    // Unsent tail of a reply or of a partially written record
+    uint8_t pending[METRICS_PENDING_BYTES];
+    int pending_len;
+} MetricsClient;
+
+typedef struct {
+    int listen_fd;
+    int epoll_fd;
+    MetricsClient clients[METRICS_MAX_CLIENTS];
+    int streaming_clients;
+    uint64_t samples_dropped;
+    char text[METRICS_TEXT_BYTES];  // Metrics snapshot, formatted once per poll
+    int text_len;
+} MetricsServer;
+
+bool metrics_server_start(MetricsServer *server, const char *path);
+void metrics_server_poll(MetricsServer *server);
+void metrics_server_stream(MetricsServer *server, const TelemetrySample *sample);
+void metrics_server_stop(MetricsServer *server);
+
+#endif
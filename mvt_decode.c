@@ -0,0 +1,347 @@
+/*
+ * Snow-Pi Vector Tile Decoder - Mapbox Vector Tiles (protobuf + zlib)
+ * Author: /x64/dumped
+ * GitHub: @Ma110w
+ *
+ * Minimal MVT 2.x reader for the offline index builders and vector
+ * overlay tiles. Tiles are inflated with zlib, walked with a small
+ * protobuf reader and handed to a callback one feature at a time with
+ * geometry already decoded into tile coordinates.
+ */
+
+#include "mvt_decode.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Protobuf wire types
+#define WIRE_VARINT 0
+#define WIRE_64BIT 1
+#define WIRE_BYTES 2
+#define WIRE_32BIT 5
+
+typedef struct {
+    const uint8_t *p;
+    const uint8_t *end;
+    bool error;
+} PbReader;
+
+static uint64_t pb_varint(PbReader *r) {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (r->p >= r->end) break;
+        uint8_t b = *r->p++;
+        value |= (uint64_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) return value;
+    }
+    r->error = true;
+    return 0;
+}
+
+static MvtBytes pb_bytes(PbReader *r) {
+    uint64_t len = pb_varint(r);
+    MvtBytes bytes = {r->p, 0};
+    if (r->error || len > (uint64_t)(r->end - r->p)) {
+        r->error = true;
+        return bytes;
+    }
+    bytes.len = (size_t)len;
+    r->p += len;
+    return bytes;
+}
+
+static void pb_skip(PbReader *r, int wire) {
+    switch (wire) {
+        case WIRE_VARINT: pb_varint(r); break;
+        case WIRE_64BIT: r->p += 8; break;
+        case WIRE_BYTES: pb_bytes(r); break;
+        case WIRE_32BIT: r->p += 4; break;
+        default: r->error = true; break;
+    }
+    if (r->p > r->end) r->error = true;
+}
+
+static bool pb_next(PbReader *r, int *field, int *wire) {
+    if (r->error || r->p >= r->end) return false;
+    uint64_t key = pb_varint(r);
+    *field = (int)(key >> 3);
+    *wire = (int)(key & 7);
+    return !r->error;
+}
+
+static int32_t zigzag(uint32_t v) {
+    return (int32_t)((v >> 1) ^ (~(v & 1) + 1));
+}
+
+// Growable scratch reused across layers and features
+typedef struct {
+    MvtBytes *keys;
+    MvtValue *values;
+    int key_cap, value_cap;
+    uint32_t *ints;
+    int int_cap;
+    MvtPoint *points;
+    int point_cap;
+    int *parts;
+    int part_cap;
+} Scratch;
+
+static bool grow(void **array, int *cap, int needed, size_t elem) {
+    if (needed <= *cap) return true;
+    int new_cap = *cap ? *cap : 64;
+    while (new_cap < needed) new_cap *= 2;
+    void *p = realloc(*array, (size_t)new_cap * elem);
+    if (!p) return false;
+    *array = p;
+    *cap = new_cap;
+    return true;
+}
+
+// Gzip- or zlib-wrapped tiles are inflated; plain ones are copied
+bool mvt_inflate(const void *blob, size_t size, uint8_t **out, size_t *out_len) {
+    const uint8_t *in = blob;
+    bool compressed = size >= 2 && ((in[0] == 0x1F && in[1] == 0x8B) || (in[0] == 0x78));
+    if (!compressed) {
+        *out = malloc(size ? size : 1);
+        if (!*out) return false;
+        memcpy(*out, blob, size);
+        *out_len = size;
+        return true;
+    }
+
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    if (inflateInit2(&zs, 15 + 32) != Z_OK) return false;  // Auto-detect gzip/zlib header
+    size_t cap = size * 4 + 1024;
+    uint8_t *buf = malloc(cap);
+    zs.next_in = (Bytef *)in;
+    zs.avail_in = (uInt)size;
+    int rc = Z_OK;
+    while (buf && rc == Z_OK) {
+        if (zs.total_out == cap) {
+            uint8_t *bigger = realloc(buf, cap * 2);
+            if (!bigger) {
+                free(buf);
+                buf = NULL;
+                break;
+            }
+            buf = bigger;
+            cap *= 2;
+        }
+        zs.next_out = buf + zs.total_out;
+        zs.avail_out = (uInt)(cap - zs.total_out);
+        rc = inflate(&zs, Z_NO_FLUSH);
+    }
+    inflateEnd(&zs);
+    if (!buf || rc != Z_STREAM_END) {
+        free(buf);
+        return false;
+    }
+    *out = buf;
+    *out_len = zs.total_out;
+    return true;
+}
+
+static MvtValue decode_value(MvtBytes msg) {
+    MvtValue value = {0};
+    PbReader r = {msg.data, msg.data + msg.len, false};
+    int field, wire;
+    while (pb_next(&r, &field, &wire)) {
+        if (field == 1 && wire == WIRE_BYTES) {
+            value.is_string = true;
+            value.str = pb_bytes(&r);
+        } else if (field == 2 && wire == WIRE_32BIT && r.end - r.p >= 4) {
+            float f;
+            memcpy(&f, r.p, 4);
+            r.p += 4;
+            value.number = f;
+        } else if (field == 3 && wire == WIRE_64BIT && r.end - r.p >= 8) {
+            memcpy(&value.number, r.p, 8);
+            r.p += 8;
+        } else if ((field == 4 || field == 5 || field == 7) && wire == WIRE_VARINT) {
+            value.number = (double)(int64_t)pb_varint(&r);
+        } else if (field == 6 && wire == WIRE_VARINT) {
+            uint64_t v = pb_varint(&r);
+            value.number = (double)(int64_t)((v >> 1) ^ (~(v & 1) + 1));
+        } else {
+            pb_skip(&r, wire);
+        }
+    }
+    return value;
+}
+
+// Read a packed uint32 field into scratch->ints
+static int decode_packed(Scratch *s, MvtBytes packed) {
+    PbReader r = {packed.data, packed.data + packed.len, false};
+    int n = 0;
+    while (r.p < r.end && !r.error) {
+        if (!grow((void **)&s->ints, &s->int_cap, n + 1, sizeof(uint32_t))) return -1;
+        s->ints[n++] = (uint32_t)pb_varint(&r);
+    }
+    return r.error ? -1 : n;
+}
+
+// Expand MoveTo/LineTo/ClosePath commands into points and parts
+static bool decode_geometry(Scratch *s, const uint32_t *cmds, int count, MvtFeature *feature) {
+    int32_t x = 0, y = 0;
+    int points = 0, parts = 0;
+    for (int i = 0; i < count;) {
+        uint32_t id = cmds[i] & 7;
+        uint32_t repeat = cmds[i] >> 3;
+        i++;
+        if (id == 7) {  // ClosePath: repeat the ring's first point
+            if (parts > 0 && points > s->parts[parts - 1]) {
+                if (!grow((void **)&s->points, &s->point_cap, points + 1, sizeof(MvtPoint))) return false;
+                s->points[points] = s->points[s->parts[parts - 1]];
+                points++;
+            }
+            continue;
+        }
+        if (id != 1 && id != 2) return false;
+        if ((uint64_t)i + 2ull * repeat > (uint64_t)count) return false;
+        for (uint32_t k = 0; k < repeat; k++) {
+            x += zigzag(cmds[i++]);
+            y += zigzag(cmds[i++]);
+            if (id == 1) {  // MoveTo starts a new part
+                if (!grow((void **)&s->parts, &s->part_cap, parts + 2, sizeof(int))) return false;
+                s->parts[parts++] = points;
+            }
+            if (!grow((void **)&s->points, &s->point_cap, points + 1, sizeof(MvtPoint))) return false;
+            s->points[points].x = x;
+            s->points[points].y = y;
+            points++;
+        }
+    }
+    if (!grow((void **)&s->parts, &s->part_cap, parts + 1, sizeof(int))) return false;
+    s->parts[parts] = points;
+    feature->points = s->points;
+    feature->point_count = points;
+    feature->part_start = s->parts;
+    feature->part_count = parts;
+    return true;
+}
+
+static bool decode_layer(Scratch *s, MvtBytes msg, MvtFeatureFn fn, void *user) {
+    MvtLayer layer = {0};
+    layer.extent = 4096;
+
+    // Keys and values usually follow the features, so collect them first
+    PbReader r = {msg.data, msg.data + msg.len, false};
+    int field, wire;
+    while (pb_next(&r, &field, &wire)) {
+        if (field == 1 && wire == WIRE_BYTES) {
+            layer.name = pb_bytes(&r);
+        } else if (field == 3 && wire == WIRE_BYTES) {
+            if (!grow((void **)&s->keys, &s->key_cap, layer.key_count + 1, sizeof(MvtBytes))) return false;
+            s->keys[layer.key_count++] = pb_bytes(&r);
+        } else if (field == 4 && wire == WIRE_BYTES) {
+            if (!grow((void **)&s->values, &s->value_cap, layer.value_count + 1, sizeof(MvtValue))) return false;
+            s->values[layer.value_count++] = decode_value(pb_bytes(&r));
+        } else if (field == 5 && wire == WIRE_VARINT) {
+            layer.extent = (uint32_t)pb_varint(&r);
+        } else {
+            pb_skip(&r, wire);
+        }
+    }
+    if (r.error) return false;
+    layer.keys = s->keys;
+    layer.values = s->values;
+
+    // Tags and geometry share the ints scratch, so tags are copied aside
+    uint32_t *tags = NULL;
+    int tag_cap = 0;
+    bool ok = true;
+    r = (PbReader){msg.data, msg.data + msg.len, false};
+    while (ok && pb_next(&r, &field, &wire)) {
+        if (field != 2 || wire != WIRE_BYTES) {
+            pb_skip(&r, wire);
+            continue;
+        }
+        MvtBytes feature_msg = pb_bytes(&r);
+        PbReader fr = {feature_msg.data, feature_msg.data + feature_msg.len, false};
+        MvtFeature feature = {0};
+        MvtBytes geometry = {NULL, 0};
+        int tag_ints = 0;
+        int ffield, fwire;
+        while (ok && pb_next(&fr, &ffield, &fwire)) {
+            if (ffield == 2 && fwire == WIRE_BYTES) {
+                int n = decode_packed(s, pb_bytes(&fr));
+                ok = n >= 0 && grow((void **)&tags, &tag_cap, n + 1, sizeof(uint32_t));
+                if (ok) {
+                    memcpy(tags, s->ints, (size_t)n * sizeof(uint32_t));
+                    tag_ints = n;
+                }
+            } else if (ffield == 3 && fwire == WIRE_VARINT) {
+                feature.type = (MvtGeomType)pb_varint(&fr);
+            } else if (ffield == 4 && fwire == WIRE_BYTES) {
+                geometry = pb_bytes(&fr);
+            } else {
+                pb_skip(&fr, fwire);
+            }
+        }
+        if (!ok || fr.error) break;
+
+        int n = decode_packed(s, geometry);
+        if (n < 0 || !decode_geometry(s, s->ints, n, &feature)) continue;  // Skip malformed geometry
+        feature.tags = tags;
+        feature.tag_count = tag_ints / 2;
+        fn(user, &layer, &feature);
+    }
+    free(tags);
+    return ok && !r.error;
+}
+
+// Decode an inflated tile, calling fn for every feature of every layer
+bool mvt_decode(const uint8_t *tile, size_t len, MvtFeatureFn fn, void *user) {
+    Scratch s;
+    memset(&s, 0, sizeof(s));
+    PbReader r = {tile, tile + len, false};
+    bool ok = true;
+    int field, wire;
+    while (ok && pb_next(&r, &field, &wire)) {
+        if (field == 3 && wire == WIRE_BYTES) {
+            ok = decode_layer(&s, pb_bytes(&r), fn, user);
+        } else {
+            pb_skip(&r, wire);
+        }
+    }
+    free(s.keys);
+    free(s.values);
+    free(s.ints);
+    free(s.points);
+    free(s.parts);
+    return ok && !r.error;
+}
+
+bool mvt_bytes_equal(MvtBytes bytes, const char *str) {
+    size_t len = strlen(str);
+    return bytes.len == len && memcmp(bytes.data, str, len) == 0;
+}
+
+// Look up one tag of a feature by key
+bool mvt_feature_tag(const MvtLayer *layer, const MvtFeature *feature, const char *key, MvtValue *out) {
+    for (int i = 0; i < feature->tag_count; i++) {
+        uint32_t k = feature->tags[i * 2];
+        uint32_t v = feature->tags[i * 2 + 1];
+        if (k < (uint32_t)layer->key_count && v < (uint32_t)layer->value_count && mvt_bytes_equal(layer->keys[k], key)) {
+            *out = layer->values[v];
+            return true;
+        }
+    }
+    return false;
+}
+
+// Tile-local coordinates to WGS84 (XYZ tile numbering, y down)
+void mvt_tile_to_latlon(int zoom, int tile_x, int tile_y, uint32_t extent, double px, double py,
+                        double *lat, double *lon) {
+    double n = (double)(1 << zoom);
+    double fx = (tile_x + px / extent) / n;
+    double fy = (tile_y + py / extent) / n;
+    *lon = fx * 360.0 - 180.0;
+    *lat = atan(sinh(M_PI * (1.0 - 2.0 * fy))) * 180.0 / M_PI;
+}
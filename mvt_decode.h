@@ -0,0 +1,67 @@
+/*
+ * Snow-Pi Vector Tile Decoder Header
+ * Author: /x64/dumped
+ */
+
+#ifndef MVT_DECODE_H
+#define MVT_DECODE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Raw bytes inside the tile buffer; not NUL-terminated
+typedef struct {
+    const uint8_t *data;
+    size_t len;
+} MvtBytes;
+
+typedef struct {
+    bool is_string;
+    MvtBytes str;
+    double number;          // Numeric and bool values
+} MvtValue;
+
+typedef struct {
+    MvtBytes name;
+    uint32_t extent;        // Tile coordinate range, usually 4096
+    int key_count;
+    int value_count;
+    MvtBytes *keys;
+    MvtValue *values;
+} MvtLayer;
+
+typedef enum {
+    MVT_UNKNOWN = 0,
+    MVT_POINT = 1,
+    MVT_LINESTRING = 2,
+    MVT_POLYGON = 3
+} MvtGeomType;
+
+typedef struct {
+    int32_t x;
+    int32_t y;
+} MvtPoint;
+
+// One decoded feature. Points are in tile coordinates; parts are the
+// line strings, polygon rings or multipoint members.
+typedef struct {
+    MvtGeomType type;
+    const uint32_t *tags;   // Key/value index pairs into the layer
+    int tag_count;          // Number of pairs
+    const MvtPoint *points;
+    int point_count;
+    const int *part_start;  // part_count + 1 offsets into points
+    int part_count;
+} MvtFeature;
+
+typedef void (*MvtFeatureFn)(void *user, const MvtLayer *layer, const MvtFeature *feature);
+
+bool mvt_inflate(const void *blob, size_t size, uint8_t **out, size_t *out_len);
+bool mvt_decode(const uint8_t *tile, size_t len, MvtFeatureFn fn, void *user);
+bool mvt_feature_tag(const MvtLayer *layer, const MvtFeature *feature, const char *key, MvtValue *out);
+bool mvt_bytes_equal(MvtBytes bytes, const char *str);
+void mvt_tile_to_latlon(int zoom, int tile_x, int tile_y, uint32_t extent, double px, double py,
+                        double *lat, double *lon);
+
+#endif
@@ -0,0 +1,208 @@
+/*
+ * Snow-Pi Odometer Store - Crash-safe counters
+ * Author: /x64/dumped
+ * GitHub: @Ma110w
+ *
+ * Keeps odometer, trips, engine hours and the last position in two
+ * checksummed record slots.
+ * Each save overwrites the older slot, so a brownout mid-write can only
+ * damage one copy and the other still holds the last good value.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "odometer_store.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <stddef.h>
+#include <fcntl.h>
+
+#ifdef _WIN32
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <unistd.h>
+#endif
+
+#define ODOMETER_MAGIC 0x444F5053u  // "SPOD"
+#define ODOMETER_VERSION 2            // 2 added the position; version 1 records still load
+#define ODOMETER_V1_CRC_OFFSET 60     // Version 1 ended at reserved[3] + crc
+// One record per 512-byte sector so a torn write never spans both slots
+#define ODOMETER_SLOT_SIZE 512
+#define ODOMETER_SLOT_COUNT 2
+
+// Write coalescing policy (limits SD card wear)
+#define ODOMETER_SAVE_DISTANCE 0.25    // Miles travelled before a save is due
+#define ODOMETER_SAVE_MIN_MS 30000     // Never save more often than this while moving
+#define ODOMETER_SAVE_IDLE_MS 300000   // Save engine hours at least this often
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t length;
+    uint32_t sequence;
+    uint32_t reserved0;
+    double odometer;
+    double trip_a;
+    double trip_b;
+    double engine_hours;
+    double latitude;
+    double longitude;
+    uint32_t reserved[3];
+    uint32_t crc;
+} OdometerRecord;
+
+// CRC-32 (IEEE), bitwise - records are tiny so no table is needed
+static uint32_t crc32_compute(const void *data, size_t len) {
+    const uint8_t *p = data;
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= p[i];
+        for (int b = 0; b < 8; b++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+}
+
+static bool record_valid(OdometerRecord *rec) {
+    if (rec->magic != ODOMETER_MAGIC) return false;
+    if (rec->version == 1 && rec->length == ODOMETER_V1_CRC_OFFSET + sizeof(uint32_t)) {
+        // Counters sit at the same offsets; there is no position yet
+        uint32_t crc;
+        memcpy(&crc, (const uint8_t *)rec + ODOMETER_V1_CRC_OFFSET, sizeof(crc));
+        if (crc != crc32_compute(rec, ODOMETER_V1_CRC_OFFSET)) return false;
+        rec->latitude = NAN;
+        rec->longitude = NAN;
+        return true;
+    }
+    return rec->version == ODOMETER_VERSION &&
+           rec->length == sizeof(OdometerRecord) &&
+           rec->crc == crc32_compute(rec, offsetof(OdometerRecord, crc));
+}
+
+static bool slot_read(int fd, int slot, OdometerRecord *rec) {
+#ifdef _WIN32
+    if (_lseek(fd, (long)slot * ODOMETER_SLOT_SIZE, SEEK_SET) < 0) return false;
+    return _read(fd, rec, sizeof(*rec)) == (int)sizeof(*rec);
+#else
+    return pread(fd, rec, sizeof(*rec), (off_t)slot * ODOMETER_SLOT_SIZE) == (ssize_t)sizeof(*rec);
+#endif
+}
+
+static bool slot_write(int fd, int slot, const OdometerRecord *rec) {
+    // Pad to a full sector so the slot is written in one piece
+    uint8_t sector[ODOMETER_SLOT_SIZE] = {0};
+    memcpy(sector, rec, sizeof(*rec));
+#ifdef _WIN32
+    if (_lseek(fd, (long)slot * ODOMETER_SLOT_SIZE, SEEK_SET) < 0) return false;
+    if (_write(fd, sector, sizeof(sector)) != (int)sizeof(sector)) return false;
+    return _commit(fd) == 0;
+#else
+    if (pwrite(fd, sector, sizeof(sector), (off_t)slot * ODOMETER_SLOT_SIZE) != (ssize_t)sizeof(sector)) {
+        return false;
+    }
+    return fdatasync(fd) == 0;
+#endif
+}
+
+// Open the store and recover the newest valid record.
+// Returns true if a record was found; counters are left untouched otherwise.
+bool odometer_store_open(OdometerStore *store, const char *path, OdometerCounters *counters) {
+    memset(store, 0, sizeof(*store));
+
+#ifdef _WIN32
+    store->fd = _open(path, _O_RDWR | _O_CREAT | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    store->fd = open(path, O_RDWR | O_CREAT, 0644);
+#endif
+    if (store->fd < 0) {
+        fprintf(stderr, "Cannot open odometer store %s\n", path);
+        store->saved = *counters;
+        return false;
+    }
+
+    OdometerRecord slots[ODOMETER_SLOT_COUNT];
+    int best = -1;
+    for (int i = 0; i < ODOMETER_SLOT_COUNT; i++) {
+        if (!slot_read(store->fd, i, &slots[i]) || !record_valid(&slots[i])) continue;
+        // Sequence comparison is wrap-safe
+        if (best < 0 || (int32_t)(slots[i].sequence - slots[best].sequence) > 0) {
+            best = i;
+        }
+    }
+
+    if (best < 0) {
+        store->saved = *counters;
+        store->next_slot = 0;
+        return false;
+    }
+
+    counters->odometer = slots[best].odometer;
+    counters->trip_a = slots[best].trip_a;
+    counters->trip_b = slots[best].trip_b;
+    counters->engine_hours = slots[best].engine_hours;
+    counters->latitude = slots[best].latitude;
+    counters->longitude = slots[best].longitude;
+    store->saved = *counters;
+    store->sequence = slots[best].sequence;
+    store->next_slot = (best + 1) % ODOMETER_SLOT_COUNT;
+    return true;
+}
+
+// Save immediately, regardless of the coalescing policy
+bool odometer_store_flush(OdometerStore *store, const OdometerCounters *counters, uint64_t now_ms) {
+    if (store->fd < 0) return false;
+
+    OdometerRecord rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.magic = ODOMETER_MAGIC;
+    rec.version = ODOMETER_VERSION;
+    rec.length = sizeof(rec);
+    rec.sequence = store->sequence + 1;
+    rec.odometer = counters->odometer;
+    rec.trip_a = counters->trip_a;
+    rec.trip_b = counters->trip_b;
+    rec.engine_hours = counters->engine_hours;
+    rec.latitude = counters->latitude;
+    rec.longitude = counters->longitude;
+    rec.crc = crc32_compute(&rec, offsetof(OdometerRecord, crc));
+
+    if (!slot_write(store->fd, store->next_slot, &rec)) {
+        fprintf(stderr, "Odometer store write failed\n");
+        return false;
+    }
+
+    store->saved = *counters;
+    store->sequence = rec.sequence;
+    store->next_slot = (store->next_slot + 1) % ODOMETER_SLOT_COUNT;
+    store->last_save_ms = now_ms;
+    store->write_count++;
+    return true;
+}
+
+// Save only when enough distance or time has accumulated.
+// Cheap enough to call every frame.
+bool odometer_store_update(OdometerStore *store, const OdometerCounters *counters, uint64_t now_ms) {
+    uint64_t since_save = now_ms > store->last_save_ms ? now_ms - store->last_save_ms : 0;
+    double distance = counters->odometer - store->saved.odometer;
+
+    bool distance_due = distance >= ODOMETER_SAVE_DISTANCE && since_save >= ODOMETER_SAVE_MIN_MS;
+    bool time_due = since_save >= ODOMETER_SAVE_IDLE_MS &&
+                    counters->engine_hours != store->saved.engine_hours;
+
+    if (!distance_due && !time_due) return false;
+    return odometer_store_flush(store, counters, now_ms);
+}
+
+void odometer_store_close(OdometerStore *store) {
+    if (store->fd >= 0) {
+#ifdef _WIN32
+        _close(store->fd);
+#else
+        close(store->fd);
+#endif
+        store->fd = -1;
+    }
+}
@@ -0,0 +1,36 @@
+/*
+ * Snow-Pi Odometer Store Header
+ * Author: /x64/dumped
+ */
+
+#ifndef ODOMETER_STORE_H
+#define ODOMETER_STORE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Counters that must survive a power cut
+typedef struct {
+    double odometer;
+    double trip_a;
+    double trip_b;
+    double engine_hours;
+    double latitude;           // Last known position, NAN until one is saved
+    double longitude;
+} OdometerCounters;
+
+typedef struct {
+    int fd;
+    OdometerCounters saved;    // Last value committed to disk
+    uint32_t sequence;         // Sequence number of the last committed record
+    int next_slot;             // Slot the next record goes to (0 or 1)
+    uint64_t last_save_ms;     // now_ms of the last save; every call must use the same clock
+    uint32_t write_count;
+} OdometerStore;
+
+bool odometer_store_open(OdometerStore *store, const char *path, OdometerCounters *counters);
+bool odometer_store_update(OdometerStore *store, const OdometerCounters *counters, uint64_t now_ms);
+bool odometer_store_flush(OdometerStore *store, const OdometerCounters *counters, uint64_t now_ms);
+void odometer_store_close(OdometerStore *store);
+
+#endif
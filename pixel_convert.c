@@ -0,0 +1,58 @@
+/*
+ * Snow-Pi Pixel Conversion - 16-bit texture formats
+ * Author: /x64/dumped
+ * GitHub: @Ma110w
+ *
+ * Converters for the optional 16 bpp pipeline (--16bpp). Tiles are stored
+ * as RGB565 and the glyph atlas as ARGB4444, halving texture memory and
+ * upload bandwidth. The XRGB8888 path uses NEON on ARM boards.
+ */
+
+#include "pixel_convert.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+// True if the renderer stores this format natively. Otherwise SDL would
+// keep a converted 32-bit copy and nothing would be saved.
+bool pixel_format_supported(SDL_Renderer *renderer, SDL_PixelFormat format) {
+    const SDL_PixelFormat *formats = SDL_GetPointerProperty(SDL_GetRendererProperties(renderer),
+                                                            SDL_PROP_RENDERER_TEXTURE_FORMATS_POINTER, NULL);
+    for (; formats && *formats != SDL_PIXELFORMAT_UNKNOWN; formats++) {
+        if (*formats == format) return true;
+    }
+    return false;
+}
+
+void pixel_convert_xrgb8888_to_rgb565(const Uint32 *src, Uint16 *dst, size_t count) {
+    size_t i = 0;
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    // Eight pixels per step: de-interleave B,G,R,X bytes, then shift-insert
+    // the top bits of each channel into place
+    for (; i + 8 <= count; i += 8) {
+        uint8x8x4_t px = vld4_u8((const uint8_t *)(src + i));
+        uint16x8_t out = vshll_n_u8(px.val[2], 8);
+        out = vsriq_n_u16(out, vshll_n_u8(px.val[1], 8), 5);
+        out = vsriq_n_u16(out, vshll_n_u8(px.val[0], 8), 11);
+        vst1q_u16(dst + i, out);
+    }
+#endif
+    for (; i < count; i++) {
+        Uint32 p = src[i];
+        dst[i] = (Uint16)(((p >> 8) & 0xF800) | ((p >> 5) & 0x07E0) | ((p >> 3) & 0x001F));
+    }
+}
+
+// White glyph coverage; vertex colors tint it
+void pixel_convert_alpha_to_argb4444(const Uint8 *alpha, Uint16 *dst, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        dst[i] = (Uint16)(((alpha[i] >> 4) << 12) | 0x0FFF);
+    }
+}
+
+void pixel_fill_rgb565(Uint16 *dst, Uint16 color, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        dst[i] = color;
+    }
+}
@@ -0,0 +1,21 @@
+/*
+ * Snow-Pi Pixel Conversion Header
+ * Author: /x64/dumped
+ */
+
+#ifndef PIXEL_CONVERT_H
+#define PIXEL_CONVERT_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Pack 8-bit channels into RGB565
+#define PIXEL_RGB565(r, g, b) (Uint16)((((r) & 0xF8) << 8) | (((g) & 0xFC) << 3) | ((b) >> 3))
+
+bool pixel_format_supported(SDL_Renderer *renderer, SDL_PixelFormat format);
+void pixel_convert_xrgb8888_to_rgb565(const Uint32 *src, Uint16 *dst, size_t count);
+void pixel_convert_alpha_to_argb4444(const Uint8 *alpha, Uint16 *dst, size_t count);
+void pixel_fill_rgb565(Uint16 *dst, Uint16 color, size_t count);
+
+#endif
@@ -0,0 +1,94 @@
+/*
+ * Snow-Pi Place Search - Offline name lookup
+ * Author: /x64/dumped
+ * GitHub: @Ma110w
+ *
+ * Prefix search over the FTS5 sidecar written by build-place-index.
+ * Rows were inserted most important first (towns, then fuel and lodging,
+ * then trail names), so the first matches in rowid order are already the
+ * ones worth showing and a query never has to rank every hit.
+ */
+
+#include "place_search.h"
+#include <SDL3/SDL.h>
+#include <stdio.h>
+#include <string.h>
+
+bool place_search_open(PlaceSearch *search, const char *path) {
+    memset(search, 0, sizeof(*search));
+    int rc = sqlite3_open_v2(path, &search->db, SQLITE_OPEN_READONLY, NULL);
+    if (rc == SQLITE_OK) {
+        rc = sqlite3_prepare_v3(search->db, "SELECT name, kind, lat, lon FROM places WHERE places MATCH ?1 LIMIT ?2",
+                                -1, SQLITE_PREPARE_PERSISTENT, &search->query_stmt, NULL);
+    }
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Cannot open place index %s: %s\n", path, sqlite3_errmsg(search->db));
+        place_search_close(search);
+        search->failed = true;
+        return false;
+    }
+    return true;
+}
+
+// "lak sup" -> "lak"* "sup"*: every word must match as a prefix.
+// Only letters, digits and UTF-8 bytes are kept, so user text can never
+// form FTS5 syntax.
+static bool build_match(const char *text, char *out, size_t size) {
+    size_t n = 0;
+    bool in_word = false, any = false;
+    for (const char *p = text;; p++) {
+        unsigned char c = (unsigned char)*p;
+        bool word_char = (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c >= 0x80;
+        if (word_char && !in_word) {
+            if (n + 2 >= size) return false;
+            if (any) out[n++] = ' ';
+            out[n++] = '"';
+            in_word = any = true;
+        } else if (!word_char && in_word) {
+            if (n + 3 >= size) return false;
+            out[n++] = '"';
+            out[n++] = '*';
+            in_word = false;
+        }
+        if (c == '\0') break;
+        if (word_char) {
+            if (n + 4 >= size) return false;
+            out[n++] = (char)c;
+        }
+    }
+    out[n] = '\0';
+    return any;
+}
+
+// Refresh results for the text typed so far; returns the number found
+int place_search_query(PlaceSearch *search, const char *text) {
+    search->count = 0;
+    char match[PLACE_SEARCH_MAX_QUERY * 3 + 16];
+    if (!search->query_stmt || !build_match(text, match, sizeof(match))) return 0;
+
+    Uint64 start = SDL_GetTicksNS();
+    sqlite3_stmt *stmt = search->query_stmt;
+    sqlite3_bind_text(stmt, 1, match, -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 2, PLACE_SEARCH_MAX_RESULTS);
+    while (search->count < PLACE_SEARCH_MAX_RESULTS && sqlite3_step(stmt) == SQLITE_ROW) {
+        PlaceResult *r = &search->results[search->count++];
+        const char *name = (const char *)sqlite3_column_text(stmt, 0);
+        const char *kind = (const char *)sqlite3_column_text(stmt, 1);
+        snprintf(r->name, sizeof(r->name), "%s", name ? name : "");
+        snprintf(r->kind, sizeof(r->kind), "%s", kind ? kind : "");
+        r->latitude = sqlite3_column_double(stmt, 2);
+        r->longitude = sqlite3_column_double(stmt, 3);
+    }
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+    search->last_query_ms = (SDL_GetTicksNS() - start) / 1e6f;
+    return search->count;
+}
+
+void place_search_close(PlaceSearch *search) {
+    sqlite3_finalize(search->query_stmt);
+    sqlite3_close(search->db);
+    search->query_stmt = NULL;
+    search->db = NULL;
+    search->count = 0;
+}
@@ -0,0 +1,37 @@
+/*
+ * Snow-Pi Place Search Header
+ * Author: /x64/dumped
+ */
+
+#ifndef PLACE_SEARCH_H
+#define PLACE_SEARCH_H
+
+#include <sqlite3.h>
+#include <stdbool.h>
+
+#define PLACE_INDEX_PATH "places.db"
+#define PLACE_SEARCH_MAX_RESULTS 8
+#define PLACE_SEARCH_MAX_QUERY 48
+#define PLACE_NAME_MAX 64
+
+typedef struct {
+    char name[PLACE_NAME_MAX];
+    char kind[24];           // Source class: town, fuel, path, ...
+    double latitude;
+    double longitude;
+} PlaceResult;
+
+typedef struct {
+    sqlite3 *db;
+    sqlite3_stmt *query_stmt;
+    bool failed;             // Don't retry a missing index on every key
+    PlaceResult results[PLACE_SEARCH_MAX_RESULTS];
+    int count;
+    float last_query_ms;
+} PlaceSearch;
+
+bool place_search_open(PlaceSearch *search, const char *path);
+int place_search_query(PlaceSearch *search, const char *text);
+void place_search_close(PlaceSearch *search);
+
+#endif
@@ -0,0 +1,130 @@
+/*
+ * Snow-Pi Quality Governor - Frame-time and thermal feedback
+ * Author: /x64/dumped
+ * GitHub: @Ma110w
+ *
+ * Steps rendering quality down when frames run long or the SoC is hot and
+ * clocked down (closed hood), and back up once there is sustained headroom.
+ * quality_governor_update is pure, so it can be driven with synthetic
+ * readings; quality_governor_read_thermal is the only part touching sysfs.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "quality_governor.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Pressure / headroom thresholds
+#define QUALITY_PRESSURE_FRACTION 0.85f   // p90 frame time above this share of the budget
+#define QUALITY_HEADROOM_FRACTION 0.60f   // p90 below this (vsync makes ~0.5 the floor at 60 Hz)
+#define QUALITY_HOT_C 80.0f               // Pi firmware starts soft throttling here
+#define QUALITY_WARM_C 75.0f              // Counts as pressure only if also clocked down
+#define QUALITY_COOL_C 70.0f
+#define QUALITY_STEP_DOWN_MS 1000         // Sustained pressure before dropping a level
+#define QUALITY_STEP_UP_MS 10000          // Sustained headroom before raising a level
+
+const QualityProfile QUALITY_PROFILES[QUALITY_LEVEL_COUNT] = {
+    //  name      map ms  seg/deg  aa     graph div  prefetch  inset ms
+    {"LOW",       1000,   0.5f,    false, 4,         0,        500},
+    {"MEDIUM",     250,   1.0f,    false, 2,         1,        333},
+    {"HIGH",         0,   2.0f,    true,  1,         2,        200},
+};
+
+void quality_governor_init(QualityGovernor *gov, float budget_ms, QualityLevel start) {
+    memset(gov, 0, sizeof(*gov));
+    gov->budget_ms = budget_ms;
+    gov->level = start;
+    gov->thermal.temp_c = -1.0f;
+    gov->thermal.cur_khz = -1;
+    gov->thermal.max_khz = -1;
+}
+
+float quality_governor_p90(const QualityGovernor *gov) {
+    if (gov->frame_count == 0) return 0.0f;
+
+    // Insertion sort of a small window
+    float sorted[QUALITY_WINDOW];
+    int n = gov->frame_count;
+    for (int i = 0; i < n; i++) {
+        float v = gov->frame_ms[i];
+        int j = i;
+        while (j > 0 && sorted[j - 1] > v) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = v;
+    }
+    return sorted[(n * 9) / 10];
+}
+
+// Feed one frame's work time. thermal is the latest SoC reading, or NULL
+// if none was taken this frame. Returns the (possibly new) level.
+QualityLevel quality_governor_update(QualityGovernor *gov, float frame_ms, const ThermalReading *thermal, uint32_t dt_ms) {
+    gov->frame_ms[gov->frame_index] = frame_ms;
+    gov->frame_index = (gov->frame_index + 1) % QUALITY_WINDOW;
+    if (gov->frame_count < QUALITY_WINDOW) gov->frame_count++;
+    if (thermal) gov->thermal = *thermal;
+
+    float p90 = quality_governor_p90(gov);
+    const ThermalReading *t = &gov->thermal;
+    bool clocked_down = t->cur_khz > 0 && t->max_khz > 0 && t->cur_khz < t->max_khz * 9 / 10;
+    bool hot = t->temp_c >= QUALITY_HOT_C || (t->temp_c >= QUALITY_WARM_C && clocked_down);
+    bool cool = t->temp_c < QUALITY_COOL_C;  // Unknown (-1) counts as cool
+
+    bool pressure = hot || (gov->frame_count == QUALITY_WINDOW && p90 > gov->budget_ms * QUALITY_PRESSURE_FRACTION);
+    bool headroom = cool && gov->frame_count == QUALITY_WINDOW && p90 < gov->budget_ms * QUALITY_HEADROOM_FRACTION;
+
+    gov->pressure_ms = pressure ? gov->pressure_ms + dt_ms : 0;
+    gov->headroom_ms = headroom ? gov->headroom_ms + dt_ms : 0;
+
+    if (gov->pressure_ms >= QUALITY_STEP_DOWN_MS && gov->level > QUALITY_LOW) {
+        gov->level--;
+        gov->changes++;
+        gov->pressure_ms = 0;
+        gov->change_p90 = p90;
+        gov->frame_count = 0;   // Judge the new level on its own frames
+        gov->frame_index = 0;
+    } else if (gov->headroom_ms >= QUALITY_STEP_UP_MS && gov->level < QUALITY_LEVEL_COUNT - 1) {
+        gov->level++;
+        gov->changes++;
+        gov->headroom_ms = 0;
+        gov->change_p90 = p90;
+        gov->frame_count = 0;
+        gov->frame_index = 0;
+    }
+    return gov->level;
+}
+
+#ifndef _WIN32
+// Read a small integer sysfs file without stdio (no heap use)
+static long read_sysfs_long(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    char buf[32];
+    ssize_t n = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (n <= 0) return -1;
+    buf[n] = '\0';
+    return strtol(buf, NULL, 10);
+}
+
+bool quality_governor_read_thermal(ThermalReading *out) {
+    long milli_c = read_sysfs_long("/sys/class/thermal/thermal_zone0/temp");
+    out->temp_c = milli_c >= 0 ? milli_c / 1000.0f : -1.0f;
+    out->cur_khz = (int)read_sysfs_long("/sys/devices/system/cpu/cpu0/cpufreq/scaling_cur_freq");
+    out->max_khz = (int)read_sysfs_long("/sys/devices/system/cpu/cpu0/cpufreq/cpuinfo_max_freq");
+    return milli_c >= 0 || out->cur_khz > 0;
+}
+#else
+bool quality_governor_read_thermal(ThermalReading *out) {
+    out->temp_c = -1.0f;
+    out->cur_khz = out->max_khz = -1;
+    return false;
+}
+#endif
@@ -0,0 +1,65 @@
+/*
+ * Snow-Pi Quality Governor Header
+ * Author: /x64/dumped
+ */
+
+#ifndef QUALITY_GOVERNOR_H
+#define QUALITY_GOVERNOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define QUALITY_WINDOW 32            // Frames in the rolling frame-time window
+#define QUALITY_THERMAL_PERIOD_MS 1000
+
+typedef enum {
+    QUALITY_LOW,
+    QUALITY_MEDIUM,
+    QUALITY_HIGH,
+    QUALITY_LEVEL_COUNT
+} QualityLevel;
+
+// Cosmetic cost knobs only. Warnings, speed and the sensor pipeline are
+// never governed so they stay on time at every level.
+typedef struct {
+    const char *name;
+    uint32_t map_refresh_ms;         // Minimum time between map layer redraws while moving
+    float gauge_segments_per_degree; // Arc tessellation
+    bool gauge_antialias;            // Extra coverage points around each arc point
+    int graph_column_divisor;        // History graph pixels per column
+    int prefetch_radius;             // Map tiles warmed beyond the visible area
+    uint32_t inset_refresh_ms;       // Minimum time between gauge screen mini-map redraws
+} QualityProfile;
+
+extern const QualityProfile QUALITY_PROFILES[QUALITY_LEVEL_COUNT];
+
+// One SoC sample; fields are negative when the source is unavailable
+typedef struct {
+    float temp_c;
+    int cur_khz;
+    int max_khz;
+} ThermalReading;
+
+typedef struct {
+    float frame_ms[QUALITY_WINDOW];
+    int frame_count;
+    int frame_index;
+    float budget_ms;                 // Frame work budget (the frame period)
+    ThermalReading thermal;
+    QualityLevel level;
+    uint32_t pressure_ms;            // How long pressure has persisted
+    uint32_t headroom_ms;            // How long headroom has persisted
+    uint32_t changes;
+    float change_p90;                // Window p90 when the level last changed
+} QualityGovernor;
+
+void quality_governor_init(QualityGovernor *gov, float budget_ms, QualityLevel start);
+bool quality_governor_read_thermal(ThermalReading *out);
+QualityLevel quality_governor_update(QualityGovernor *gov, float frame_ms, const ThermalReading *thermal, uint32_t dt_ms);
+float quality_governor_p90(const QualityGovernor *gov);
+
+static inline const QualityProfile *quality_governor_profile(const QualityGovernor *gov) {
+    return &QUALITY_PROFILES[gov->level];
+}
+
+#endif
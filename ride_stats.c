@@ -0,0 +1,80 @@
+/*
+ * Snow-Pi Ride Statistics - Streaming per-ride and per-trip stats
+ * Author: /x64/dumped
+ * GitHub: @Ma110w
+ *
+ * Min, max, mean and time above threshold for every channel, plus
+ * p50/p95/p99 from fixed histograms. Memory never grows with ride length.
+ */
+
+#include "ride_stats.h"
+#include <float.h>
+#include <string.h>
+
+#define STATS_HIST_MIN 50.0f   // Lowest temperature bin (F); bins are 1 degree wide
+
+// "Time above" thresholds per channel (matches the caution levels)
+static const float STATS_THRESHOLD[SENSOR_CHANNEL_COUNT] = {
+    [SENSOR_SPEED] = 60.0f,
+    [SENSOR_RPM] = 8000.0f,
+    [SENSOR_ENGINE_TEMP] = 200.0f,
+    [SENSOR_COOLANT_TEMP] = 190.0f,
+    [SENSOR_BELT_TEMP] = 160.0f,
+    [SENSOR_FUEL_LEVEL] = 100.0f,
+    [SENSOR_VOLTAGE] = 14.5f,
+    [SENSOR_TRAIL_DISTANCE] = 50.0f,   // Time off trail
+    [SENSOR_RESTRICTED_AREA] = 0.5f,   // Time inside a no-go area
+};
+
+static const SensorChannel STATS_HIST_CHANNEL[STATS_HIST_COUNT] = {
+    [STATS_HIST_BELT_TEMP] = SENSOR_BELT_TEMP,
+    [STATS_HIST_ENGINE_TEMP] = SENSOR_ENGINE_TEMP,
+};
+
+void ride_stats_reset(RideStats *stats) {
+    memset(stats, 0, sizeof(*stats));
+    for (int ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++) {
+        stats->min[ch] = FLT_MAX;
+        stats->max[ch] = -FLT_MAX;
+    }
+}
+
+void ride_stats_update(RideStats *stats, const float *values, float dt) {
+    for (int ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++) {
+        float v = values[ch];
+        stats->min[ch] = v < stats->min[ch] ? v : stats->min[ch];
+        stats->max[ch] = v > stats->max[ch] ? v : stats->max[ch];
+        stats->sum[ch] += v * dt;
+        stats->above_seconds[ch] += v > STATS_THRESHOLD[ch] ? dt : 0.0f;
+    }
+    stats->seconds += dt;
+
+    for (int h = 0; h < STATS_HIST_COUNT; h++) {
+        int bin = (int)(values[STATS_HIST_CHANNEL[h]] - STATS_HIST_MIN);
+        bin = bin < 0 ? 0 : (bin >= RIDE_STATS_BINS ? RIDE_STATS_BINS - 1 : bin);
+        stats->hist[h].bins[bin] += dt;
+        stats->hist[h].total += dt;
+    }
+}
+
+float ride_stats_mean(const RideStats *stats, SensorChannel channel) {
+    if (stats->seconds <= 0.0) return 0.0f;
+    return (float)(stats->sum[channel] / stats->seconds);
+}
+
+// Time-weighted quantile with linear interpolation inside the bin (q in 0..1)
+float ride_stats_quantile(const RideStats *stats, StatsHistogramId id, float q) {
+    const StatsHistogram *hist = &stats->hist[id];
+    if (hist->total <= 0.0) return 0.0f;
+
+    double target = q * hist->total;
+    double seen = 0.0;
+    for (int bin = 0; bin < RIDE_STATS_BINS; bin++) {
+        double n = hist->bins[bin];
+        if (n > 0.0 && seen + n >= target) {
+            return STATS_HIST_MIN + bin + (float)((target - seen) / n);
+        }
+        seen += n;
+    }
+    return STATS_HIST_MIN + RIDE_STATS_BINS;
+}
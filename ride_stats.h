@@ -0,0 +1,42 @@
+/*
+ * Snow-Pi Ride Statistics Header
+ * Author: /x64/dumped
+ */
+
+#ifndef RIDE_STATS_H
+#define RIDE_STATS_H
+
+#include <stdint.h>
+#include "sensor_channels.h"
+
+#define RIDE_STATS_BINS 256
+
+// Channels that keep a histogram for quantiles
+typedef enum {
+    STATS_HIST_BELT_TEMP,
+    STATS_HIST_ENGINE_TEMP,
+    STATS_HIST_COUNT
+} StatsHistogramId;
+
+// Fixed-range histogram, 1 degree per bin, weighted by time like the mean
+typedef struct {
+    double bins[RIDE_STATS_BINS];   // Seconds spent in each bin
+    double total;
+} StatsHistogram;
+
+// Constant-memory statistics; every update is O(1)
+typedef struct {
+    float min[SENSOR_CHANNEL_COUNT];
+    float max[SENSOR_CHANNEL_COUNT];
+    double sum[SENSOR_CHANNEL_COUNT];           // Time-weighted
+    double above_seconds[SENSOR_CHANNEL_COUNT];
+    double seconds;
+    StatsHistogram hist[STATS_HIST_COUNT];
+} RideStats;
+
+void ride_stats_reset(RideStats *stats);
+void ride_stats_update(RideStats *stats, const float *values, float dt);
+float ride_stats_mean(const RideStats *stats, SensorChannel channel);
+float ride_stats_quantile(const RideStats *stats, StatsHistogramId id, float q);
+
+#endif
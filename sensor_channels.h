@@ -0,0 +1,23 @@
+/*
+ * Snow-Pi Sensor Channels
+ * Author: /x64/dumped
+ */
+
+#ifndef SENSOR_CHANNELS_H
+#define SENSOR_CHANNELS_H
+
+// Every sampled input, in the order used by all per-channel tables
+typedef enum {
+    SENSOR_SPEED,
+    SENSOR_RPM,
+    SENSOR_ENGINE_TEMP,
+    SENSOR_COOLANT_TEMP,
+    SENSOR_BELT_TEMP,
+    SENSOR_FUEL_LEVEL,
+    SENSOR_VOLTAGE,
+    SENSOR_TRAIL_DISTANCE,     // Metres to the nearest trail (0 without a trail index)
+    SENSOR_RESTRICTED_AREA,    // 1 inside a no-go area
+    SENSOR_CHANNEL_COUNT
+} SensorChannel;
+
+#endif
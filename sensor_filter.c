@@ -0,0 +1,191 @@
+/*
+ * Snow-Pi Sensor Filter Bank
+ * Author: /x64/dumped
+ * GitHub: @Ma110w
+ *
+ * Runs EMA, median-of-5 and 1-D Kalman filters over every channel in one
+ * SIMD pass per sample tick. Every lane computes all three filters and a
+ * per-channel mask picks the configured one, so there are no branches.
+ */
+
+#include "sensor_filter.h"
+#include <string.h>
+
+// 4-wide float vector helpers (NEON, SSE or plain C)
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+typedef float32x4_t vf4;
+typedef uint32x4_t vm4;
+static inline vf4 v_load(const float *p) { return vld1q_f32(p); }
+static inline void v_store(float *p, vf4 a) { vst1q_f32(p, a); }
+static inline vm4 m_load(const uint32_t *p) { return vld1q_u32(p); }
+static inline vf4 v_add(vf4 a, vf4 b) { return vaddq_f32(a, b); }
+static inline vf4 v_sub(vf4 a, vf4 b) { return vsubq_f32(a, b); }
+static inline vf4 v_mul(vf4 a, vf4 b) { return vmulq_f32(a, b); }
+static inline vf4 v_min(vf4 a, vf4 b) { return vminq_f32(a, b); }
+static inline vf4 v_max(vf4 a, vf4 b) { return vmaxq_f32(a, b); }
+static inline vf4 v_select(vm4 m, vf4 a, vf4 b) { return vbslq_f32(m, a, b); }
+static inline vf4 v_div(vf4 a, vf4 b) {
+#if defined(__aarch64__)
+    return vdivq_f32(a, b);
+#else
+    // ARMv7 NEON has no divide: reciprocal estimate + two Newton steps
+    vf4 r = vrecpeq_f32(b);
+    r = vmulq_f32(vrecpsq_f32(b, r), r);
+    r = vmulq_f32(vrecpsq_f32(b, r), r);
+    return vmulq_f32(a, r);
+#endif
+}
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+typedef __m128 vf4;
+typedef __m128 vm4;
+static inline vf4 v_load(const float *p) { return _mm_load_ps(p); }
+static inline void v_store(float *p, vf4 a) { _mm_store_ps(p, a); }
+static inline vm4 m_load(const uint32_t *p) { return _mm_castsi128_ps(_mm_load_si128((const __m128i *)p)); }
+static inline vf4 v_add(vf4 a, vf4 b) { return _mm_add_ps(a, b); }
+static inline vf4 v_sub(vf4 a, vf4 b) { return _mm_sub_ps(a, b); }
+static inline vf4 v_mul(vf4 a, vf4 b) { return _mm_mul_ps(a, b); }
+static inline vf4 v_div(vf4 a, vf4 b) { return _mm_div_ps(a, b); }
+static inline vf4 v_min(vf4 a, vf4 b) { return _mm_min_ps(a, b); }
+static inline vf4 v_max(vf4 a, vf4 b) { return _mm_max_ps(a, b); }
+static inline vf4 v_select(vm4 m, vf4 a, vf4 b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+#else
+typedef struct { float v[4]; } vf4;
+typedef struct { uint32_t v[4]; } vm4;
+#define V_OP(name, expr) \
+    static inline vf4 name(vf4 a, vf4 b) { vf4 r; for (int i = 0; i < 4; i++) r.v[i] = (expr); return r; }
+V_OP(v_add, a.v[i] + b.v[i])
+V_OP(v_sub, a.v[i] - b.v[i])
+V_OP(v_mul, a.v[i] * b.v[i])
+V_OP(v_div, a.v[i] / b.v[i])
+V_OP(v_min, a.v[i] < b.v[i] ? a.v[i] : b.v[i])
+V_OP(v_max, a.v[i] > b.v[i] ? a.v[i] : b.v[i])
+#undef V_OP
+static inline vf4 v_load(const float *p) { vf4 r; memcpy(r.v, p, sizeof(r.v)); return r; }
+static inline void v_store(float *p, vf4 a) { memcpy(p, a.v, sizeof(a.v)); }
+static inline vm4 m_load(const uint32_t *p) { vm4 r; memcpy(r.v, p, sizeof(r.v)); return r; }
+static inline vf4 v_select(vm4 m, vf4 a, vf4 b) {
+    vf4 r;
+    for (int i = 0; i < 4; i++) r.v[i] = m.v[i] ? a.v[i] : b.v[i];
+    return r;
+}
+#endif
+
+// Speed and RPM come from the engine model and are already smooth. Temperatures
+// use Kalman (slow, noisy), fuel uses EMA (slosh), voltage uses median (spikes).
+const SensorFilterConfig SENSOR_FILTER_TABLE[] = {
+    {SENSOR_SPEED,        FILTER_NONE,   0.0f,  0.0f},
+    {SENSOR_RPM,          FILTER_NONE,   0.0f,  0.0f},
+    {SENSOR_ENGINE_TEMP,  FILTER_KALMAN, 0.05f, 1.0f},
+    {SENSOR_COOLANT_TEMP, FILTER_KALMAN, 0.05f, 1.0f},
+    {SENSOR_BELT_TEMP,    FILTER_KALMAN, 0.10f, 1.0f},
+    {SENSOR_FUEL_LEVEL,   FILTER_EMA,    0.05f, 0.0f},
+    {SENSOR_VOLTAGE,      FILTER_MEDIAN, 0.0f,  0.0f},
+    {SENSOR_TRAIL_DISTANCE, FILTER_NONE, 0.0f,  0.0f},
+    {SENSOR_RESTRICTED_AREA, FILTER_NONE, 0.0f, 0.0f},
+};
+const int SENSOR_FILTER_TABLE_SIZE = sizeof(SENSOR_FILTER_TABLE) / sizeof(SENSOR_FILTER_TABLE[0]);
+
+// Median of three with min/max only
+static inline vf4 v_median3(vf4 a, vf4 b, vf4 c) {
+    return v_max(v_min(a, b), v_min(v_max(a, b), c));
+}
+
+// Build the per-channel coefficient and selection arrays from a config table
+void sensor_filter_init(SensorFilterBank *bank, const SensorFilterConfig *table, int count) {
+    memset(bank, 0, sizeof(*bank));
+
+    for (int ch = 0; ch < SENSOR_FILTER_LANES; ch++) {
+        bank->alpha[ch] = 1.0f;
+        bank->kalman_q[ch] = 1.0f;
+        bank->kalman_r[ch] = 1.0f;
+    }
+
+    for (int i = 0; i < count; i++) {
+        int ch = table[i].channel;
+        if (ch < 0 || ch >= SENSOR_CHANNEL_COUNT) continue;
+
+        bank->use_ema[ch] = bank->use_median[ch] = bank->use_kalman[ch] = 0;
+        switch (table[i].type) {
+            case FILTER_EMA:
+                bank->use_ema[ch] = 0xFFFFFFFFu;
+                bank->alpha[ch] = table[i].param_a;
+                break;
+            case FILTER_MEDIAN:
+                bank->use_median[ch] = 0xFFFFFFFFu;
+                break;
+            case FILTER_KALMAN:
+                bank->use_kalman[ch] = 0xFFFFFFFFu;
+                bank->kalman_q[ch] = table[i].param_a;
+                bank->kalman_r[ch] = table[i].param_b;
+                break;
+            case FILTER_NONE:
+            default:
+                break;
+        }
+    }
+}
+
+// Forget history; the next sample re-primes every filter
+void sensor_filter_reset(SensorFilterBank *bank) {
+    bank->primed = false;
+    bank->tap_index = 0;
+}
+
+// Seed all filter state from the first sample so nothing ramps from zero
+static void sensor_filter_prime(SensorFilterBank *bank, const float *z) {
+    for (int ch = 0; ch < SENSOR_FILTER_LANES; ch++) {
+        bank->ema[ch] = z[ch];
+        bank->kalman_x[ch] = z[ch];
+        bank->kalman_p[ch] = bank->kalman_r[ch];
+        for (int t = 0; t < SENSOR_MEDIAN_TAPS; t++) {
+            bank->taps[t][ch] = z[ch];
+        }
+    }
+    bank->primed = true;
+}
+
+void sensor_filter_process(SensorFilterBank *bank, const float raw[SENSOR_CHANNEL_COUNT]) {
+    _Alignas(16) float z[SENSOR_FILTER_LANES] = {0};
+    memcpy(z, raw, SENSOR_CHANNEL_COUNT * sizeof(float));
+
+    if (!bank->primed) sensor_filter_prime(bank, z);
+
+    int tap = bank->tap_index;
+    bank->tap_index = (tap + 1) % SENSOR_MEDIAN_TAPS;
+
+    for (int ch = 0; ch < SENSOR_FILTER_LANES; ch += 4) {
+        vf4 zv = v_load(&z[ch]);
+
+        // EMA: y += alpha * (z - y)
+        vf4 ema = v_load(&bank->ema[ch]);
+        ema = v_add(ema, v_mul(v_load(&bank->alpha[ch]), v_sub(zv, ema)));
+        v_store(&bank->ema[ch], ema);
+
+        // Median of 5: med3(max of the two mins, min of the two maxes, fifth)
+        v_store(&bank->taps[tap][ch], zv);
+        vf4 a = v_load(&bank->taps[0][ch]);
+        vf4 b = v_load(&bank->taps[1][ch]);
+        vf4 c = v_load(&bank->taps[2][ch]);
+        vf4 d = v_load(&bank->taps[3][ch]);
+        vf4 e = v_load(&bank->taps[4][ch]);
+        vf4 median = v_median3(v_max(v_min(a, b), v_min(c, d)),
+                               v_min(v_max(a, b), v_max(c, d)), e);
+
+        // 1-D Kalman with a constant-value model
+        vf4 x = v_load(&bank->kalman_x[ch]);
+        vf4 p = v_add(v_load(&bank->kalman_p[ch]), v_load(&bank->kalman_q[ch]));
+        vf4 k = v_div(p, v_add(p, v_load(&bank->kalman_r[ch])));
+        x = v_add(x, v_mul(k, v_sub(zv, x)));
+        p = v_sub(p, v_mul(k, p));
+        v_store(&bank->kalman_x[ch], x);
+        v_store(&bank->kalman_p[ch], p);
+
+        // Pick each channel's configured output
+        vf4 out = v_select(m_load(&bank->use_ema[ch]), ema, zv);
+        out = v_select(m_load(&bank->use_median[ch]), median, out);
+        out = v_select(m_load(&bank->use_kalman[ch]), x, out);
+        v_store(&bank->out[ch], out);
+    }
+}
@@ -0,0 +1,57 @@
+/*
+ * Snow-Pi Sensor Filter Bank Header
+ * Author: /x64/dumped
+ */
+
+#ifndef SENSOR_FILTER_H
+#define SENSOR_FILTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "sensor_channels.h"
+
+// Channel count padded to a whole number of 4-wide SIMD vectors
+#define SENSOR_FILTER_LANES (((SENSOR_CHANNEL_COUNT) + 3) & ~3)
+#define SENSOR_MEDIAN_TAPS 5
+
+typedef enum {
+    FILTER_NONE,
+    FILTER_EMA,      // param_a = smoothing factor (0..1]
+    FILTER_MEDIAN,   // Median of the last SENSOR_MEDIAN_TAPS samples
+    FILTER_KALMAN    // param_a = process noise, param_b = measurement noise
+} SensorFilterType;
+
+typedef struct {
+    SensorChannel channel;
+    SensorFilterType type;
+    float param_a;
+    float param_b;
+} SensorFilterConfig;
+
+// Structure-of-arrays state: one array per quantity, indexed by channel
+typedef struct {
+    _Alignas(16) float out[SENSOR_FILTER_LANES];
+    _Alignas(16) float ema[SENSOR_FILTER_LANES];
+    _Alignas(16) float alpha[SENSOR_FILTER_LANES];
+    _Alignas(16) float taps[SENSOR_MEDIAN_TAPS][SENSOR_FILTER_LANES];
+    _Alignas(16) float kalman_x[SENSOR_FILTER_LANES];
+    _Alignas(16) float kalman_p[SENSOR_FILTER_LANES];
+    _Alignas(16) float kalman_q[SENSOR_FILTER_LANES];
+    _Alignas(16) float kalman_r[SENSOR_FILTER_LANES];
+    // All-ones lanes select that filter's output for the channel
+    _Alignas(16) uint32_t use_ema[SENSOR_FILTER_LANES];
+    _Alignas(16) uint32_t use_median[SENSOR_FILTER_LANES];
+    _Alignas(16) uint32_t use_kalman[SENSOR_FILTER_LANES];
+    int tap_index;
+    bool primed;
+} SensorFilterBank;
+
+// Default per-channel configuration
+extern const SensorFilterConfig SENSOR_FILTER_TABLE[];
+extern const int SENSOR_FILTER_TABLE_SIZE;
+
+void sensor_filter_init(SensorFilterBank *bank, const SensorFilterConfig *table, int count);
+void sensor_filter_process(SensorFilterBank *bank, const float raw[SENSOR_CHANNEL_COUNT]);
+void sensor_filter_reset(SensorFilterBank *bank);
+
+#endif
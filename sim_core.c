@@ -0,0 +1,237 @@
+/*
+ * Snow-Pi Simulation Core - Fixed-timestep vehicle model
+ * Author: /x64/dumped
+ * GitHub: @Ma110w
+ *
+ * Engine, speed, temperature, fuel and position models advanced in fixed
+ * SIM_STEP_MS steps. The render loop feeds wall-clock time into an
+ * accumulator and interpolates between the last two steps; headless runs
+ * (--simulate) step as fast as the CPU allows from a script of inputs.
+ */
+
+#include "sim_core.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define SIM_IDLE_RPM 1000.0f
+#define SIM_MAX_RPM 9000.0f
+#define SIM_THROTTLE_RISE 1.5f          // Per second while held
+#define SIM_THROTTLE_FALL 2.4f          // Per second after release
+#define SIM_MAX_YAW_RATE 30.0f          // Degrees per second at full lock
+#define SIM_METERS_PER_DEG_LAT 111320.0
+
+void sim_core_init(SimCore *sim, double latitude, double longitude, uint32_t seed) {
+    memset(sim, 0, sizeof(*sim));
+    SimState *s = &sim->curr;
+    s->rpm = SIM_IDLE_RPM;
+    s->target_rpm = SIM_IDLE_RPM;
+    s->engine_temp = 70;
+    s->coolant_temp = 65;
+    s->belt_temp = 80;  // Belt starts cool
+    s->fuel_level = 85;
+    s->voltage = 13.8f;
+    s->latitude = latitude;
+    s->longitude = longitude;
+    sim->prev = *s;
+    sim->rng = seed ? seed : 0x9E3779B9u;
+}
+
+// Add wall-clock time; returns how many fixed steps are now due
+int sim_core_accumulate(SimCore *sim, uint32_t elapsed_ms) {
+    if (elapsed_ms > SIM_MAX_FRAME_MS) elapsed_ms = SIM_MAX_FRAME_MS;
+    sim->accumulator_ms += elapsed_ms;
+    int steps = (int)(sim->accumulator_ms / SIM_STEP_MS);
+    sim->accumulator_ms -= (uint32_t)steps * SIM_STEP_MS;
+    return steps;
+}
+
+// How far the renderer is between the previous and current step (0..1)
+float sim_core_alpha(const SimCore *sim) {
+    return (float)sim->accumulator_ms / SIM_STEP_MS;
+}
+
+static float sim_random(SimCore *sim) {
+    uint32_t x = sim->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    sim->rng = x;
+    return (x >> 8) / 16777216.0f;  // [0, 1)
+}
+
+const SimState *sim_core_step(SimCore *sim, const SimInput *input) {
+    const float dt = SIM_STEP_MS / 1000.0f;
+    sim->prev = sim->curr;
+    SimState *v = &sim->curr;
+
+    // Throttle ramps toward the control position
+    if (input->throttle_target > v->throttle) {
+        v->throttle = fminf(v->throttle + SIM_THROTTLE_RISE * dt, input->throttle_target);
+    } else {
+        v->throttle = fmaxf(v->throttle - SIM_THROTTLE_FALL * dt, input->throttle_target);
+    }
+
+    // Target RPM based on throttle
+    v->target_rpm = SIM_IDLE_RPM + (SIM_MAX_RPM - SIM_IDLE_RPM) * v->throttle;
+
+    // RPM responds to throttle with some lag (acceleration/deceleration)
+    float rpm_diff = v->target_rpm - v->rpm;
+    float rpm_accel_rate = 3000.0f; // RPM per second when throttling
+    float rpm_decel_rate = 2000.0f; // RPM per second when releasing
+    if (rpm_diff > 0) {
+        v->rpm += fminf(rpm_diff, rpm_accel_rate * dt);
+    } else {
+        v->rpm += fmaxf(rpm_diff, -rpm_decel_rate * dt);
+    }
+
+    // Speed is derived from RPM and gear (simplified); reverse is limited
+    float rpm_above_idle = fmaxf(0, v->rpm - SIM_IDLE_RPM);
+    float target_speed = (rpm_above_idle / (SIM_MAX_RPM - SIM_IDLE_RPM)) * (input->reverse ? -25.0f : 120.0f);
+
+    // Speed has momentum and drag
+    float speed_diff = target_speed - v->speed;
+    float accel_rate = 40.0f; // MPH per second
+    float drag_rate = 60.0f;  // Deceleration from drag
+    if (fabsf(speed_diff) < 0.1f) {
+        v->speed = target_speed;
+    } else if (speed_diff > 0) {
+        v->speed += fminf(speed_diff, accel_rate * dt);
+    } else {
+        v->speed += fmaxf(speed_diff, -drag_rate * dt);
+    }
+
+    // Engine temp increases with throttle
+    float temp_increase = v->throttle * 0.5f * dt;
+    float temp_cooling = 1.0f * dt;
+    v->engine_temp += temp_increase - temp_cooling;
+    v->engine_temp = fmaxf(70.0f, fminf(v->engine_temp, 250.0f));
+
+    // Coolant temp follows engine temp
+    v->coolant_temp += (v->engine_temp - v->coolant_temp) * 0.1f * dt;
+
+    // Belt heats faster than the engine and is cooled by airflow
+    float belt_heating = v->throttle * 1.2f * dt;
+    float belt_cooling = (v->speed / 120.0f) * 2.0f * dt;
+    v->belt_temp += belt_heating - belt_cooling;
+    v->belt_temp = fmaxf(80.0f, fminf(v->belt_temp, 220.0f));
+
+    // Fuel consumption based on throttle
+    if (v->throttle > 0.1f) {
+        v->fuel_level = fmaxf(0, v->fuel_level - v->throttle * 0.1f * dt);
+    }
+
+    // Voltage rises slightly with RPM
+    v->voltage = 13.8f + (v->rpm / SIM_MAX_RPM) * 0.3f;
+
+    // Dead reckoning: steer turns the heading, speed moves the position
+    v->heading = fmodf(v->heading + input->steer * SIM_MAX_YAW_RATE * dt + 360.0f, 360.0f);
+    double meters = v->speed * 0.44704 * dt;
+    double heading_rad = v->heading * M_PI / 180.0;
+    v->latitude += meters * cos(heading_rad) / SIM_METERS_PER_DEG_LAT;
+    v->longitude += meters * sin(heading_rad) / (SIM_METERS_PER_DEG_LAT * cos(v->latitude * M_PI / 180.0));
+    v->step_miles = fabsf(v->speed) * dt / 3600.0f;
+
+    sim->time_ms += SIM_STEP_MS;
+    sim->steps++;
+    return v;
+}
+
+// What the sensors read this step (voltage pickup is noisy)
+void sim_core_sample(SimCore *sim, float raw[SENSOR_CHANNEL_COUNT]) {
+    const SimState *v = &sim->curr;
+    raw[SENSOR_SPEED] = v->speed;
+    raw[SENSOR_RPM] = v->rpm;
+    raw[SENSOR_ENGINE_TEMP] = v->engine_temp;
+    raw[SENSOR_COOLANT_TEMP] = v->coolant_temp;
+    raw[SENSOR_BELT_TEMP] = v->belt_temp;
+    raw[SENSOR_FUEL_LEVEL] = v->fuel_level;
+    raw[SENSOR_VOLTAGE] = v->voltage + (sim_random(sim) - 0.5f) / 10.0f;
+    raw[SENSOR_TRAIL_DISTANCE] = 0.0f;   // Position channels come from the trail index
+    raw[SENSOR_RESTRICTED_AREA] = 0.0f;
+}
+
+// Script lines are "<seconds> <command> [value]":
+//   throttle 0..1, steer -1..1, reverse, drive, end
+// '#' starts a comment. Times must not go backwards.
+bool sim_script_load(SimScript *script, const char *path) {
+    memset(script, 0, sizeof(*script));
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "Cannot open simulation script %s\n", path);
+        return false;
+    }
+
+    SimInput input = {0};
+    char line[128];
+    int line_number = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), file)) {
+        line_number++;
+        char *comment = strchr(line, '#');
+        if (comment) *comment = '\0';
+
+        double seconds;
+        char command[16];
+        float value = 0.0f;
+        int fields = sscanf(line, "%lf %15s %f", &seconds, command, &value);
+        if (fields <= 0) continue;  // Blank line
+
+        uint32_t at_ms = (uint32_t)(seconds * 1000.0);
+        bool needs_value = strcmp(command, "throttle") == 0 || strcmp(command, "steer") == 0;
+        if (fields < 2 || (needs_value && fields < 3) || seconds < 0 ||
+            (script->count > 0 && at_ms < script->events[script->count - 1].at_ms)) {
+            fprintf(stderr, "%s:%d: bad script line\n", path, line_number);
+            ok = false;
+            break;
+        }
+
+        if (strcmp(command, "throttle") == 0) {
+            input.throttle_target = fmaxf(0.0f, fminf(value, 1.0f));
+        } else if (strcmp(command, "steer") == 0) {
+            input.steer = fmaxf(-1.0f, fminf(value, 1.0f));
+        } else if (strcmp(command, "reverse") == 0) {
+            input.reverse = true;
+        } else if (strcmp(command, "drive") == 0) {
+            input.reverse = false;
+        } else if (strcmp(command, "end") == 0) {
+            script->end_ms = at_ms;
+            break;
+        } else {
+            fprintf(stderr, "%s:%d: unknown command '%s'\n", path, line_number, command);
+            ok = false;
+            break;
+        }
+
+        if (script->count == SIM_SCRIPT_MAX_EVENTS) {
+            fprintf(stderr, "%s: more than %d events\n", path, SIM_SCRIPT_MAX_EVENTS);
+            ok = false;
+            break;
+        }
+        script->events[script->count].at_ms = at_ms;
+        script->events[script->count].input = input;
+        script->count++;
+    }
+    fclose(file);
+
+    if (ok && script->end_ms == 0) {
+        fprintf(stderr, "%s: missing 'end' line\n", path);
+        ok = false;
+    }
+    return ok;
+}
+
+// Input in effect at time_ms; cursor remembers the position between calls
+const SimInput *sim_script_input(const SimScript *script, uint64_t time_ms, int *cursor) {
+    static const SimInput idle = {0};
+    while (*cursor + 1 < script->count && script->events[*cursor + 1].at_ms <= time_ms) {
+        (*cursor)++;
+    }
+    if (script->count == 0 || script->events[*cursor].at_ms > time_ms) return &idle;
+    return &script->events[*cursor].input;
+}
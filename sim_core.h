@@ -0,0 +1,71 @@
+/*
+ * Snow-Pi Simulation Core Header
+ * Author: /x64/dumped
+ */
+
+#ifndef SIM_CORE_H
+#define SIM_CORE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "sensor_channels.h"
+
+#define SIM_STEP_MS 33                 // Fixed step, close to the old 30 fps tick so filter tuning holds
+#define SIM_MAX_FRAME_MS 250           // Longer frames are dropped, not caught up
+#define SIM_SCRIPT_MAX_EVENTS 256
+
+// Driver controls for one step
+typedef struct {
+    float throttle_target;   // 0..1; the throttle ramps toward it
+    float steer;             // -1 (left) .. 1 (right)
+    bool reverse;
+} SimInput;
+
+// Vehicle model state - what the sensors measure before filtering
+typedef struct {
+    float throttle;
+    float target_rpm;
+    float speed;             // MPH, negative in reverse
+    float rpm;
+    float engine_temp;
+    float coolant_temp;
+    float belt_temp;
+    float fuel_level;
+    float voltage;
+    double latitude;
+    double longitude;
+    float heading;           // Degrees clockwise from north
+    double step_miles;       // Distance covered by the last step
+} SimState;
+
+typedef struct {
+    SimState prev;           // State before the last step, for render interpolation
+    SimState curr;
+    uint32_t accumulator_ms;
+    uint64_t time_ms;        // Simulated time
+    uint64_t steps;
+    uint32_t rng;            // xorshift32, so runs are reproducible
+} SimCore;
+
+// Scripted input changes for headless runs
+typedef struct {
+    uint32_t at_ms;
+    SimInput input;          // Full input from this time on
+} SimScriptEvent;
+
+typedef struct {
+    SimScriptEvent events[SIM_SCRIPT_MAX_EVENTS];
+    int count;
+    uint32_t end_ms;
+} SimScript;
+
+void sim_core_init(SimCore *sim, double latitude, double longitude, uint32_t seed);
+int sim_core_accumulate(SimCore *sim, uint32_t elapsed_ms);
+const SimState *sim_core_step(SimCore *sim, const SimInput *input);
+void sim_core_sample(SimCore *sim, float raw[SENSOR_CHANNEL_COUNT]);
+float sim_core_alpha(const SimCore *sim);
+
+bool sim_script_load(SimScript *script, const char *path);
+const SimInput *sim_script_input(const SimScript *script, uint64_t time_ms, int *cursor);
+
+#endif
@@ -0,0 +1,235 @@
+/*
+ * Snow-Pi Shared-Memory Telemetry - Seqlock publisher
+ * Author: /x64/dumped
+ * GitHub: @Ma110w
+ *
+ * Publishes one TelemetrySample per sensor tick into POSIX shared memory.
+ * The writer never waits on readers: it bumps the sequence to odd, copies
+ * the sample, bumps it to even, and only issues a futex wake when a
+ * reader has asked for one since the last publish. The request is
+ * cleared by each wake, so a reader that dies asleep costs one at most.
+ */
+
+#define _GNU_SOURCE
+
+#include "telemetry_shm.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/futex.h>
+
+static long futex(uint32_t *addr, int op, uint32_t val, const struct timespec *timeout) {
+    // Not FUTEX_PRIVATE: waiters live in other processes
+    return syscall(SYS_futex, addr, op, val, timeout, NULL, 0);
+}
+
+// The one-word wake request segment, writable by every reader
+static uint32_t *telemetry_wake_map(int flags) {
+    int fd = shm_open(TELEMETRY_WAKE_NAME, flags, 0666);
+    if (fd < 0) return NULL;
+    // The umask would keep readers running as other users out
+    if ((flags & O_CREAT) && (fchmod(fd, 0666) != 0 || ftruncate(fd, sizeof(uint32_t)) != 0)) {
+        close(fd);
+        return NULL;
+    }
+    void *mem = mmap(NULL, sizeof(uint32_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);  // The mapping keeps the segment alive
+    return mem == MAP_FAILED ? NULL : mem;
+}
+
+bool telemetry_shm_create(TelemetryPublisher *pub) {
+    pub->block = NULL;
+    pub->wake = telemetry_wake_map(O_CREAT | O_RDWR);
+    if (!pub->wake) {
+        fprintf(stderr, "Cannot create telemetry wake segment %s\n", TELEMETRY_WAKE_NAME);
+        pub->fd = -1;
+        return false;
+    }
+    pub->fd = shm_open(TELEMETRY_SHM_NAME, O_CREAT | O_RDWR, 0644);
+    if (pub->fd < 0) {
+        fprintf(stderr, "Cannot create telemetry shared memory %s\n", TELEMETRY_SHM_NAME);
+        return false;
+    }
+
+    if (ftruncate(pub->fd, sizeof(TelemetryBlock)) != 0) {
+        fprintf(stderr, "Cannot size telemetry shared memory\n");
+        close(pub->fd);
+        pub->fd = -1;
+        return false;
+    }
+
+    void *mem = mmap(NULL, sizeof(TelemetryBlock), PROT_READ | PROT_WRITE, MAP_SHARED, pub->fd, 0);
+    if (mem == MAP_FAILED) {
+        fprintf(stderr, "Cannot map telemetry shared memory\n");
+        close(pub->fd);
+        pub->fd = -1;
+        return false;
+    }
+
+    // Readers check the magic last, so publish the header before it
+    pub->block = mem;
+    memset(pub->block, 0, sizeof(TelemetryBlock));
+    pub->block->version = TELEMETRY_VERSION;
+    pub->block->header_size = (uint16_t)offsetof(TelemetryBlock, sample);
+    pub->block->sample_size = sizeof(TelemetrySample);
+    __atomic_store_n(&pub->block->magic, TELEMETRY_MAGIC, __ATOMIC_RELEASE);
+    return true;
+}
+
+void telemetry_shm_publish(TelemetryPublisher *pub, const TelemetrySample *sample) {
+    TelemetryBlock *block = pub->block;
+    if (!block) return;
+
+    uint32_t seq = __atomic_load_n(&block->seq, __ATOMIC_RELAXED);
+    __atomic_store_n(&block->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);  // Odd sequence is visible before any sample byte
+    memcpy(&block->sample, sample, sizeof(*sample));
+    __atomic_store_n(&block->seq, seq + 2, __ATOMIC_RELEASE);
+
+    // The new sequence is visible before the request is taken, so a reader
+    // that asks after this either is woken or sees the change and skips the sleep
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_exchange_n(pub->wake, 0, __ATOMIC_SEQ_CST)) {
+        futex(&block->seq, FUTEX_WAKE, INT_MAX, NULL);
+    }
+}
+
+void telemetry_shm_destroy(TelemetryPublisher *pub) {
+    if (pub->block) {
+        munmap(pub->block, sizeof(TelemetryBlock));
+        pub->block = NULL;
+    }
+    if (pub->fd >= 0) {
+        close(pub->fd);
+        pub->fd = -1;
+        shm_unlink(TELEMETRY_SHM_NAME);
+    }
+    if (pub->wake) {
+        munmap(pub->wake, sizeof(uint32_t));
+        pub->wake = NULL;
+        shm_unlink(TELEMETRY_WAKE_NAME);
+    }
+}
+
+bool telemetry_shm_open_reader(TelemetryReader *reader) {
+    reader->block = NULL;
+    reader->wake = NULL;
+    reader->fd = shm_open(TELEMETRY_SHM_NAME, O_RDONLY, 0);
+    if (reader->fd < 0) return false;
+
+    void *mem = mmap(NULL, sizeof(TelemetryBlock), PROT_READ, MAP_SHARED, reader->fd, 0);
+    if (mem == MAP_FAILED) {
+        close(reader->fd);
+        reader->fd = -1;
+        return false;
+    }
+
+    const TelemetryBlock *block = mem;
+    if (__atomic_load_n(&block->magic, __ATOMIC_ACQUIRE) != TELEMETRY_MAGIC ||
+        block->version != TELEMETRY_VERSION ||
+        block->sample_size != sizeof(TelemetrySample)) {
+        fprintf(stderr, "Telemetry block layout mismatch\n");
+        munmap(mem, sizeof(TelemetryBlock));
+        close(reader->fd);
+        reader->fd = -1;
+        return false;
+    }
+
+    reader->wake = telemetry_wake_map(O_RDWR);
+    if (!reader->wake) {
+        fprintf(stderr, "Cannot open telemetry wake segment %s\n", TELEMETRY_WAKE_NAME);
+        munmap(mem, sizeof(TelemetryBlock));
+        close(reader->fd);
+        reader->fd = -1;
+        return false;
+    }
+    reader->block = block;
+    return true;
+}
+
+// Zero-copy read: read fields straight from the returned pointer, then call
+// telemetry_shm_retry(seq); if it returns true the fields may be torn.
+// NULL when the writer stays mid-copy, e.g. it died inside the memcpy.
+const TelemetrySample *telemetry_shm_begin(const TelemetryReader *reader, uint32_t *seq) {
+    for (int spin = 0; spin < TELEMETRY_READ_SPINS; spin++) {
+        uint32_t s = __atomic_load_n(&reader->block->seq, __ATOMIC_ACQUIRE);
+        if (!(s & 1u)) {
+            *seq = s;
+            return &reader->block->sample;
+        }
+        // Writer mid-copy; a live one finishes within a memcpy
+    }
+    return NULL;
+}
+
+bool telemetry_shm_retry(const TelemetryReader *reader, uint32_t seq) {
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&reader->block->seq, __ATOMIC_RELAXED) != seq;
+}
+
+// Consistent copy of the latest sample and its sequence number. False if
+// the writer is stuck mid-copy or keeps tearing every attempt.
+bool telemetry_shm_read(const TelemetryReader *reader, TelemetrySample *out, uint32_t *seq) {
+    for (int attempt = 0; attempt < TELEMETRY_READ_ATTEMPTS; attempt++) {
+        const TelemetrySample *sample = telemetry_shm_begin(reader, seq);
+        if (!sample) return false;
+        memcpy(out, sample, sizeof(*out));
+        if (!telemetry_shm_retry(reader, *seq)) return true;
+    }
+    return false;
+}
+
+// Sleep until the sequence moves past last_seq. Returns false on timeout.
+bool telemetry_shm_wait(const TelemetryReader *reader, uint32_t last_seq, int timeout_ms) {
+    const TelemetryBlock *block = reader->block;
+    uint32_t seq = __atomic_load_n(&block->seq, __ATOMIC_ACQUIRE);
+    if (seq != last_seq && !(seq & 1u)) return true;
+
+    // Ask for a wake, then sleep only if seq is still what was read; the
+    // futex word only has to be readable
+    struct timespec timeout = {timeout_ms / 1000, (timeout_ms % 1000) * 1000000L};
+    __atomic_store_n(reader->wake, 1, __ATOMIC_SEQ_CST);
+    futex((uint32_t *)&block->seq, FUTEX_WAIT, seq, &timeout);
+
+    seq = __atomic_load_n(&block->seq, __ATOMIC_ACQUIRE);
+    return seq != last_seq;
+}
+
+void telemetry_shm_close_reader(TelemetryReader *reader) {
+    if (reader->wake) {
+        munmap(reader->wake, sizeof(uint32_t));
+        reader->wake = NULL;
+    }
+    if (reader->block) {
+        munmap((void *)reader->block, sizeof(TelemetryBlock));
+        reader->block = NULL;
+    }
+    if (reader->fd >= 0) {
+        close(reader->fd);
+        reader->fd = -1;
+    }
+}
+
+#else
+
+// No POSIX shared memory on Windows builds; telemetry is disabled
+bool telemetry_shm_create(TelemetryPublisher *pub) { pub->block = NULL; pub->wake = NULL; pub->fd = -1; return false; }
+void telemetry_shm_publish(TelemetryPublisher *pub, const TelemetrySample *sample) { (void)pub; (void)sample; }
+void telemetry_shm_destroy(TelemetryPublisher *pub) { (void)pub; }
+bool telemetry_shm_open_reader(TelemetryReader *reader) { reader->block = NULL; reader->wake = NULL; reader->fd = -1; return false; }
+const TelemetrySample *telemetry_shm_begin(const TelemetryReader *reader, uint32_t *seq) { (void)reader; *seq = 0; return NULL; }
+bool telemetry_shm_retry(const TelemetryReader *reader, uint32_t seq) { (void)reader; (void)seq; return false; }
+bool telemetry_shm_read(const TelemetryReader *reader, TelemetrySample *out, uint32_t *seq) { (void)reader; memset(out, 0, sizeof(*out)); *seq = 0; return false; }
+bool telemetry_shm_wait(const TelemetryReader *reader, uint32_t last_seq, int timeout_ms) { (void)reader; (void)last_seq; (void)timeout_ms; return false; }
+void telemetry_shm_close_reader(TelemetryReader *reader) { (void)reader; }
+
+#endif
@@ -0,0 +1,93 @@
+/*
+ * Snow-Pi Shared-Memory Telemetry Header
+ * Author: /x64/dumped
+ *
+ * Fixed-layout block other processes map read-only to follow the latest
+ * sample. Sleeping readers raise a flag in a separate one-word segment
+ * that any local user may write; the worst a stray write can do there
+ * is cost the dashboard a needless wake:
+ *
+ *     TelemetryReader reader;
+ *     if (telemetry_shm_open_reader(&reader)) {
+ *         TelemetrySample sample;
+ *         uint32_t seq = 0;
+ *         while (telemetry_shm_wait(&reader, seq, 1000)) {
+ *             if (!telemetry_shm_read(&reader, &sample, &seq)) break;  // Publisher stuck mid-write
+ *             ...
+ *         }
+ *     }
+ */
+
+#ifndef TELEMETRY_SHM_H
+#define TELEMETRY_SHM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define TELEMETRY_SHM_NAME "/snow-pi-telemetry"
+#define TELEMETRY_WAKE_NAME "/snow-pi-telemetry-wake"
+#define TELEMETRY_MAGIC 0x54495053u  // "SPIT"
+#define TELEMETRY_VERSION 2
+#define TELEMETRY_READ_SPINS 100000   // Polls of an odd seq before a reader gives up on the writer
+#define TELEMETRY_READ_ATTEMPTS 16    // Torn copies telemetry_shm_read retries
+
+// One sensor tick. Layout is part of the ABI: append fields, bump the version.
+typedef struct {
+    uint64_t tick;
+    uint64_t timestamp_ns;
+    float speed;           // MPH, negative in reverse
+    float rpm;
+    float throttle;        // 0.0 to 1.0
+    float engine_temp;     // F
+    float coolant_temp;
+    float belt_temp;
+    float fuel_level;      // Percent
+    float voltage;
+    double odometer;       // Miles
+    double trip_a;
+    double trip_b;
+    double engine_hours;
+    double latitude;
+    double longitude;
+    uint32_t warnings;     // WarningId bitmask
+    uint8_t drive_mode;
+    uint8_t display_mode;
+    uint8_t reserved[2];
+} TelemetrySample;
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_size;
+    uint32_t sample_size;
+    uint32_t seq;          // Seqlock counter, odd while a write is in progress; also the futex word
+    uint32_t reserved[4];
+    TelemetrySample sample;
+} TelemetryBlock;
+
+typedef struct {
+    TelemetryBlock *block;
+    uint32_t *wake;        // Non-zero: a reader is waiting to be woken
+    int fd;
+} TelemetryPublisher;
+
+typedef struct {
+    const TelemetryBlock *block;
+    uint32_t *wake;
+    int fd;
+} TelemetryReader;
+
+// Publisher (dashboard side)
+bool telemetry_shm_create(TelemetryPublisher *pub);
+void telemetry_shm_publish(TelemetryPublisher *pub, const TelemetrySample *sample);
+void telemetry_shm_destroy(TelemetryPublisher *pub);
+
+// Readers (companion processes)
+bool telemetry_shm_open_reader(TelemetryReader *reader);
+const TelemetrySample *telemetry_shm_begin(const TelemetryReader *reader, uint32_t *seq);
+bool telemetry_shm_retry(const TelemetryReader *reader, uint32_t seq);
+bool telemetry_shm_read(const TelemetryReader *reader, TelemetrySample *out, uint32_t *seq);
+bool telemetry_shm_wait(const TelemetryReader *reader, uint32_t last_seq, int timeout_ms);
+void telemetry_shm_close_reader(TelemetryReader *reader);
+
+#endif
@@ -0,0 +1,137 @@
+/*
+ * Snow-Pi Texture Registry - Budgeted GPU memory
+ * Author: /x64/dumped
+ * GitHub: @Ma110w
+ *
+ * Every long-lived texture is created through the registry, which tracks
+ * its size and category against one global budget. When a new texture
+ * would go over budget (or the GPU refuses it), the least recently used
+ * texture of the cheapest category is destroyed and its owner notified.
+ * Textures drawn this frame are never evicted.
+ */
+
+#include "texture_registry.h"
+#include <stdio.h>
+#include <string.h>
+
+const char *const TEXTURE_CATEGORY_NAMES[TEXTURE_CATEGORY_COUNT] = {
+    "tile", "layer", "glyphs", "static"
+};
+
+void texture_registry_init(TextureRegistry *reg, SDL_Renderer *renderer, size_t budget_bytes) {
+    memset(reg, 0, sizeof(*reg));
+    reg->renderer = renderer;
+    reg->budget = budget_bytes;
+    for (int i = 0; i < TEXTURE_REGISTRY_MAX; i++) {
+        reg->free_list[i] = TEXTURE_REGISTRY_MAX - 1 - i;
+    }
+    reg->free_count = TEXTURE_REGISTRY_MAX;
+    dash_metrics.texture_budget_bytes = budget_bytes;
+}
+
+static void entry_release(TextureRegistry *reg, int handle) {
+    TextureEntry *e = &reg->entries[handle];
+    SDL_DestroyTexture(e->texture);
+    reg->used -= e->bytes;
+    reg->category_bytes[e->category] -= e->bytes;
+    reg->category_count[e->category]--;
+    memset(e, 0, sizeof(*e));
+    reg->free_list[reg->free_count++] = handle;
+}
+
+// Evict the least recently used texture of one category.
+// Returns false if nothing in that category can go.
+bool texture_registry_evict(TextureRegistry *reg, TextureCategory category) {
+    int victim = -1;
+    for (int i = 0; i < TEXTURE_REGISTRY_MAX; i++) {
+        const TextureEntry *e = &reg->entries[i];
+        if (!e->texture || e->category != category || !e->on_evict || e->last_used == reg->frame) continue;
+        if (victim < 0 || e->last_used < reg->entries[victim].last_used) victim = i;
+    }
+    if (victim < 0) return false;
+
+    TextureEntry evicted = reg->entries[victim];
+    entry_release(reg, victim);
+    reg->evictions++;
+    evicted.on_evict(evicted.owner, evicted.item);
+    return true;
+}
+
+// Evict in category order until `bytes` more fit the budget
+static bool make_room(TextureRegistry *reg, size_t bytes) {
+    for (int c = 0; c < TEXTURE_CATEGORY_COUNT; c++) {
+        while (reg->used + bytes > reg->budget) {
+            if (!texture_registry_evict(reg, (TextureCategory)c)) break;
+        }
+    }
+    return reg->used + bytes <= reg->budget;
+}
+
+static bool evict_any(TextureRegistry *reg) {
+    for (int c = 0; c < TEXTURE_CATEGORY_COUNT; c++) {
+        if (texture_registry_evict(reg, (TextureCategory)c)) return true;
+    }
+    return false;
+}
+
+// Create and register a texture. Returns the handle, or -1 on failure.
+// If everything evictable is in use the budget is exceeded rather than
+// failing the draw; the overshoot shows up in the peak.
+int texture_registry_create(TextureRegistry *reg, SDL_PixelFormat format, SDL_TextureAccess access, int w, int h,
+                            TextureCategory category, TextureEvictFn on_evict, void *owner, void *item,
+                            SDL_Texture **out) {
+    *out = NULL;
+    size_t bytes = (size_t)w * (size_t)h * SDL_BYTESPERPIXEL(format);
+    make_room(reg, bytes);
+    if (reg->free_count == 0 && !evict_any(reg)) return -1;
+
+    SDL_Texture *texture = SDL_CreateTexture(reg->renderer, format, access, w, h);
+    // GPU memory can run out before the budget does; shed textures and retry
+    while (!texture && evict_any(reg)) {
+        texture = SDL_CreateTexture(reg->renderer, format, access, w, h);
+    }
+    if (!texture) {
+        reg->create_failures++;
+        fprintf(stderr, "Texture %dx%d (%s) failed: %s\n", w, h, TEXTURE_CATEGORY_NAMES[category], SDL_GetError());
+        return -1;
+    }
+
+    int handle = reg->free_list[--reg->free_count];
+    TextureEntry *e = &reg->entries[handle];
+    e->texture = texture;
+    e->bytes = bytes;
+    e->category = category;
+    e->last_used = reg->frame;
+    e->on_evict = on_evict;
+    e->owner = owner;
+    e->item = item;
+
+    reg->used += bytes;
+    if (reg->used > reg->peak) reg->peak = reg->used;
+    reg->category_bytes[category] += bytes;
+    reg->category_count[category]++;
+    *out = texture;
+    return handle;
+}
+
+// Owner-initiated release; no eviction callback
+void texture_registry_destroy(TextureRegistry *reg, int handle) {
+    if (handle < 0 || !reg->entries[handle].texture) return;
+    entry_release(reg, handle);
+}
+
+// Advance the LRU clock and publish usage
+void texture_registry_frame_end(TextureRegistry *reg) {
+    reg->frame++;
+    for (int c = 0; c < TEXTURE_CATEGORY_COUNT; c++) {
+        dash_metrics.texture_bytes[c] = reg->category_bytes[c];
+    }
+    dash_metrics.texture_peak_bytes = reg->peak;
+    dash_metrics.texture_evictions = reg->evictions;
+}
+
+void texture_registry_cleanup(TextureRegistry *reg) {
+    for (int i = 0; i < TEXTURE_REGISTRY_MAX; i++) {
+        if (reg->entries[i].texture) entry_release(reg, i);
+    }
+}
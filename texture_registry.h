@@ -0,0 +1,73 @@
+/*
+ * Snow-Pi Texture Registry Header
+ * Author: /x64/dumped
+ */
+
+#ifndef TEXTURE_REGISTRY_H
+#define TEXTURE_REGISTRY_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "metrics.h"
+
+#define TEXTURE_REGISTRY_MAX 512    // Enough for every tile pool full at once
+#define TEXTURE_BUDGET_DEFAULT_MB 96   // Full map pools (~77 MB) plus the screen textures
+
+// Eviction order: lower categories go first
+typedef enum {
+    TEXTURE_TILE,       // Decoded map tiles, cheap to reload
+    TEXTURE_LAYER,      // Cached composites and overlays, rebuilt on demand
+    TEXTURE_GLYPHS,     // Font atlas, re-uploaded from the binary
+    TEXTURE_STATIC,     // Long-lived layers, evicted last
+    TEXTURE_CATEGORY_COUNT
+} TextureCategory;
+
+_Static_assert(TEXTURE_CATEGORY_COUNT == METRICS_TEXTURE_CATEGORIES, "metrics texture categories out of sync");
+
+// Called after the registry destroys an evicted texture so the owner drops its pointer
+typedef void (*TextureEvictFn)(void *owner, void *item);
+
+typedef struct {
+    SDL_Texture *texture;      // NULL = free entry
+    size_t bytes;
+    TextureCategory category;
+    uint64_t last_used;        // Frame number of the last touch
+    TextureEvictFn on_evict;   // NULL = never evicted
+    void *owner;
+    void *item;
+} TextureEntry;
+
+typedef struct {
+    SDL_Renderer *renderer;
+    TextureEntry entries[TEXTURE_REGISTRY_MAX];
+    int free_list[TEXTURE_REGISTRY_MAX];
+    int free_count;
+    size_t budget;
+    size_t used;
+    size_t peak;
+    size_t category_bytes[TEXTURE_CATEGORY_COUNT];
+    int category_count[TEXTURE_CATEGORY_COUNT];
+    uint64_t frame;
+    uint64_t evictions;
+    uint64_t create_failures;
+} TextureRegistry;
+
+extern const char *const TEXTURE_CATEGORY_NAMES[TEXTURE_CATEGORY_COUNT];
+
+void texture_registry_init(TextureRegistry *reg, SDL_Renderer *renderer, size_t budget_bytes);
+int texture_registry_create(TextureRegistry *reg, SDL_PixelFormat format, SDL_TextureAccess access, int w, int h,
+                            TextureCategory category, TextureEvictFn on_evict, void *owner, void *item,
+                            SDL_Texture **out);
+void texture_registry_destroy(TextureRegistry *reg, int handle);
+bool texture_registry_evict(TextureRegistry *reg, TextureCategory category);
+void texture_registry_frame_end(TextureRegistry *reg);
+void texture_registry_cleanup(TextureRegistry *reg);
+
+// Mark a texture as used this frame; it will not be evicted until the next frame
+static inline void texture_registry_touch(TextureRegistry *reg, int handle) {
+    if (handle >= 0) reg->entries[handle].last_used = reg->frame;
+}
+
+#endif
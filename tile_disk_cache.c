@@ -0,0 +1,270 @@
+/*
+ * Snow-Pi Tile Disk Cache - Decoded tiles kept across restarts
+ * Author: /x64/dumped
+ * GitHub: @Ma110w
+ *
+ * Tiles are stored already decoded, in the texture's own pixel format,
+ * in fixed slots of a file that is mapped at startup. After a restart a
+ * cached tile goes from the mapping straight into SDL_UpdateTexture with
+ * no SQLite read or decompression. Writes happen on a low-priority
+ * thread: a slot is marked as being written and synced before its pixels
+ * change, and only marked valid once they are synced, so a power cut
+ * mid-write costs the tile but never shows a torn one.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "tile_disk_cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static uint32_t tile_disk_set(const TileDiskCache *cache, uint64_t key) {
+    uint32_t sets = cache->header->slot_count / TILE_DISK_CACHE_WAYS;
+    return (uint32_t)((key * 0x9E3779B97F4A7C15ull) >> 32) % sets;
+}
+
+// Sync a range of the mapping; msync wants a page-aligned start
+static void tile_disk_sync(TileDiskCache *cache, const void *start, size_t length) {
+    uintptr_t addr = (uintptr_t)start;
+    uintptr_t page = addr & ~(uintptr_t)(cache->page_size - 1);
+    msync((void *)page, length + (addr - page), MS_SYNC);
+}
+
+static int tile_disk_writer(void *data) {
+    TileDiskCache *cache = data;
+    SDL_SetCurrentThreadPriority(SDL_THREAD_PRIORITY_LOW);
+    for (;;) {
+        SDL_WaitSemaphore(cache->wake);
+        while (SDL_GetAtomicInt(&cache->tail) != SDL_GetAtomicInt(&cache->head)) {
+            int tail = SDL_GetAtomicInt(&cache->tail);
+            TileDiskJob *job = &cache->queue[tail % TILE_DISK_CACHE_QUEUE];
+            TileDiskSlot *slot = &cache->slots[job->slot];
+            uint8_t *dst = cache->pixels + (size_t)job->slot * cache->header->slot_bytes;
+
+            // The slot reads as being written on disk before its pixels change
+            tile_disk_sync(cache, slot, sizeof(*slot));
+            memcpy(dst, job->pixels, job->size);
+            tile_disk_sync(cache, dst, job->size);
+            // Dropped meanwhile: the key was cleared, so the slot never matches
+            SDL_CompareAndSwapAtomicInt(&slot->state, TILE_DISK_WRITING, TILE_DISK_VALID);
+            SDL_SetAtomicInt(&cache->tail, tail + 1);
+        }
+        if (SDL_GetAtomicInt(&cache->stop)) break;
+    }
+    return 0;
+}
+
+// Map the cache file, creating or resizing it when it does not match
+bool tile_disk_cache_open(TileDiskCache *cache, const char *path, size_t max_bytes) {
+    memset(cache, 0, sizeof(*cache));
+    cache->page_size = (size_t)sysconf(_SC_PAGESIZE);
+    uint32_t slot_count = (uint32_t)(max_bytes / TILE_DISK_CACHE_SLOT_BYTES) / TILE_DISK_CACHE_WAYS *
+                          TILE_DISK_CACHE_WAYS;
+    if (slot_count == 0) return false;
+    size_t table_offset = cache->page_size;
+    size_t pixels_offset = table_offset + slot_count * sizeof(TileDiskSlot);
+    pixels_offset = (pixels_offset + cache->page_size - 1) / cache->page_size * cache->page_size;
+    size_t size = pixels_offset + (size_t)slot_count * TILE_DISK_CACHE_SLOT_BYTES;
+
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "Cannot open tile cache %s\n", path);
+        return false;
+    }
+    struct stat st;
+    bool fresh = fstat(fd, &st) != 0 || (size_t)st.st_size != size;
+    // Sparse: nothing is written to the card until tiles are stored
+    if (fresh && (ftruncate(fd, 0) != 0 || ftruncate(fd, (off_t)size) != 0)) {
+        fprintf(stderr, "Cannot size tile cache %s\n", path);
+        close(fd);
+        return false;
+    }
+    void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);  // The mapping keeps the file alive
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "Cannot map tile cache %s\n", path);
+        return false;
+    }
+    cache->map = map;
+    cache->size = size;
+    cache->header = map;
+    cache->slots = (TileDiskSlot *)(cache->map + table_offset);
+    cache->pixels = cache->map + pixels_offset;
+
+    TileDiskHeader *h = cache->header;
+    if (fresh || memcmp(h->magic, TILE_DISK_CACHE_MAGIC, sizeof(h->magic)) != 0 ||
+        h->version != TILE_DISK_CACHE_VERSION || h->header_size != sizeof(TileDiskHeader) ||
+        h->slot_count != slot_count || h->slot_bytes != TILE_DISK_CACHE_SLOT_BYTES ||
+        h->table_offset != table_offset || h->pixels_offset != pixels_offset) {
+        memset(h, 0, sizeof(*h));
+        memset(cache->slots, 0, slot_count * sizeof(TileDiskSlot));
+        memcpy(h->magic, TILE_DISK_CACHE_MAGIC, sizeof(h->magic));
+        h->version = TILE_DISK_CACHE_VERSION;
+        h->header_size = sizeof(TileDiskHeader);
+        h->slot_count = slot_count;
+        h->slot_bytes = TILE_DISK_CACHE_SLOT_BYTES;
+        h->table_offset = table_offset;
+        h->pixels_offset = pixels_offset;
+    }
+
+    // Writes cut off by the last power-down never finished
+    uint32_t warm = 0;
+    for (uint32_t i = 0; i < slot_count; i++) {
+        TileDiskSlot *slot = &cache->slots[i];
+        if (SDL_GetAtomicInt(&slot->state) != TILE_DISK_VALID) {
+            slot->key = 0;
+            SDL_SetAtomicInt(&slot->state, TILE_DISK_EMPTY);
+        } else if (slot->key) {
+            warm++;
+        }
+    }
+
+    for (int i = 0; i < TILE_DISK_CACHE_QUEUE; i++) {
+        cache->queue[i].pixels = malloc(TILE_DISK_CACHE_SLOT_BYTES);
+        if (!cache->queue[i].pixels) {
+            tile_disk_cache_close(cache);
+            return false;
+        }
+    }
+    cache->wake = SDL_CreateSemaphore(0);
+    cache->writer = cache->wake ? SDL_CreateThread(tile_disk_writer, "tile-cache", cache) : NULL;
+    if (!cache->writer) {
+        fprintf(stderr, "Cannot start tile cache writer: %s\n", SDL_GetError());
+        tile_disk_cache_close(cache);
+        return false;
+    }
+    printf("Tile cache %s: %u of %u tiles warm\n", path, warm, slot_count);
+    return true;
+}
+
+// Drop a source's tiles when its file is not the one they were decoded from
+void tile_disk_cache_check_source(TileDiskCache *cache, int source, const char *path) {
+    if (!cache->map || source < 0 || source >= TILE_DISK_CACHE_SOURCES) return;
+    struct stat st;
+    TileDiskSource now = {0, 0};
+    if (stat(path, &st) == 0) {
+        now.size = (uint64_t)st.st_size;
+        now.mtime = (int64_t)st.st_mtime;
+    }
+    TileDiskSource *seen = &cache->header->sources[source];
+    if (seen->size == now.size && seen->mtime == now.mtime) return;
+
+    for (uint32_t i = 0; i < cache->header->slot_count; i++) {
+        TileDiskSlot *slot = &cache->slots[i];
+        if (slot->key && ((slot->key >> 56) & 0x7F) == (uint64_t)source) {
+            slot->key = 0;
+            SDL_SetAtomicInt(&slot->state, TILE_DISK_EMPTY);
+        }
+    }
+    // The cleared slots reach the card before the new stamp does, or a
+    // power cut in between would vouch for tiles of the old file
+    tile_disk_sync(cache, cache->slots, (size_t)cache->header->slot_count * sizeof(TileDiskSlot));
+    *seen = now;
+    tile_disk_sync(cache, seen, sizeof(*seen));
+}
+
+// Pixels of a stored tile, read through the mapping, or NULL
+const void *tile_disk_cache_find(TileDiskCache *cache, uint64_t key, SDL_PixelFormat format) {
+    if (!cache->map) return NULL;
+    uint32_t first = tile_disk_set(cache, key) * TILE_DISK_CACHE_WAYS;
+    for (uint32_t i = first; i < first + TILE_DISK_CACHE_WAYS; i++) {
+        TileDiskSlot *slot = &cache->slots[i];
+        if (slot->key == key && slot->format == (uint32_t)format &&
+            SDL_GetAtomicInt(&slot->state) == TILE_DISK_VALID) {
+            return cache->pixels + (size_t)i * cache->header->slot_bytes;
+        }
+    }
+    return NULL;
+}
+
+// Queue a decoded tile for the writer. Dropped when the queue is full;
+// it is simply stored the next time it is decoded.
+void tile_disk_cache_put(TileDiskCache *cache, uint64_t key, SDL_PixelFormat format, const void *pixels, size_t size) {
+    if (!cache->map || size > TILE_DISK_CACHE_SLOT_BYTES) return;
+    int head = SDL_GetAtomicInt(&cache->head);
+    if (head - SDL_GetAtomicInt(&cache->tail) >= TILE_DISK_CACHE_QUEUE) return;
+
+    // An empty way, else the oldest valid one; slots still being written are skipped
+    uint32_t first = tile_disk_set(cache, key) * TILE_DISK_CACHE_WAYS;
+    TileDiskSlot *victim = NULL;
+    for (uint32_t i = first; i < first + TILE_DISK_CACHE_WAYS; i++) {
+        TileDiskSlot *slot = &cache->slots[i];
+        int state = SDL_GetAtomicInt(&slot->state);
+        if (slot->key == key && state != TILE_DISK_EMPTY) return;  // Stored or on its way
+        if (victim && SDL_GetAtomicInt(&victim->state) == TILE_DISK_EMPTY) continue;
+        if (state == TILE_DISK_EMPTY ||
+            (state == TILE_DISK_VALID && (!victim || (int32_t)(slot->stamp - victim->stamp) < 0))) {
+            victim = slot;
+        }
+    }
+    if (!victim) return;
+
+    SDL_SetAtomicInt(&victim->state, TILE_DISK_WRITING);
+    victim->key = key;
+    victim->format = (uint32_t)format;
+    victim->stamp = ++cache->header->stamp;
+    TileDiskJob *job = &cache->queue[head % TILE_DISK_CACHE_QUEUE];
+    job->slot = (uint32_t)(victim - cache->slots);
+    job->size = (uint32_t)size;
+    memcpy(job->pixels, pixels, size);
+    SDL_SetAtomicInt(&cache->head, head + 1);
+    SDL_SignalSemaphore(cache->wake);
+}
+
+// The tile changed in its source
+void tile_disk_cache_drop(TileDiskCache *cache, uint64_t key) {
+    if (!cache->map) return;
+    uint32_t first = tile_disk_set(cache, key) * TILE_DISK_CACHE_WAYS;
+    for (uint32_t i = first; i < first + TILE_DISK_CACHE_WAYS; i++) {
+        TileDiskSlot *slot = &cache->slots[i];
+        if (slot->key != key) continue;
+        slot->key = 0;
+        // A pending write still finishes, but under a key nothing asks for
+        SDL_CompareAndSwapAtomicInt(&slot->state, TILE_DISK_VALID, TILE_DISK_EMPTY);
+        tile_disk_sync(cache, slot, sizeof(*slot));  // The old pixels must not come back after a restart
+    }
+}
+
+// Finishes queued writes; dirty pages reach the card in the background
+void tile_disk_cache_close(TileDiskCache *cache) {
+    if (cache->writer) {
+        SDL_SetAtomicInt(&cache->stop, 1);
+        SDL_SignalSemaphore(cache->wake);
+        SDL_WaitThread(cache->writer, NULL);
+    }
+    if (cache->wake) SDL_DestroySemaphore(cache->wake);
+    for (int i = 0; i < TILE_DISK_CACHE_QUEUE; i++) free(cache->queue[i].pixels);
+    if (cache->map) munmap(cache->map, cache->size);
+    memset(cache, 0, sizeof(*cache));
+}
+
+#else
+
+// No mmap on Windows builds; every start decodes from the databases
+bool tile_disk_cache_open(TileDiskCache *cache, const char *path, size_t max_bytes) {
+    (void)path;
+    (void)max_bytes;
+    memset(cache, 0, sizeof(*cache));
+    return false;
+}
+void tile_disk_cache_check_source(TileDiskCache *cache, int source, const char *path) {
+    (void)cache; (void)source; (void)path;
+}
+const void *tile_disk_cache_find(TileDiskCache *cache, uint64_t key, SDL_PixelFormat format) {
+    (void)cache; (void)key; (void)format;
+    return NULL;
+}
+void tile_disk_cache_put(TileDiskCache *cache, uint64_t key, SDL_PixelFormat format, const void *pixels, size_t size) {
+    (void)cache; (void)key; (void)format; (void)pixels; (void)size;
+}
+void tile_disk_cache_drop(TileDiskCache *cache, uint64_t key) { (void)cache; (void)key; }
+void tile_disk_cache_close(TileDiskCache *cache) { memset(cache, 0, sizeof(*cache)); }
+
+#endif
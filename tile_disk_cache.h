@@ -0,0 +1,89 @@
+/*
+ * Snow-Pi Tile Disk Cache Header
+ * Author: /x64/dumped
+ */
+
+#ifndef TILE_DISK_CACHE_H
+#define TILE_DISK_CACHE_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define TILE_DISK_CACHE_PATH "snow-pi-tiles.cache"
+#define TILE_DISK_CACHE_MAGIC "SPTILES1"
+#define TILE_DISK_CACHE_VERSION 1
+#define TILE_DISK_CACHE_BYTES (64 * 1024 * 1024)      // Pixel slots on disk (256 tiles)
+#define TILE_DISK_CACHE_SLOT_BYTES (256 * 256 * 4)    // One tile at up to 32 bpp
+#define TILE_DISK_CACHE_WAYS 4                        // Slots a key may live in
+#define TILE_DISK_CACHE_QUEUE 4                       // Tiles waiting for the writer
+#define TILE_DISK_CACHE_SOURCES 4
+
+// (source, zoom, x, y) with the top bit set, so a cleared key never matches
+#define TILE_DISK_KEY(source, z, x, y) ((1ull << 63) | ((uint64_t)(source) << 56) | ((uint64_t)(z) << 48) | \
+                                        ((uint64_t)(x) << 24) | (uint64_t)(y))
+
+typedef enum {
+    TILE_DISK_EMPTY,
+    TILE_DISK_WRITING,           // Queued; pixels not on disk yet
+    TILE_DISK_VALID
+} TileDiskState;
+
+// The file a source's tiles were decoded from; a change drops them
+typedef struct {
+    uint64_t size;
+    int64_t mtime;
+} TileDiskSource;
+
+// On-disk layout: this header, the slot table, then page-aligned pixels
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t slot_count;
+    uint32_t slot_bytes;
+    uint64_t table_offset;
+    uint64_t pixels_offset;
+    uint32_t stamp;              // Bumped per stored tile; the oldest in a set is replaced
+    uint32_t reserved;
+    TileDiskSource sources[TILE_DISK_CACHE_SOURCES];
+} TileDiskHeader;
+
+typedef struct {
+    uint64_t key;                // TILE_DISK_KEY, 0 when empty
+    uint32_t format;             // SDL_PixelFormat of the pixels
+    uint32_t stamp;
+    SDL_AtomicInt state;         // TileDiskState
+    uint32_t reserved;
+} TileDiskSlot;
+
+typedef struct {
+    uint32_t slot;
+    uint32_t size;
+    uint8_t *pixels;             // TILE_DISK_CACHE_SLOT_BYTES
+} TileDiskJob;
+
+typedef struct {
+    uint8_t *map;                // NULL when the cache is unavailable
+    size_t size;
+    size_t page_size;
+    TileDiskHeader *header;
+    TileDiskSlot *slots;
+    uint8_t *pixels;
+    SDL_Thread *writer;
+    SDL_Semaphore *wake;
+    SDL_AtomicInt head;          // Jobs queued by the main thread
+    SDL_AtomicInt tail;          // Jobs the writer has finished
+    SDL_AtomicInt stop;
+    TileDiskJob queue[TILE_DISK_CACHE_QUEUE];
+} TileDiskCache;
+
+bool tile_disk_cache_open(TileDiskCache *cache, const char *path, size_t max_bytes);
+void tile_disk_cache_check_source(TileDiskCache *cache, int source, const char *path);
+const void *tile_disk_cache_find(TileDiskCache *cache, uint64_t key, SDL_PixelFormat format);
+void tile_disk_cache_put(TileDiskCache *cache, uint64_t key, SDL_PixelFormat format, const void *pixels, size_t size);
+void tile_disk_cache_drop(TileDiskCache *cache, uint64_t key);
+void tile_disk_cache_close(TileDiskCache *cache);
+
+#endif
@@ -0,0 +1,247 @@
+/*
+ * Snow-Pi Tile Pack - Route corridor tiles held in RAM
+ * Author: /x64/dumped
+ * GitHub: @Ma110w
+ *
+ * Before a ride the tiles along a GPX route (or around the last saved
+ * position) are worked out for a few zoom levels and read in one pass,
+ * in the order the MBTiles index stores them, into a single buffer with
+ * a sorted key table. Lookups along the route then never touch the SD
+ * card mid-ride.
+ */
+
+#include "tile_pack.h"
+#include <math.h>
+#include <sqlite3.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define TILE_PACK_EARTH_M 40075016.686
+
+// Read <trkpt> and <rtept> positions from a GPX file as lat, lon pairs
+bool tile_pack_load_route(const char *path, double **points, int *point_count) {
+    *points = NULL;
+    *point_count = 0;
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "Cannot open route %s\n", path);
+        return false;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *text = size > 0 ? malloc((size_t)size + 1) : NULL;
+    if (!text || fread(text, 1, (size_t)size, f) != (size_t)size) {
+        fprintf(stderr, "Cannot read route %s\n", path);
+        free(text);
+        fclose(f);
+        return false;
+    }
+    fclose(f);
+    text[size] = '\0';
+
+    int capacity = 0;
+    for (char *p = text; (p = strchr(p, '<')) != NULL; p++) {
+        if (strncmp(p, "<trkpt", 6) != 0 && strncmp(p, "<rtept", 6) != 0) continue;
+        char *end = strchr(p, '>');
+        if (!end) break;
+        *end = '\0';  // Attributes are only searched inside this tag
+        char *lat = strstr(p, "lat=");
+        char *lon = strstr(p, "lon=");
+        if (lat && lon) {
+            if (*point_count == capacity) {
+                capacity = capacity ? capacity * 2 : 1024;
+                double *grown = realloc(*points, (size_t)capacity * 2 * sizeof(double));
+                if (!grown) break;
+                *points = grown;
+            }
+            (*points)[*point_count * 2] = atof(lat + 5);  // Skip lat=" (either quote)
+            (*points)[*point_count * 2 + 1] = atof(lon + 5);
+            (*point_count)++;
+        }
+        p = end;
+    }
+    free(text);
+    if (*point_count == 0) {
+        fprintf(stderr, "No track or route points in %s\n", path);
+        free(*points);
+        *points = NULL;
+        return false;
+    }
+    return true;
+}
+
+static int key_compare(const void *a, const void *b) {
+    uint64_t ka = *(const uint64_t *)a, kb = *(const uint64_t *)b;
+    return ka < kb ? -1 : ka > kb;
+}
+
+typedef struct {
+    uint64_t *keys;
+    uint32_t count;
+} KeyList;
+
+// Sort and drop duplicates; neighbouring samples overlap heavily
+static void key_list_compact(KeyList *list) {
+    qsort(list->keys, list->count, sizeof(uint64_t), key_compare);
+    uint32_t kept = 0;
+    for (uint32_t k = 0; k < list->count; k++) {
+        if (kept == 0 || list->keys[k] != list->keys[kept - 1]) list->keys[kept++] = list->keys[k];
+    }
+    list->count = kept;
+}
+
+// Every tile within radius_tiles of (tx, ty), in fractional tile units
+static bool corridor_add_disc(KeyList *list, int zoom, double tx, double ty, double radius_tiles) {
+    int n = 1 << zoom;
+    int r = (int)ceil(radius_tiles);
+    for (int dy = -r; dy <= r; dy++) {
+        int y = (int)floor(ty) + dy;
+        if (y < 0 || y >= n) continue;
+        for (int dx = -r; dx <= r; dx++) {
+            int x = (int)floor(tx) + dx;
+            // Nearest point of the tile to the centre
+            double nx = fmax(x, fmin(tx, x + 1.0)) - tx;
+            double ny = fmax(y, fmin(ty, y + 1.0)) - ty;
+            if (nx * nx + ny * ny > radius_tiles * radius_tiles) continue;
+            if (list->count == TILE_PACK_MAX_TILES) {
+                key_list_compact(list);
+                if (list->count == TILE_PACK_MAX_TILES) return false;
+            }
+            list->keys[list->count++] = TILE_PACK_KEY(zoom, (x % n + n) % n, n - 1 - y);
+        }
+    }
+    return true;
+}
+
+// Tiles within corridor_m / 2 of the route at each pack zoom, sorted in
+// database order without duplicates. A single point gets a disc of
+// TILE_PACK_START_RADIUS_M instead. Returns the number of keys.
+uint32_t tile_pack_corridor(const double *points, int point_count, double corridor_m, uint64_t **keys) {
+    KeyList list = {malloc(TILE_PACK_MAX_TILES * sizeof(uint64_t)), 0};
+    *keys = list.keys;
+    if (!list.keys || point_count <= 0) return 0;
+    double radius_m = point_count == 1 ? TILE_PACK_START_RADIUS_M : corridor_m / 2.0;
+
+    bool full = false;
+    for (int zoom = TILE_PACK_MIN_ZOOM; zoom <= TILE_PACK_MAX_ZOOM && !full; zoom++) {
+        double n = (double)(1 << zoom);
+        double prev_x = 0, prev_y = 0;
+        for (int i = 0; i < point_count && !full; i++) {
+            double lat = points[i * 2], lon = points[i * 2 + 1];
+            double lat_rad = lat * M_PI / 180.0;
+            double tx = (lon + 180.0) / 360.0 * n;
+            double ty = (1.0 - log(tan(lat_rad) + 1.0 / cos(lat_rad)) / M_PI) / 2.0 * n;
+            double radius_tiles = radius_m / (TILE_PACK_EARTH_M * cos(lat_rad) / n);
+            // Sample each leg every half tile so no tile under it is skipped
+            int steps = i == 0 ? 1 : (int)ceil(hypot(tx - prev_x, ty - prev_y) * 2.0);
+            for (int s = 1; s <= steps && !full; s++) {
+                double t = i == 0 ? 1.0 : (double)s / steps;
+                full = !corridor_add_disc(&list, zoom, prev_x + (tx - prev_x) * t, prev_y + (ty - prev_y) * t,
+                                          radius_tiles);
+            }
+            prev_x = tx;
+            prev_y = ty;
+        }
+    }
+
+    key_list_compact(&list);
+    if (full) printf("Route corridor truncated at %d tiles\n", TILE_PACK_MAX_TILES);
+    return list.count;
+}
+
+// Read the keyed tiles from an MBTiles file into a new pack. Each column
+// is one range scan, so the file is read front to back.
+TilePack *tile_pack_read(const char *path, const uint64_t *keys, uint32_t key_count, size_t max_bytes,
+                         SDL_AtomicInt *stop) {
+    sqlite3 *db = NULL;
+    sqlite3_stmt *stmt = NULL;
+    TilePack *pack = calloc(1, sizeof(TilePack));
+    if (!pack || !(pack->entries = malloc((key_count ? key_count : 1) * sizeof(TilePackEntry))) ||
+        sqlite3_open_v2(path, &db, SQLITE_OPEN_READONLY, NULL) != SQLITE_OK ||
+        sqlite3_prepare_v2(db, "SELECT tile_row, tile_data FROM tiles WHERE zoom_level = ?1 AND tile_column = ?2 "
+                               "AND tile_row BETWEEN ?3 AND ?4 ORDER BY tile_row", -1, &stmt, NULL) != SQLITE_OK) {
+        sqlite3_close(db);
+        tile_pack_free(pack);
+        return NULL;
+    }
+
+    size_t capacity = 0;
+    bool full = false;
+    uint32_t k = 0;
+    while (k < key_count && !full && !SDL_GetAtomicInt(stop)) {
+        // Keys sharing a zoom and column
+        uint64_t column = keys[k] >> 24;
+        uint32_t last = k;
+        while (last + 1 < key_count && keys[last + 1] >> 24 == column) last++;
+        sqlite3_bind_int(stmt, 1, (int)(column >> 24));
+        sqlite3_bind_int(stmt, 2, (int)(column & 0xFFFFFF));
+        sqlite3_bind_int(stmt, 3, (int)(keys[k] & 0xFFFFFF));
+        sqlite3_bind_int(stmt, 4, (int)(keys[last] & 0xFFFFFF));
+
+        uint32_t want = k;
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            uint64_t key = (column << 24) | (uint32_t)sqlite3_column_int(stmt, 0);
+            while (want <= last && keys[want] < key) want++;
+            if (want > last) break;
+            if (keys[want] != key) continue;  // In the range but off the corridor
+
+            int length = sqlite3_column_bytes(stmt, 1);
+            const void *blob = sqlite3_column_blob(stmt, 1);
+            if (pack->data_size + (size_t)length > max_bytes) {
+                full = true;
+                break;
+            }
+            if (pack->data_size + (size_t)length > capacity) {
+                size_t grown_size = capacity ? capacity * 2 : 1024 * 1024;
+                while (grown_size < pack->data_size + (size_t)length) grown_size *= 2;
+                if (grown_size > max_bytes) grown_size = max_bytes;
+                uint8_t *grown = realloc(pack->data, grown_size);
+                if (!grown) {
+                    full = true;
+                    break;
+                }
+                pack->data = grown;
+                capacity = grown_size;
+            }
+            memcpy(pack->data + pack->data_size, blob, (size_t)length);
+            TilePackEntry *entry = &pack->entries[pack->count++];
+            entry->key = key;
+            entry->offset = (uint32_t)pack->data_size;
+            entry->length = (uint32_t)length;
+            pack->data_size += (size_t)length;
+        }
+        sqlite3_reset(stmt);
+        k = last + 1;
+    }
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+    if (full) printf("Tile pack for %s stopped at %.1f MB\n", path, max_bytes / (1024.0 * 1024.0));
+    return pack;
+}
+
+bool tile_pack_find(const TilePack *pack, int zoom, int tile_x, int tms_y, const void **blob, int *size) {
+    uint64_t key = TILE_PACK_KEY(zoom, tile_x, tms_y);
+    uint32_t lo = 0, hi = pack->count;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        if (pack->entries[mid].key < key) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo == pack->count || pack->entries[lo].key != key) return false;
+    *blob = pack->data + pack->entries[lo].offset;
+    *size = (int)pack->entries[lo].length;
+    return true;
+}
+
+void tile_pack_free(TilePack *pack) {
+    if (!pack) return;
+    free(pack->entries);
+    free(pack->data);
+    free(pack);
+}
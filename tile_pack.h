@@ -0,0 +1,45 @@
+/*
+ * Snow-Pi Tile Pack Header
+ * Author: /x64/dumped
+ */
+
+#ifndef TILE_PACK_H
+#define TILE_PACK_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define TILE_PACK_MIN_ZOOM 10
+#define TILE_PACK_MAX_ZOOM 14
+#define TILE_PACK_CORRIDOR_M 2000.0        // Default corridor width along a route
+#define TILE_PACK_START_RADIUS_M 10000.0   // Area around the last position when there is no route
+#define TILE_PACK_MAX_TILES 65536          // Corridor tiles considered, lowest zooms first
+#define TILE_PACK_MAX_BYTES (48 * 1024 * 1024)
+
+// Key order is (zoom, column, TMS row): the order MBTiles stores tiles in
+#define TILE_PACK_KEY(z, x, tms_y) (((uint64_t)(z) << 48) | ((uint64_t)(x) << 24) | (uint64_t)(tms_y))
+
+typedef struct {
+    uint64_t key;
+    uint32_t offset;             // Into data
+    uint32_t length;
+} TilePackEntry;
+
+// Tile blobs read ahead of time; never changed once published
+typedef struct {
+    TilePackEntry *entries;      // Sorted by key
+    uint32_t count;
+    uint8_t *data;
+    size_t data_size;
+} TilePack;
+
+bool tile_pack_load_route(const char *path, double **points, int *point_count);
+uint32_t tile_pack_corridor(const double *points, int point_count, double corridor_m, uint64_t **keys);
+TilePack *tile_pack_read(const char *path, const uint64_t *keys, uint32_t key_count, size_t max_bytes,
+                         SDL_AtomicInt *stop);
+bool tile_pack_find(const TilePack *pack, int zoom, int tile_x, int tms_y, const void **blob, int *size);
+void tile_pack_free(TilePack *pack);
+
+#endif
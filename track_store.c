@@ -0,0 +1,239 @@
+/*
+ * Snow-Pi Track Store - Breadcrumb trail with per-zoom detail levels
+ * Author: /x64/dumped
+ * GitHub: @Ma110w
+ *
+ * Every fix is simplified online into TRACK_LEVELS buffers, one per zoom
+ * band, with a sleeve (sector bound) test that costs O(1) per point and
+ * keeps the line within TRACK_TOLERANCE_PX of the raw track. Points are
+ * grouped into runs by bucket tile so drawing only walks the visible
+ * ones. A full level is re-simplified and its tolerance doubled, so
+ * memory is fixed however long the ride.
+ */
+
+#include "track_store.h"
+#include <math.h>
+#include <string.h>
+#include "metrics.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define TRACK_WORLD 4294967296.0   // Fixed-point units across the world
+#define TRACK_BUCKET_SHIFT 3       // Buckets are 8x8 tiles at the level's zoom
+
+static const int TRACK_LEVEL_ZOOM[TRACK_LEVELS] = {16, 13, 10, 7};
+
+void track_store_init(TrackStore *track) {
+    memset(track, 0, sizeof(*track));
+    for (int i = 0; i < TRACK_LEVELS; i++) {
+        TrackLevel *level = &track->levels[i];
+        level->zoom = TRACK_LEVEL_ZOOM[i];
+        level->bucket_zoom = level->zoom - TRACK_BUCKET_SHIFT;
+        level->tolerance = TRACK_TOLERANCE_PX * TRACK_WORLD / (256.0 * (double)(1 << level->zoom));
+    }
+}
+
+static TrackPoint track_project(double latitude, double longitude) {
+    double lat_rad = latitude * M_PI / 180.0;
+    double x = (longitude + 180.0) / 360.0;
+    double y = (1.0 - log(tan(lat_rad) + 1.0 / cos(lat_rad)) / M_PI) / 2.0;
+    x = x < 0 ? 0 : (x > 1 ? 1 : x);
+    y = y < 0 ? 0 : (y > 1 ? 1 : y);
+    TrackPoint p = {(uint32_t)fmin(x * TRACK_WORLD, TRACK_WORLD - 1), (uint32_t)fmin(y * TRACK_WORLD, TRACK_WORLD - 1)};
+    return p;
+}
+
+static void track_bucket(const TrackLevel *level, TrackPoint p, int32_t *bx, int32_t *by) {
+    int shift = 32 - level->bucket_zoom;
+    *bx = (int32_t)(p.x >> shift);
+    *by = (int32_t)(p.y >> shift);
+}
+
+// Point i was just stored: extend the newest run or start one in its bucket
+static void track_add_to_run(TrackLevel *level, uint32_t i) {
+    int32_t bx, by;
+    track_bucket(level, level->points[i], &bx, &by);
+    TrackRun *run = level->run_count ? &level->runs[level->run_count - 1] : NULL;
+    if (run && run->bucket_x == bx && run->bucket_y == by) {
+        run->count++;
+    } else {
+        run = &level->runs[level->run_count++];
+        run->first = i > 0 ? i - 1 : 0;
+        run->count = i > 0 ? 2 : 1;
+        run->bucket_x = bx;
+        run->bucket_y = by;
+    }
+}
+
+// Feed p to the sleeve that starts at anchor. Returns true with *kept set
+// when the previous point has to be kept; the caller stores it and feeds
+// p again from it as the new anchor.
+static bool track_sleeve_push(TrackSleeve *sleeve, TrackPoint anchor, double tolerance, TrackPoint p,
+                              TrackPoint *kept) {
+    double dx = (double)p.x - anchor.x;
+    double dy = (double)p.y - anchor.y;
+    double dist = sqrt(dx * dx + dy * dy);
+    if (sleeve->has_cone) {
+        // Heading back toward the anchor ends the sleeve, or an out-and-back
+        // would collapse into the anchor and its first step
+        if (dist >= sleeve->pending_dist) {
+            // Compare in the cone's frame so angles don't wrap
+            double angle = atan2(dy, dx);
+            double half = asin(tolerance / dist);
+            double mid = (sleeve->cone_lo + sleeve->cone_hi) * 0.5;
+            double rel = mid + remainder(angle - mid, 2.0 * M_PI);
+            if (rel >= sleeve->cone_lo && rel <= sleeve->cone_hi) {
+                sleeve->cone_lo = fmax(sleeve->cone_lo, rel - half);
+                sleeve->cone_hi = fmin(sleeve->cone_hi, rel + half);
+                sleeve->pending = p;
+                sleeve->pending_dist = dist;
+                return false;
+            }
+        }
+        *kept = sleeve->pending;
+        memset(sleeve, 0, sizeof(*sleeve));
+        return true;
+    }
+
+    sleeve->pending = p;
+    sleeve->pending_dist = dist;
+    sleeve->has_pending = true;
+    if (dist > tolerance) {
+        // Too close to constrain the direction until now
+        double angle = atan2(dy, dx);
+        double half = asin(tolerance / dist);
+        sleeve->cone_lo = angle - half;
+        sleeve->cone_hi = angle + half;
+        sleeve->has_cone = true;
+    }
+    return false;
+}
+
+// Simplify points[0 .. count) in place against tolerance, keeping both
+// ends. Each input writes at most one point at or before its own index.
+static uint32_t track_simplify(TrackPoint *points, uint32_t count, double tolerance) {
+    if (count <= 2) return count;
+    TrackSleeve sleeve;
+    memset(&sleeve, 0, sizeof(sleeve));
+    uint32_t kept = 1;
+    for (uint32_t i = 1; i < count; i++) {
+        TrackPoint p = points[i], k;
+        if (track_sleeve_push(&sleeve, points[kept - 1], tolerance, p, &k)) {
+            points[kept++] = k;
+            track_sleeve_push(&sleeve, k, tolerance, p, &k);
+        }
+    }
+    points[kept++] = sleeve.pending;  // The newest point is the live sleeve's anchor
+    return kept;
+}
+
+// Full level: re-simplify what it holds and double the tolerance. The
+// points are already within tolerance of the raw track, so simplifying
+// them by the same amount again keeps them within the doubled one.
+static void track_thin(TrackLevel *level) {
+    do {
+        level->count = track_simplify(level->points, level->count, level->tolerance);
+        level->tolerance *= 2.0;
+    } while (level->count > TRACK_LEVEL_POINTS * 3 / 4);
+    level->run_count = 0;
+    for (uint32_t i = 0; i < level->count; i++) track_add_to_run(level, i);
+}
+
+static void track_commit(TrackLevel *level, TrackPoint p) {
+    if (level->count == TRACK_LEVEL_POINTS) track_thin(level);
+    level->points[level->count] = p;
+    track_add_to_run(level, level->count++);
+}
+
+static void track_level_push(TrackLevel *level, TrackPoint p) {
+    if (level->count == 0) {
+        track_commit(level, p);
+        return;
+    }
+    TrackPoint kept;
+    if (track_sleeve_push(&level->sleeve, level->points[level->count - 1], level->tolerance, p, &kept)) {
+        track_commit(level, kept);
+        track_sleeve_push(&level->sleeve, kept, level->tolerance, p, &kept);  // A fresh sleeve never ends
+    }
+}
+
+void track_store_push(TrackStore *track, double latitude, double longitude) {
+    TrackPoint p = track_project(latitude, longitude);
+    const TrackLevel *finest = &track->levels[0];
+    TrackPoint last = finest->sleeve.has_pending ? finest->sleeve.pending :
+                      (finest->count ? finest->points[finest->count - 1] : (TrackPoint){0, 0});
+    if ((finest->count || finest->sleeve.has_pending) && last.x == p.x && last.y == p.y) return;  // Standing still
+    track->pushed++;
+    for (int i = 0; i < TRACK_LEVELS; i++) {
+        track_level_push(&track->levels[i], p);
+    }
+}
+
+uint32_t track_store_point_count(const TrackStore *track) {
+    uint32_t total = 0;
+    for (int i = 0; i < TRACK_LEVELS; i++) total += track->levels[i].count;
+    return total;
+}
+
+static SDL_FPoint track_to_screen(const MapView *view, double scale, TrackPoint p) {
+    // World pixels at the view zoom, then the map's own offset and rotation
+    float dx = (float)(p.x * scale - view->world_x) - view->pivot_x;
+    float dy = (float)(p.y * scale - view->world_y) - view->pivot_y;
+    SDL_FPoint s = {view->pivot_x + dx * view->cos_a - dy * view->sin_a,
+                    view->pivot_y + dx * view->sin_a + dy * view->cos_a};
+    return s;
+}
+
+// Draw the visible part of the track as line strips over the map
+void track_store_draw(const TrackStore *track, SDL_Renderer *renderer, FrameArena *arena, const MapView *view,
+                      int screen_width, int screen_height) {
+    if (!view->valid) return;
+
+    // Coarsest level still within a pixel of the raw track at this zoom
+    int li = TRACK_LEVELS - 1;
+    for (int i = 0; i < TRACK_LEVELS; i++) {
+        if (TRACK_LEVEL_ZOOM[i] <= view->zoom + 1) {
+            li = i;
+            break;
+        }
+    }
+    const TrackLevel *level = &track->levels[li];
+    if (level->count == 0) return;
+
+    // Buckets under a circle around the pivot cover the screen at any rotation
+    double scale = ldexp(1.0, view->zoom + 8 - 32);  // Fixed point to world pixels
+    double radius = sqrt((double)screen_width * screen_width + (double)screen_height * screen_height) / 2.0;
+    double cx = view->world_x + view->pivot_x, cy = view->world_y + view->pivot_y;
+    double bucket_px = 256.0 * ldexp(1.0, view->zoom - level->bucket_zoom);
+    int32_t bx0 = (int32_t)floor((cx - radius) / bucket_px) - 1, bx1 = (int32_t)floor((cx + radius) / bucket_px) + 1;
+    int32_t by0 = (int32_t)floor((cy - radius) / bucket_px) - 1, by1 = (int32_t)floor((cy + radius) / bucket_px) + 1;
+
+    size_t mark = frame_arena_mark(arena);
+    SDL_FPoint *strip = frame_arena_alloc(arena, (level->count + 1) * sizeof(SDL_FPoint));
+    if (!strip) return;
+
+    SDL_SetRenderDrawColor(renderer, 255, 180, 0, 255);
+    int n = 0;
+    uint32_t next = UINT32_MAX;  // Index the current strip continues from
+    for (uint32_t r = 0; r < level->run_count; r++) {
+        const TrackRun *run = &level->runs[r];
+        if (run->bucket_x < bx0 || run->bucket_x > bx1 || run->bucket_y < by0 || run->bucket_y > by1) continue;
+        uint32_t i = run->first;
+        if (run->first != next) {
+            if (n >= 2) SDL_RenderLines(renderer, strip, n);
+            n = 0;
+        } else {
+            i++;  // Shared with the end of the previous run
+        }
+        for (; i < run->first + run->count; i++) strip[n++] = track_to_screen(view, scale, level->points[i]);
+        next = run->first + run->count - 1;
+    }
+    // The live end of the line runs up to the newest fix
+    if (next == level->count - 1 && level->sleeve.has_pending) {
+        strip[n++] = track_to_screen(view, scale, level->sleeve.pending);
+    }
+    if (n >= 2) SDL_RenderLines(renderer, strip, n);
+    frame_arena_rewind(arena, mark);
+}
@@ -0,0 +1,68 @@
+/*
+ * Snow-Pi Track Store Header
+ * Author: /x64/dumped
+ */
+
+#ifndef TRACK_STORE_H
+#define TRACK_STORE_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "frame_memory.h"
+#include "map_viewer.h"
+
+#define TRACK_LEVELS 4             // Level L is simplified for zoom TRACK_LEVEL_ZOOM[L]
+#define TRACK_LEVEL_POINTS 16384   // Per level; a full level is thinned, never grown
+#define TRACK_TOLERANCE_PX 0.5     // Allowed deviation at the level's zoom
+
+// Fixed-point Web Mercator: the whole world is 2^32 units across
+typedef struct {
+    uint32_t x;
+    uint32_t y;
+} TrackPoint;
+
+// Consecutive points in one bucket tile. Each run starts with the last
+// point of the one before, so runs join into a continuous line.
+typedef struct {
+    uint32_t first;
+    uint32_t count;
+    int32_t bucket_x;
+    int32_t bucket_y;
+} TrackRun;
+
+// Sleeve simplification state: every point since the anchor lies within
+// tolerance of any line from the anchor inside [cone_lo, cone_hi], and
+// each was farther from the anchor than the one before
+typedef struct {
+    TrackPoint pending;        // Newest point, not yet committed
+    double pending_dist;       // Its distance from the anchor
+    bool has_pending;
+    bool has_cone;
+    double cone_lo;
+    double cone_hi;
+} TrackSleeve;
+
+typedef struct {
+    TrackPoint points[TRACK_LEVEL_POINTS];
+    TrackRun runs[TRACK_LEVEL_POINTS];
+    uint32_t count;
+    uint32_t run_count;
+    int zoom;                  // Zoom the tolerance is measured at
+    int bucket_zoom;           // Tile size of the buckets
+    double tolerance;          // World units; doubles each time the level is thinned
+    TrackSleeve sleeve;
+} TrackLevel;
+
+typedef struct {
+    TrackLevel levels[TRACK_LEVELS];
+    uint64_t pushed;           // Raw fixes received
+} TrackStore;
+
+void track_store_init(TrackStore *track);
+void track_store_push(TrackStore *track, double latitude, double longitude);
+void track_store_draw(const TrackStore *track, SDL_Renderer *renderer, FrameArena *arena, const MapView *view,
+                      int screen_width, int screen_height);
+uint32_t track_store_point_count(const TrackStore *track);
+
+#endif
@@ -0,0 +1,247 @@
+/*
+ * Snow-Pi Trail Index - Nearest-trail snapping and geofences
+ * Author: /x64/dumped
+ * GitHub: @Ma110w
+ *
+ * Queries the packed grid built offline by build-trail-index. The file is
+ * mapped read-only and used in place: a query looks at the few cells
+ * around the position, so it costs microseconds no matter how many
+ * thousand trail segments the province has.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "trail_index.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define METERS_PER_DEG_LAT 111320.0
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// A section must lie inside the file
+static bool section_ok(const TrailIndex *index, uint64_t offset, uint64_t count, size_t elem) {
+    return offset % 4 == 0 && offset <= index->size && count <= (index->size - offset) / elem;
+}
+
+// Cell offsets start at 0, never decrease and stay inside the refs, and
+// every ref names a real entry, so cell walks need no bounds checks
+static bool cell_table_ok(const uint32_t *offsets, uint64_t cells, const uint32_t *refs,
+                          uint32_t ref_count, uint32_t count) {
+    if (offsets[0] != 0) return false;
+    for (uint64_t i = 1; i < cells; i++) {
+        if (offsets[i] < offsets[i - 1] || offsets[i] > ref_count) return false;
+    }
+    for (uint32_t i = 0; i < ref_count; i++) {
+        if (refs[i] >= count) return false;
+    }
+    return true;
+}
+
+// Every node, edge and station reference stays inside the graph, so the
+// searches can follow them without checking
+static bool trail_graph_ok(const TrailIndex *index) {
+    const TrailIndexHeader *h = index->header;
+    if (index->node_edges[0] != 0) return false;
+    for (uint32_t i = 0; i < h->node_count; i++) {
+        if (index->node_edges[i + 1] < index->node_edges[i] || index->node_edges[i + 1] > h->edge_count) return false;
+    }
+    for (uint32_t i = 0; i < h->edge_count; i++) {
+        if (index->edges[i].target >= h->node_count || !(index->edges[i].length_m >= 0)) return false;
+    }
+    for (uint32_t i = 0; i < h->segment_count; i++) {
+        if (index->segment_nodes[i].from >= h->node_count || index->segment_nodes[i].to >= h->node_count) return false;
+    }
+    for (uint32_t i = 0; i < h->fuel_count; i++) {
+        if (index->fuel[i].node >= h->node_count) return false;
+    }
+    return true;
+}
+
+bool trail_index_open(TrailIndex *index, const char *path) {
+    memset(index, 0, sizeof(*index));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(TrailIndexHeader)) {
+        fprintf(stderr, "Trail index %s is truncated\n", path);
+        close(fd);
+        return false;
+    }
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);  // The mapping keeps the file alive
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "Cannot map trail index %s\n", path);
+        return false;
+    }
+    index->map = map;
+    index->size = (size_t)st.st_size;
+
+    const TrailIndexHeader *h = map;
+    uint64_t cells = (uint64_t)h->grid_w * h->grid_h + 1;
+    if (memcmp(h->magic, TRAIL_INDEX_MAGIC, sizeof(h->magic)) != 0 || h->version != TRAIL_INDEX_VERSION ||
+        h->header_size != sizeof(TrailIndexHeader) || h->grid_w == 0 || h->grid_h == 0 ||
+        !(h->cell_lat_deg > 0) || !(h->cell_lon_deg > 0) ||
+        !section_ok(index, h->segment_cells_offset, cells, sizeof(uint32_t)) ||
+        !section_ok(index, h->segment_refs_offset, h->segment_ref_count, sizeof(uint32_t)) ||
+        !section_ok(index, h->segments_offset, h->segment_count, sizeof(TrailSegment)) ||
+        !section_ok(index, h->area_cells_offset, cells, sizeof(uint32_t)) ||
+        !section_ok(index, h->area_refs_offset, h->area_ref_count, sizeof(uint32_t)) ||
+        !section_ok(index, h->areas_offset, h->area_count, sizeof(TrailArea)) ||
+        !section_ok(index, h->vertices_offset, h->vertex_count, sizeof(TrailVertex)) ||
+        !section_ok(index, h->nodes_offset, h->node_count, sizeof(TrailVertex)) ||
+        !section_ok(index, h->node_edges_offset, (uint64_t)h->node_count + 1, sizeof(uint32_t)) ||
+        !section_ok(index, h->edges_offset, h->edge_count, sizeof(TrailEdge)) ||
+        !section_ok(index, h->segment_nodes_offset, h->segment_count, sizeof(TrailSegmentNodes)) ||
+        !section_ok(index, h->fuel_offset, h->fuel_count, sizeof(TrailFuel))) {
+        fprintf(stderr, "Trail index %s is invalid or from another version\n", path);
+        trail_index_close(index);
+        return false;
+    }
+
+    index->header = h;
+    index->segment_cells = (const uint32_t *)(index->map + h->segment_cells_offset);
+    index->segment_refs = (const uint32_t *)(index->map + h->segment_refs_offset);
+    index->segments = (const TrailSegment *)(index->map + h->segments_offset);
+    index->area_cells = (const uint32_t *)(index->map + h->area_cells_offset);
+    index->area_refs = (const uint32_t *)(index->map + h->area_refs_offset);
+    index->areas = (const TrailArea *)(index->map + h->areas_offset);
+    index->vertices = (const TrailVertex *)(index->map + h->vertices_offset);
+    index->nodes = (const TrailVertex *)(index->map + h->nodes_offset);
+    index->node_edges = (const uint32_t *)(index->map + h->node_edges_offset);
+    index->edges = (const TrailEdge *)(index->map + h->edges_offset);
+    index->segment_nodes = (const TrailSegmentNodes *)(index->map + h->segment_nodes_offset);
+    index->fuel = (const TrailFuel *)(index->map + h->fuel_offset);
+    if (index->segment_cells[cells - 1] != h->segment_ref_count || index->area_cells[cells - 1] != h->area_ref_count ||
+        index->node_edges[h->node_count] != h->edge_count ||
+        !cell_table_ok(index->segment_cells, cells, index->segment_refs, h->segment_ref_count, h->segment_count) ||
+        !cell_table_ok(index->area_cells, cells, index->area_refs, h->area_ref_count, h->area_count)) {
+        fprintf(stderr, "Trail index %s has a damaged cell table\n", path);
+        trail_index_close(index);
+        return false;
+    }
+    if (!trail_graph_ok(index)) {
+        fprintf(stderr, "Trail index %s has a damaged trail graph\n", path);
+        trail_index_close(index);
+        return false;
+    }
+    return true;
+}
+
+void trail_index_close(TrailIndex *index) {
+    if (index->map) munmap((void *)index->map, index->size);
+    memset(index, 0, sizeof(*index));
+}
+
+#else
+
+// No mmap on Windows builds; snapping and geofences are disabled
+bool trail_index_open(TrailIndex *index, const char *path) { (void)path; memset(index, 0, sizeof(*index)); return false; }
+void trail_index_close(TrailIndex *index) { memset(index, 0, sizeof(*index)); }
+
+#endif
+
+// Nearest trail point within max_m. Distances use a local flat-earth
+// projection at the query latitude, exact enough at these ranges.
+bool trail_index_snap(const TrailIndex *index, double latitude, double longitude, float max_m, TrailSnap *snap) {
+    const TrailIndexHeader *h = index->header;
+    if (!h) return false;
+
+    double qx = longitude - h->origin_lon;
+    double qy = latitude - h->origin_lat;
+    float ky = (float)METERS_PER_DEG_LAT;
+    float kx = (float)(METERS_PER_DEG_LAT * cos(latitude * M_PI / 180.0));
+
+    // Every cell that can hold a segment within max_m
+    int col = (int)floor(qx / h->cell_lon_deg);
+    int row = (int)floor(qy / h->cell_lat_deg);
+    int rx = (int)ceil(max_m / (h->cell_lon_deg * kx));
+    int ry = (int)ceil(max_m / (h->cell_lat_deg * ky));
+    int c0 = col - rx < 0 ? 0 : col - rx;
+    int c1 = col + rx >= (int)h->grid_w ? (int)h->grid_w - 1 : col + rx;
+    int r0 = row - ry < 0 ? 0 : row - ry;
+    int r1 = row + ry >= (int)h->grid_h ? (int)h->grid_h - 1 : row + ry;
+
+    float best_d2 = max_m * max_m;
+    float best_x = 0, best_y = 0;
+    uint32_t best = UINT32_MAX;
+    for (int r = r0; r <= r1; r++) {
+        for (int c = c0; c <= c1; c++) {
+            uint32_t cell = (uint32_t)r * h->grid_w + (uint32_t)c;
+            for (uint32_t i = index->segment_cells[cell]; i < index->segment_cells[cell + 1]; i++) {
+                uint32_t s = index->segment_refs[i];
+                if (s >= h->segment_count) continue;
+                const TrailSegment *seg = &index->segments[s];
+                // Segment in metres relative to the query point
+                float ax = (float)(seg->x0 - qx) * kx, ay = (float)(seg->y0 - qy) * ky;
+                float bx = (float)(seg->x1 - qx) * kx, by = (float)(seg->y1 - qy) * ky;
+                float dx = bx - ax, dy = by - ay;
+                float len2 = dx * dx + dy * dy;
+                float t = len2 > 0 ? -(ax * dx + ay * dy) / len2 : 0.0f;
+                t = t < 0 ? 0 : (t > 1 ? 1 : t);
+                float px = ax + dx * t, py = ay + dy * t;
+                float d2 = px * px + py * py;
+                if (d2 < best_d2) {
+                    best_d2 = d2;
+                    best_x = px;
+                    best_y = py;
+                    best = s;
+                }
+            }
+        }
+    }
+    if (best == UINT32_MAX) return false;
+
+    snap->latitude = latitude + best_y / ky;
+    snap->longitude = longitude + best_x / kx;
+    snap->distance_m = sqrtf(best_d2);
+    snap->segment = best;
+    return true;
+}
+
+// Even-odd test across all rings; NaN vertices separate rings
+static bool area_contains(const TrailIndex *index, const TrailArea *area, float x, float y) {
+    if (x < area->min_x || x > area->max_x || y < area->min_y || y > area->max_y) return false;
+    if ((uint64_t)area->first_vertex + area->vertex_count > index->header->vertex_count) return false;
+    const TrailVertex *v = &index->vertices[area->first_vertex];
+    bool inside = false;
+    for (uint32_t i = 1; i < area->vertex_count; i++) {
+        const TrailVertex *a = &v[i - 1], *b = &v[i];
+        if (isnan(a->x) || isnan(b->x)) continue;
+        if ((a->y > y) != (b->y > y) && x < a->x + (y - a->y) * (b->x - a->x) / (b->y - a->y)) {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+// Kind of the first no-go area containing the position
+TrailAreaKind trail_index_area_at(const TrailIndex *index, double latitude, double longitude) {
+    const TrailIndexHeader *h = index->header;
+    if (!h) return TRAIL_AREA_NONE;
+
+    double qx = longitude - h->origin_lon;
+    double qy = latitude - h->origin_lat;
+    int col = (int)floor(qx / h->cell_lon_deg);
+    int row = (int)floor(qy / h->cell_lat_deg);
+    if (col < 0 || row < 0 || col >= (int)h->grid_w || row >= (int)h->grid_h) return TRAIL_AREA_NONE;
+
+    uint32_t cell = (uint32_t)row * h->grid_w + (uint32_t)col;
+    for (uint32_t i = index->area_cells[cell]; i < index->area_cells[cell + 1]; i++) {
+        uint32_t a = index->area_refs[i];
+        if (a < h->area_count && area_contains(index, &index->areas[a], (float)qx, (float)qy)) {
+            return (TrailAreaKind)index->areas[a].kind;
+        }
+    }
+    return TRAIL_AREA_NONE;
+}
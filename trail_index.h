@@ -0,0 +1,130 @@
+/*
+ * Snow-Pi Trail Index Header
+ * Author: /x64/dumped
+ */
+
+#ifndef TRAIL_INDEX_H
+#define TRAIL_INDEX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define TRAIL_INDEX_PATH "trails.idx"
+#define TRAIL_INDEX_MAGIC "SPTRAIL1"
+#define TRAIL_INDEX_VERSION 2        // 2 added the routing graph and fuel stations
+#define TRAIL_SNAP_MAX_M 250.0f     // Search radius; farther trails read as this distance
+#define TRAIL_SNAP_LOCK_M 30.0f     // Closer than this the map shows the trail position
+
+// Kinds of no-go area; anything but NONE trips the geofence warning
+typedef enum {
+    TRAIL_AREA_NONE,
+    TRAIL_AREA_MILITARY,
+    TRAIL_AREA_AIRFIELD,
+    TRAIL_AREA_NATURE_RESERVE
+} TrailAreaKind;
+
+// On-disk layout, written by build-trail-index and mapped read-only.
+// Coordinates are float degrees relative to the origin (x = lon, y = lat),
+// which keeps sub-metre precision across a province. Cell lists are CSR:
+// cell i owns refs [cells[i], cells[i + 1]). The routing graph is CSR
+// too: node i's edges are [node_edges[i], node_edges[i + 1]).
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    double origin_lat;
+    double origin_lon;
+    double cell_lat_deg;
+    double cell_lon_deg;
+    uint32_t grid_w;
+    uint32_t grid_h;
+    uint32_t segment_count;
+    uint32_t segment_ref_count;
+    uint32_t area_count;
+    uint32_t area_ref_count;
+    uint32_t vertex_count;
+    uint32_t reserved;
+    uint64_t segment_cells_offset;   // grid_w * grid_h + 1 uint32
+    uint64_t segment_refs_offset;    // uint32 segment numbers
+    uint64_t segments_offset;        // TrailSegment
+    uint64_t area_cells_offset;      // grid_w * grid_h + 1 uint32
+    uint64_t area_refs_offset;       // uint32 area numbers
+    uint64_t areas_offset;           // TrailArea
+    uint64_t vertices_offset;        // TrailVertex
+    uint32_t node_count;
+    uint32_t edge_count;             // Both directions of every trail piece
+    uint32_t fuel_count;
+    uint32_t reserved2;
+    uint64_t nodes_offset;           // TrailVertex per node
+    uint64_t node_edges_offset;      // node_count + 1 uint32
+    uint64_t edges_offset;           // TrailEdge
+    uint64_t segment_nodes_offset;   // TrailSegmentNodes per segment
+    uint64_t fuel_offset;            // TrailFuel
+} TrailIndexHeader;
+
+typedef struct {
+    float x0, y0, x1, y1;
+} TrailSegment;
+
+typedef struct {
+    float x, y;                      // NaN separates the rings of one area
+} TrailVertex;
+
+typedef struct {
+    uint32_t target;
+    float length_m;
+} TrailEdge;
+
+// Graph nodes at the ends of a snapping segment
+typedef struct {
+    uint32_t from;
+    uint32_t to;
+} TrailSegmentNodes;
+
+// A fuel station and the trail node it is reached from
+typedef struct {
+    uint32_t node;
+    float access_m;                  // Straight line from the node to the station
+    float x, y;
+} TrailFuel;
+
+typedef struct {
+    uint32_t first_vertex;
+    uint32_t vertex_count;
+    float min_x, min_y, max_x, max_y;
+    uint32_t kind;                   // TrailAreaKind
+    uint32_t reserved;
+} TrailArea;
+
+typedef struct {
+    const uint8_t *map;
+    size_t size;
+    const TrailIndexHeader *header;
+    const uint32_t *segment_cells;
+    const uint32_t *segment_refs;
+    const TrailSegment *segments;
+    const uint32_t *area_cells;
+    const uint32_t *area_refs;
+    const TrailArea *areas;
+    const TrailVertex *vertices;
+    const TrailVertex *nodes;
+    const uint32_t *node_edges;
+    const TrailEdge *edges;
+    const TrailSegmentNodes *segment_nodes;
+    const TrailFuel *fuel;
+} TrailIndex;
+
+typedef struct {
+    double latitude;                 // Nearest point on the nearest trail
+    double longitude;
+    float distance_m;
+    uint32_t segment;
+} TrailSnap;
+
+bool trail_index_open(TrailIndex *index, const char *path);
+void trail_index_close(TrailIndex *index);
+bool trail_index_snap(const TrailIndex *index, double latitude, double longitude, float max_m, TrailSnap *snap);
+TrailAreaKind trail_index_area_at(const TrailIndex *index, double latitude, double longitude);
+
+#endif
@@ -0,0 +1,83 @@
+/*
+ * Snow-Pi Warning Rules - Table-driven warning engine
+ * Author: /x64/dumped
+ * GitHub: @Ma110w
+ *
+ * Thresholds, hysteresis and debounce for every warning live in one table.
+ * Rules are compiled into flat arrays at startup and evaluated once per
+ * sensor tick into a bitmask that the renderer and logger read.
+ */
+
+#include "warning_rules.h"
+#include <stdio.h>
+#include <string.h>
+
+// Polaris thresholds
+const WarningRuleDef WARNING_RULE_TABLE[] = {
+    {SENSOR_ENGINE_TEMP,  RULE_ABOVE, 220.0f, 5.0f,  500,  WARN_SEVERITY_CRITICAL, "HIGH ENGINE TEMP"},
+    {SENSOR_COOLANT_TEMP, RULE_ABOVE, 210.0f, 5.0f,  500,  WARN_SEVERITY_CRITICAL, "HIGH COOLANT TEMP"},
+    {SENSOR_BELT_TEMP,    RULE_ABOVE, 180.0f, 5.0f,  500,  WARN_SEVERITY_CRITICAL, "BELT TEMP HIGH!"},  // Critical for belt life!
+    {SENSOR_BELT_TEMP,    RULE_ABOVE, 160.0f, 3.0f,  500,  WARN_SEVERITY_INFO,     "BELT TEMP RISING"},
+    {SENSOR_FUEL_LEVEL,   RULE_BELOW, 20.0f,  2.0f,  3000, WARN_SEVERITY_CAUTION,  "LOW FUEL"},  // Long debounce for slosh
+    {SENSOR_VOLTAGE,      RULE_BELOW, 12.5f,  0.2f,  2000, WARN_SEVERITY_CAUTION,  "LOW VOLTAGE"},
+    {SENSOR_TRAIL_DISTANCE, RULE_ABOVE, 50.0f, 10.0f, 5000, WARN_SEVERITY_CAUTION, "OFF TRAIL"},
+    {SENSOR_RESTRICTED_AREA, RULE_ABOVE, 0.5f, 0.25f, 1000, WARN_SEVERITY_CRITICAL, "RESTRICTED AREA"},
+};
+const int WARNING_RULE_TABLE_SIZE = sizeof(WARNING_RULE_TABLE) / sizeof(WARNING_RULE_TABLE[0]);
+
+bool warning_rules_compile(WarningRules *rules, const WarningRuleDef *defs, int count) {
+    memset(rules, 0, sizeof(*rules));
+    if (count > WARNING_MAX_RULES) {
+        fprintf(stderr, "Too many warning rules (%d, max %d)\n", count, WARNING_MAX_RULES);
+        return false;
+    }
+
+    for (int i = 0; i < count; i++) {
+        // BELOW rules are negated so every rule becomes "value > trip"
+        float sign = defs[i].compare == RULE_ABOVE ? 1.0f : -1.0f;
+        rules->channel[i] = (uint8_t)defs[i].channel;
+        rules->sign[i] = sign;
+        rules->trip[i] = sign * defs[i].threshold;
+        rules->clear[i] = sign * defs[i].threshold - defs[i].hysteresis;
+        rules->debounce_ms[i] = defs[i].debounce_ms;
+        rules->severity[i] = (uint8_t)defs[i].severity;
+        rules->message[i] = defs[i].message;
+
+        if (defs[i].severity >= WARN_SEVERITY_CAUTION) rules->overlay_mask |= WARNING_BIT(i);
+        if (defs[i].severity == WARN_SEVERITY_CRITICAL) rules->critical_mask |= WARNING_BIT(i);
+    }
+    rules->count = count;
+    return true;
+}
+
+// Raise after the condition holds for debounce_ms, clear once the value
+// recovers past the hysteresis band
+uint32_t warning_rules_evaluate(WarningRules *rules, const float *values, uint32_t dt_ms) {
+    uint32_t active = 0;
+
+    for (int i = 0; i < rules->count; i++) {
+        float v = rules->sign[i] * values[rules->channel[i]];
+        uint32_t over = v > rules->trip[i];
+        uint32_t recovered = v < rules->clear[i];
+        uint32_t was_active = (rules->active >> i) & 1u;
+
+        rules->held_ms[i] = over ? rules->held_ms[i] + dt_ms : 0;
+        uint32_t raise = rules->held_ms[i] >= rules->debounce_ms[i] && over;
+        uint32_t now_active = was_active ? !recovered : raise;
+
+        active |= now_active << i;
+    }
+
+    rules->active = active;
+    return active;
+}
+
+// Print raised and cleared warnings
+void warning_rules_log(const WarningRules *rules, uint32_t previous, uint32_t current) {
+    uint32_t changed = previous ^ current;
+    while (changed) {
+        int i = __builtin_ctz(changed);
+        changed &= changed - 1;
+        printf("Warning %s: %s\n", (current & WARNING_BIT(i)) ? "raised" : "cleared", rules->message[i]);
+    }
+}
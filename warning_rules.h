@@ -0,0 +1,73 @@
+/*
+ * Snow-Pi Warning Rules Header
+ * Author: /x64/dumped
+ */
+
+#ifndef WARNING_RULES_H
+#define WARNING_RULES_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "sensor_channels.h"
+
+#define WARNING_MAX_RULES 32  // One bit each in the warning mask
+#define WARNING_BIT(id) (1u << (id))
+
+typedef enum {
+    WARN_SEVERITY_INFO,      // Colors the reading, no overlay
+    WARN_SEVERITY_CAUTION,   // Amber overlay message
+    WARN_SEVERITY_CRITICAL   // Red overlay message
+} WarningSeverity;
+
+typedef enum {
+    RULE_ABOVE,
+    RULE_BELOW
+} RuleCompare;
+
+// Warning ids, in WARNING_RULE_TABLE order
+typedef enum {
+    WARN_ENGINE_TEMP,
+    WARN_COOLANT_TEMP,
+    WARN_BELT_TEMP,
+    WARN_BELT_TEMP_RISING,
+    WARN_LOW_FUEL,
+    WARN_LOW_VOLTAGE,
+    WARN_OFF_TRAIL,
+    WARN_RESTRICTED_AREA,
+    WARN_COUNT
+} WarningId;
+
+typedef struct {
+    SensorChannel channel;
+    RuleCompare compare;
+    float threshold;
+    float hysteresis;       // Distance back past threshold before clearing
+    uint32_t debounce_ms;   // Condition must hold this long before raising
+    WarningSeverity severity;
+    const char *message;
+} WarningRuleDef;
+
+// Rules compiled into flat arrays, evaluated once per sensor tick
+typedef struct {
+    int count;
+    uint8_t channel[WARNING_MAX_RULES];
+    float sign[WARNING_MAX_RULES];      // +1 for ABOVE, -1 for BELOW
+    float trip[WARNING_MAX_RULES];      // sign * threshold
+    float clear[WARNING_MAX_RULES];     // sign * threshold - hysteresis
+    uint32_t debounce_ms[WARNING_MAX_RULES];
+    uint32_t held_ms[WARNING_MAX_RULES];
+    uint8_t severity[WARNING_MAX_RULES];
+    const char *message[WARNING_MAX_RULES];
+    uint32_t active;         // Current warning mask
+    uint32_t overlay_mask;   // Rules that raise the full-screen overlay
+    uint32_t critical_mask;
+} WarningRules;
+
+extern const WarningRuleDef WARNING_RULE_TABLE[];
+extern const int WARNING_RULE_TABLE_SIZE;
+
+bool warning_rules_compile(WarningRules *rules, const WarningRuleDef *defs, int count);
+uint32_t warning_rules_evaluate(WarningRules *rules, const float *values, uint32_t dt_ms);
+void warning_rules_log(const WarningRules *rules, uint32_t previous, uint32_t current);
+
+#endif